@@ -51,4 +51,48 @@ enum Season
 };
 
 
+/** This enumeration identifies the numeric weather columns (parameters measured every day) such as temperature, pressure and
+humidity. You can use this enumeration to choose the column an analysis (statistics, graphs, filters) works with. */
+enum WeatherColumn
+{
+    TemperatureColumn = 1,
+    PressureColumn = 2,
+    HumidityColumn = 3
+};
+
+
+/** This enumeration identifies the weather columns derived from the measured ones (dew point, heat index, day-over-day
+pressure tendency and temperature anomaly). You can use this enumeration to draw, filter or sort by a derived quantity the
+same way as by a measured column. */
+enum DerivedColumn
+{
+    DewPointColumn = 1,
+    HeatIndexColumn = 2,
+    PressureTendencyColumn = 3,
+    TemperatureAnomalyColumn = 4
+};
+
+
+/** This enumeration identifies the calendar periods weather days are rolled up into, such as week, month, season and year.
+You can use this enumeration to choose the level of detail of reports and graphs over long ranges of weather data. */
+enum RollupPeriod
+{
+    WeekRollup = 0,
+    MonthRollup = 1,
+    SeasonRollup = 2,
+    YearRollup = 3
+};
+
+
+/** This enumeration identifies how analyses of consecutive days (periods of unchanged wind, stable weather) treat missing
+days, duplicate dates and days out of date order. You can use this enumeration to choose whether neighbouring rows are
+treated as neighbouring days, split into continuous segments, or completed by filled days first. */
+enum DayContinuity
+{
+    AssumeConsecutiveDays = 0,
+    SplitAtGaps = 1,
+    FillGaps = 2
+};
+
+
 #endif // WEATHERENUMS_H
@@ -0,0 +1,162 @@
+#ifndef ANALOGINDEX_H
+#define ANALOGINDEX_H
+
+#include "weatherview.h"
+
+
+/** @brief Index of weather days for finding the historical days most similar to a given day (analog days).
+ *
+ * Every day is described by a point of 5 numbers: the temperature, pressure and humidity as standard scores (the value
+minus the mean of the days, divided by their standard deviation), and the wind direction as a unit vector on the compass
+(so neighbouring directions are close, opposite ones are 2 apart, and a day without wind direction is at the centre). Days
+are compared by the Euclidean distance of their points.
+ *
+ * The points are kept in k-d trees, one over all the days and one over the days of every season, so a query visits a few
+hundred points instead of all the days, also when only the same season is searched. The trees are stored as arrays in
+tree order (the median of every range is its node), so there are no node pointers, and small ranges are scanned as a whole.
+ */
+class CAnalogIndex
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// The number of numbers describing a day.
+    static const int DIMENSION_CNT = 5;
+
+
+    /// This struct represents a day found by a query.
+    struct analogDay
+    {
+        /// The index of the day in the indexed weather data.
+        int m_index = 0;
+        /// The distance of the day from the query day (0 for an equal day).
+        double m_distance = 0;
+    };
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Constructors section:
+
+
+    /// Default constructor (no days).
+    CAnalogIndex();
+
+
+    /** @brief Constructor with parameters
+     *
+     * Builds the trees (O(n log n) for n days). The index keeps only the points, not the days.
+     *
+     * @param weather - The indexed weather days.
+     */
+    explicit CAnalogIndex(const WeatherView& weather);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /** Finds the indexed days most similar to a day.
+     *
+     * @param day - The query day (it does not have to be one of the indexed days).
+     * @param count - The number of days to find.
+     * @param isSameSeason - Whether only days of the season of the query day are searched (a day with an unknown month
+    then finds nothing).
+     * @param excludedIndex - The index of an indexed day that is not returned (e.g. the query day itself), or -1.
+     *
+     * @return Up to 'count' days, the most similar first.
+     */
+    std::vector<analogDay> findNearest(const CWather::weatherData& day, int count, bool isSameSeason,
+                                       int excludedIndex = -1) const;
+
+
+    /// Used to get the number of indexed days.
+    int getDayCount() const;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) Types section:
+
+
+    /// This struct represents a k-d tree stored as arrays in tree order (the node of a range is its middle point).
+    struct kdTree
+    {
+        /// Coordinates of the points (DIMENSION_CNT numbers per point).
+        std::vector<float> m_points;
+        /// Index of the day of every point.
+        std::vector<int> m_indexes;
+        /// The dimension every node splits its range by.
+        std::vector<unsigned char> m_splitDimensions;
+    };
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Private) class field:
+
+
+    /// The number of indexed days.
+    int dayCount;
+
+    /// Means and standard deviations of the temperature, pressure and humidity.
+    double means[3], deviations[3];
+
+    /// The tree of all the days and the trees of the days of every season (index Season - 1).
+    kdTree allDays;
+    kdTree seasonDays[4];
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Private) Methods section:
+
+
+    /// Computes the point of a day.
+    void getPoint(const CWather::weatherData& day, float* point) const;
+
+
+    /** Builds a tree.
+     *
+     * @param points - Coordinates of the points (DIMENSION_CNT numbers per point).
+     * @param indexes - Index of the day of every point.
+     *
+     * @return The tree of the points.
+     */
+    static kdTree buildTree(const std::vector<float>& points, const std::vector<int>& indexes);
+
+
+    /** Finds the points of a tree nearest to a point.
+     *
+     * @param tree - The searched tree.
+     * @param point - The query point.
+     * @param count - The number of points to find.
+     * @param excludedIndex - The index of a day that is not returned, or -1.
+     *
+     * @return Up to 'count' days, the nearest first.
+     */
+    static std::vector<analogDay> searchTree(const kdTree& tree, const float* point, int count, int excludedIndex);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // ANALOGINDEX_H
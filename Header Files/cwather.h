@@ -6,13 +6,54 @@
 #include <queue>
 #include <QtCharts>
 #include <QDialog>
+#include <QSharedData>
+#include <QMutex>
+#include <memory>
 
 
 /// Define a tuple to represent the date
 using date = std::tuple<unsigned, Month, int>;
 
 
-/// This class is designed to work with weather data and a weather table to represent it.
+/// This struct represents an additional line drawn over a weather graph (e.g. a moving average).
+struct graphOverlay
+{
+    /// Name of the line shown in the graph legend.
+    QString m_name;
+    /// The index of the day the first value belongs to.
+    int m_firstIndex = 0;
+    /// Values of the line for the days m_firstIndex, m_firstIndex + 1, ...
+    std::vector<double> m_values;
+    /// Indexes of the days of the values when the line has gaps (empty when the values are consecutive).
+    std::vector<int> m_indexes;
+};
+
+
+/// Read-only range over CWather days (declared in weatherview.h).
+class WeatherView;
+
+
+/// Climatology-driven weather forecast engine (declared in forecastengine.h).
+class CForecastEngine;
+
+
+/// Weekly, monthly, seasonal and yearly aggregates (declared in rollups.h).
+class CWeatherRollups;
+
+
+/// Lazily computed derived columns (declared in derivedcolumns.h).
+class CDerivedColumns;
+
+
+/// Index of the days for finding the most similar days (declared in analogindex.h).
+class CAnalogIndex;
+
+
+/** @brief This class is designed to work with weather data and a weather table to represent it.
+ *
+ * The weather data is implicitly shared (copy-on-write), like in Qt containers: copying a CWather object is a constant-time
+operation, and the data is really copied only when one of the objects that share it is changed.
+ */
 class CWather
 {
 
@@ -22,6 +63,51 @@ class CWather
 
 public:
 
+// (Public) Types section:
+
+
+    /// This struct represents weather-related data.
+    struct weatherData
+    {
+        /// An integer representing the year.
+        int m_year;
+        /// Enum representing the month (1 - 12).
+        Month m_month;
+        /// An unsigned integer representing the day (1 - 31).
+        unsigned m_day;
+        /// An integer representing temperature (in degrees Celsius).
+        int m_temperature;
+        /// An unsigned integer pressure data (in "millimeters of mercury" - mmHg).
+        unsigned m_pressure;
+        /// An integer representing humidity data (in per cent).
+        int m_humidity;
+        WindDirection m_windDirection;
+
+        /// A default weatherData constructor that initializes all members to default values.
+        weatherData
+        ():
+        m_year(0), m_month(Month::Unknown), m_day(0),
+        m_temperature(0), m_pressure(0), m_humidity(0), m_windDirection(WindDirection::Undefined)
+        {}
+
+        /// Parameterized weatherData constructor that allows you to set specific values when creating an instance of the struct.
+        weatherData
+        (int year, Month month, unsigned int day, int temperature, unsigned int pressure, int humidity, WindDirection windDirection):
+        m_year(year), m_month(month), m_day(day), m_temperature(temperature), m_pressure(pressure),
+        m_humidity(humidity), m_windDirection(windDirection)
+        {}
+    };
+
+
+    /// Percentage points within which the temperature and the pressure change in the stable periods of the main window, the
+    /// station summaries and the server (the periods of these ranges are cached).
+    static constexpr double STABLE_T_RANGE_PCT = 3.6;
+    static constexpr double STABLE_PSRE_RANGE_PCT = 2.5;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
 // (Public) Constructors & destructor section:
 
 
@@ -40,10 +126,23 @@ public:
     CWather(QTableWidget * weatherTable, const int& rowCount);
 
 
-    /// Copy constructor
+    /** @brief Constructor with parameters
+     *
+     * Constructor that takes over already read weather data (e.g. one station of a weather dataset).
+     *
+     * @param weatherArr - Weather data for each day.
+     */
+    explicit CWather(std::vector<weatherData> weatherArr);
+
+
+    /// Copy constructor (constant time, the weather data is shared until one of the objects is changed).
     CWather(const CWather& weather);
 
 
+    /// Move constructor (takes over the weather data of 'weather' without copying it).
+    CWather(CWather&& weather) noexcept;
+
+
     /// Default destructor
     ~CWather();
 
@@ -59,13 +158,21 @@ public:
      *
      * @return True if the weather data meets all requirements, False otherwise.
      */
-    bool isWeatherDataValid();
+    bool isWeatherDataValid() const;
 
 
     /// Within a season (3 months), sort the records by Pressure.
     void sortPressureBySeason();
 
 
+    /** Within a season (3 months), sort the records by a derived column (days with equal values keep their order, days
+    without a value go last).
+     *
+     * @param column - The derived column (its values are computed before the days are moved).
+     */
+    void sortBySeason(DerivedColumn column);
+
+
     /** @brief Fills the weather table.
      *
      * This method fills a table with 7 columns (year, month, day, t, pressure, humidity, wind direction) using the previously
@@ -73,7 +180,15 @@ public:
      *
      * @param weatherTable - Weather table neet to be filled.
      */
-    void completeTable(QTableWidget* weatherTable);
+    void completeTable(QTableWidget* weatherTable) const;
+
+
+    /** Adds the days from an index on to the end of the weather table (the rows already in it are not changed).
+     *
+     * @param weatherTable - Weather table with 7 columns.
+     * @param firstIndex - The index of the first day to add.
+     */
+    void appendToTable(QTableWidget* weatherTable, int firstIndex) const;
 
 
     /** @brief Build a weather graph
@@ -81,49 +196,55 @@ public:
      * Draws a weather graph with weather data on the y-axis and dates on the x-axis.
      *
      * @param getWeatherData - Function that takes the index of a table row and returns data from this row about one of the
-    weather parameters (temperature, pressure or humidity).
+    weather parameters (temperature, pressure, humidity or a derived column).
      * @param graphTitle - Title of the graph that is being built.
+     * @param overlays - Additional lines drawn over the graph (e.g. moving averages).
      */
-    void buildWeatherGraph(std::function<int(int)> getWeatherData, const QString& graphTitle);
+    void buildWeatherGraph(std::function<double(int)> getWeatherData, const QString& graphTitle,
+                           const std::vector<graphOverlay>& overlays = {}) const;
 
 
     /** Finds the indixes of weather "array" elements during which the wind direction did not change.
+     *
+     * @param continuity - How missing days are treated (see WeatherView::findDaysWindNotChange).
      *
      * @return A vector of vectors from the found indexes (each "internal" vector is a sequential weather indices when the wind
     direction did not change).
      */
-    std::vector<std::vector<unsigned>> findDaysWindNotChange();
+    std::vector<std::vector<unsigned>> findDaysWindNotChange(DayContinuity continuity = AssumeConsecutiveDays) const;
 
 
     /** Calculate the average temperature in the weather array.
      *
      * @return The average temperature in the weather array.
      */
-    double getAvgTemperature();
+    double getAvgTemperature() const;
 
 
     /** Calculate the average pressure in the weather array.
      *
      * @return The average pressure in the weather array.
      */
-    double getAvgPressure();
+    double getAvgPressure() const;
 
 
     /** Finds the days when the humidity is highest.
      *
      * @return Vector of dates when the humidity is highest.
      */
-    std::vector<QDate> getHighestHumidityDays();
+    std::vector<QDate> getHighestHumidityDays() const;
 
 
     /** Finds periods when the temperature and pressure changed within certain percentages.
      *
      * @param tRangePct - Percentage points within which the temperature can change (+-tRangePct).
      * @param psreRangePct - Percentage points within which the pressure can change (+-psreRangePct).
+     * @param continuity - How missing days are treated (see WeatherView::findPeriodTemperatureAndPressureChangeWithinRange).
      *
-     * @return Periods when the weather changes only within specified limits.
+     * @return Periods when the weather changes only within specified limits (views into this weather data).
      */
-    std::vector<CWather> findPeriodTemperatureAndPressureChangeWithinRange(double tRangePct, double psreRangePct);
+    std::vector<WeatherView> findPeriodTemperatureAndPressureChangeWithinRange(double tRangePct, double psreRangePct,
+                                                                               DayContinuity continuity = AssumeConsecutiveDays) const;
 
 
     /** Retrieve weather data for a specific period between two dates.
@@ -133,39 +254,118 @@ public:
      *
      * @return Weather data only for the specified period.
      */
-    CWather getWeatherByPeriod(QDate startDate, QDate endDate);
+    CWather getWeatherByPeriod(QDate startDate, QDate endDate) const;
+
+
+    /** Retrieve a view of the weather data for a specific period between two dates (no days are copied).
+     *
+     * @param startDate - start date of the period.
+     * @param endDate - end date of the period.
+     *
+     * @return View of the days within the specified period.
+     */
+    WeatherView getViewByPeriod(QDate startDate, QDate endDate) const;
+
+
+    /** Used to get a view over all the weather data.
+     *
+     * @return View of all the days (it shares the current weather data, so later changes of this object do not affect it).
+     */
+    WeatherView getView() const;
 
 
     /// Forecasts the weather for the next month and adds it to the existing weather data (at the end).
     void forecastWeatherForNextMonth();
 
 
+    /** Forecasts the weather for the next month and adds it to the existing weather data (at the end).
+     *
+     * @param seed - The seed of the forecast (the same seed and weather data give the same forecast).
+     */
+    void forecastWeatherForNextMonth(quint64 seed);
+
+
+    /** @brief Adds days to the end of the weather data.
+     *
+     * Cached rollups are updated with the new days rather than rebuilt, so the cost depends on the number of added days only
+    (unless the data is shared with another object and has to be copied first).
+     *
+     * @param days - The days to add.
+     */
+    void appendDays(const std::vector<weatherData>& days);
+
+
+    /** Used to get the forecast engine built from the climatology of the weather data.
+     *
+     * The engine is built in one pass on the first call and cached until the weather data changes.
+     *
+     * @return The forecast engine (shared, safe to use from any thread).
+     */
+    std::shared_ptr<const CForecastEngine> getForecastEngine() const;
+
+
+    /** Used to get the weekly, monthly, seasonal and yearly aggregates of the weather data.
+     *
+     * The rollups are built in one pass when the data is loaded (or on the first call) and are updated day by day when days
+    are appended, e.g. by forecasting.
+     *
+     * @return The rollups (shared, safe to use from any thread; appending days later does not change them).
+     */
+    std::shared_ptr<const CWeatherRollups> getRollups() const;
+
+
+    /** Used to get the index for finding the days most similar to a given day (analog days).
+     *
+     * The index is built on the first call and cached until the weather data changes.
+     *
+     * @return The analog-day index (shared, safe to use from any thread).
+     */
+    std::shared_ptr<const CAnalogIndex> getAnalogIndex() const;
+
+
     /** Used to get the number of days for which weather data was added.
      *
      * @return number of days for which weather data was added.
      */
-    int getWeatherSize();
+    int getWeatherSize() const;
 
 
     /** Used to get the temperature for a certain day.
      *
      * @param index - The index (row number) by which you want to get the temperature.
      */
-    int getTemperature(int index);
+    int getTemperature(int index) const;
 
 
     /** Used to get the pressure for a certain day.
      *
      * @param index - The index (row number) by which you want to get the pressure.
      */
-    unsigned getPressure(int index);
+    unsigned getPressure(int index) const;
 
 
     /** Used to get the humidity for a certain day.
      *
      * @param index - The index (row number) by which you want to get the humidity.
      */
-    int getHumidity(int index);
+    int getHumidity(int index) const;
+
+
+    /** Used to get the date of a certain day.
+     *
+     * @param index - The index (row number) by which you want to get the date.
+     */
+    QDate getDate(int index) const;
+
+
+    /** Used to get the value of a derived column for a certain day.
+     *
+     * The values are computed in blocks of days on first use and kept until the weather data changes.
+     *
+     * @param column - The derived column (dew point, heat index, pressure tendency or temperature anomaly).
+     * @param index - The index (row number) of the day.
+     */
+    double getDerivedValue(DerivedColumn column, int index) const;
 
 
 // -------------------------------------------------------------------------------------------------------------------------
@@ -174,10 +374,14 @@ public:
 // (Public) Operators section:
 
 
-    /// Copy assignment operator: Copies data from another object 'other' into the current object.
+    /// Copy assignment operator: Shares data of another object 'other' with the current object (constant time).
     CWather& operator=(const CWather& other);
 
 
+    /// Move assignment operator: Takes over the data of another object 'other' without copying it.
+    CWather& operator=(CWather&& other) noexcept;
+
+
     /// Overriding the >> operation for reading data from a file using QTextStream.
     friend QTextStream& operator>>(QTextStream& inFile, CWather &weather);
 
@@ -191,44 +395,59 @@ public:
 
 private:
 
+// (Private) Types section:
+
+
+    /// This struct represents a run of consecutive days found by an analysis.
+    struct dayRun
+    {
+        /// The index of the first day and the number of days.
+        int m_firstIndex, m_dayCount;
+    };
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
 // (Private) class field:
 
 
-    /// This struct represents weather-related data.
-    struct weatherData
+    /// Implicitly shared storage of the weather data.
+    class WeatherStorage : public QSharedData
     {
-        /// An integer representing the year.
-        int m_year;
-        /// Enum representing the month (1 - 12).
-        Month m_month;
-        /// An unsigned integer representing the day (1 - 31).
-        unsigned m_day;
-        /// An integer representing temperature (in degrees Celsius).
-        int m_temperature;
-        /// An unsigned integer pressure data (in "millimeters of mercury" - mmHg).
-        unsigned m_pressure;
-        /// An integer representing humidity data (in per cent).
-        int m_humidity;
-        WindDirection m_windDirection;
+    public:
+        /// Default constructor
+        WeatherStorage() {}
 
-        /// A default weatherData constructor that initializes all members to default values.
-        weatherData
-        ():
-        m_year(0), m_month(Month::Unknown), m_day(0),
-        m_temperature(0), m_pressure(0), m_humidity(0), m_windDirection(WindDirection::Undefined)
-        {}
+        /// Copy constructor (a copy is made to be changed, so only the caches that are updated on appends are copied).
+        WeatherStorage(const WeatherStorage& other) : QSharedData(other), weatherArr(other.weatherArr), rollups(other.rollups) {}
 
-        /// Parameterized weatherData constructor that allows you to set specific values when creating an instance of the struct.
-        weatherData
-        (int year, Month month, unsigned int day, int temperature, unsigned int pressure, int humidity, WindDirection windDirection):
-        m_year(year), m_month(month), m_day(day), m_temperature(temperature), m_pressure(pressure),
-        m_humidity(humidity), m_windDirection(windDirection)
-        {}
+        /// A vector for storing multiple instances of the weatherData struct (to represent the weather for many days).
+        std::vector<weatherData> weatherArr;
+
+        /// Guards the caches, which are built on demand from const methods (possibly from several threads).
+        mutable QMutex cacheMutex;
+
+        /// Cached forecast engine (nullptr until it is needed).
+        mutable std::shared_ptr<const CForecastEngine> forecastEngine;
+
+        /// Cached rollups (nullptr until they are needed). Shared with other storages, so they are copied before being changed.
+        mutable std::shared_ptr<CWeatherRollups> rollups;
+
+        /// Cached runs found by the wind and stable-period (STABLE_T_RANGE_PCT, STABLE_PSRE_RANGE_PCT) analyses of consecutive
+        /// days.
+        mutable std::shared_ptr<const std::vector<dayRun>> windRuns, stablePeriods;
+
+        /// Memoized derived columns (nullptr until a derived value is needed).
+        mutable std::shared_ptr<const CDerivedColumns> derivedColumns;
+
+        /// Cached analog-day index (nullptr until it is needed).
+        mutable std::shared_ptr<const CAnalogIndex> analogIndex;
     };
 
 
-    /// A vector for storing multiple instances of the weatherData struct (to represent the weather for many days).
-    std::vector<weatherData> weatherArr;
+    /// Pointer to the weather data storage. Non-const access detaches (copies) the storage if it is shared.
+    QSharedDataPointer<WeatherStorage> d;
 
 
 // -------------------------------------------------------------------------------------------------------------------------
@@ -257,6 +476,58 @@ private:
     void pushWeatherDataEnd(const weatherData& wData);
 
 
+    /// Drops all data derived from the weather data (must be called by every method that changes it).
+    void invalidateCaches();
+
+
+    /** @brief Updates the data derived from the weather data after days were appended.
+     *
+     * Must be called instead of invalidateCaches() by methods that only add days to the end.
+     *
+     * @param firstNewIndex - The index of the first appended day.
+     */
+    void updateCachesOnAppend(int firstNewIndex);
+
+
+    /** Used to get the storage left in an object whose data was moved out.
+     *
+     * @return Pointer to an empty storage shared by all such objects (no memory is allocated).
+     */
+    static QSharedDataPointer<WeatherStorage> sharedEmptyStorage();
+
+
+    /** Used to get the derived columns of a storage (created on the first call and kept until the weather data changes).
+     *
+     * @param storage - The weather data storage.
+     *
+     * @return The derived columns of the days of the storage.
+     */
+    static std::shared_ptr<const CDerivedColumns> getDerivedColumns(const WeatherStorage& storage);
+
+
+    /** Used to get the runs of consecutive days when the wind direction did not change (found on the first call and cached
+    until the weather data changes).
+     *
+     * @return The runs (shared, safe to use from any thread).
+     */
+    std::shared_ptr<const std::vector<dayRun>> getWindRuns() const;
+
+
+    /** Used to get the stable periods of consecutive days with the STABLE_T_RANGE_PCT and STABLE_PSRE_RANGE_PCT ranges (found on
+    the first call and cached until the weather data changes).
+     *
+     * @return The periods (shared, safe to use from any thread).
+     */
+    std::shared_ptr<const std::vector<dayRun>> getStablePeriods() const;
+
+
+    /// WeatherView reads the weather "array" directly.
+    friend class WeatherView;
+
+    /// CWeatherCache stores the weather "array" and the caches, and restores them without rebuilding.
+    friend class CWeatherCache;
+
+
 
 // -------------------------------------------------------------------------------------------------------------------------
 
@@ -333,6 +604,15 @@ QString convertWindDirToText(WindDirection direction);
 double getPercentageOf(double digit);
 
 
+/** Rounds a value to two decimal places (the way the average values are presented).
+ *
+ * @param value - The value to round.
+ *
+ * @return The rounded value.
+ */
+double roundToHundredths(double value);
+
+
 // -------------------------------------------------------------------------------------------------------------------------
 
 #endif // CWATHER_H
@@ -0,0 +1,162 @@
+#ifndef DERIVEDCOLUMNS_H
+#define DERIVEDCOLUMNS_H
+
+#include "cwather.h"
+#include <atomic>
+
+
+/** @brief Weather columns derived from the measured ones, computed lazily and memoized.
+ *
+ * Each derived column is declared once as an expression over the measured columns of a block of days (see the
+declarations in derivedcolumns.cpp): dew point and heat index from temperature and humidity, the pressure tendency from the
+pressure of the day and the day before it (NaN when the previous row is not the day before), and the temperature anomaly from the temperature and the mean temperature of the
+calendar month over all the days. Nothing is computed until a value is asked for; then the block of BLOCK_SIZE days it
+belongs to is computed in one tight loop over contiguous copies of the measured columns and kept for the next calls.
+ *
+ * The object is owned by the weather storage it was built for (CWather drops it whenever the days change), and the same
+days must be passed to every call. Values can be read from several threads.
+ */
+class CDerivedColumns
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// The number of days computed together.
+    static constexpr int BLOCK_SIZE = 1024;
+
+    /// The number of derived columns (DerivedColumn values are 1 .. COLUMN_CNT).
+    static constexpr int COLUMN_CNT = 4;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Constructors section:
+
+
+    /** @brief Constructor with parameters
+     *
+     * No values are computed (nor memory for them allocated) until they are needed.
+     *
+     * @param dayCount - The number of days of the weather data.
+     */
+    explicit CDerivedColumns(int dayCount);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /** Used to get the value of a derived column for a certain day.
+     *
+     * @param weatherArr - The days the object was built for.
+     * @param column - The derived column.
+     * @param index - The index of the day.
+     *
+     * @return The value (computed with its block on the first call; NaN if the day has none, e.g. the pressure tendency after
+    a missing day).
+     */
+    double getValue(const std::vector<CWather::weatherData>& weatherArr, DerivedColumn column, int index) const;
+
+
+    /** Copies the values of a derived column for a range of days into a contiguous array.
+     *
+     * @param weatherArr - The days the object was built for.
+     * @param column - The derived column.
+     * @param firstIndex - The index of the first day.
+     * @param count - The number of days.
+     * @param values - The array that receives 'count' values.
+     */
+    void getValues(const std::vector<CWather::weatherData>& weatherArr, DerivedColumn column, int firstIndex, int count,
+                   double* values) const;
+
+
+    /// Used to get the name of a derived column in filter expressions (e.g. "dewpoint").
+    static QString getName(DerivedColumn column);
+
+
+    /// Used to get the title of a derived column with its unit (e.g. "Dew point, °C").
+    static QString getTitle(DerivedColumn column);
+
+
+    /** Finds a derived column by its name in filter expressions.
+     *
+     * @param name - The name (not case-sensitive).
+     * @param column - Receives the column if it was found.
+     *
+     * @return True if there is a derived column with the name, False otherwise.
+     */
+    static bool findColumn(const QString& name, DerivedColumn& column);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) Types section:
+
+
+    /// This struct represents the memoized values of one derived column.
+    struct columnValues
+    {
+        /// Values of all the days (allocated when the first block of the column is computed).
+        std::vector<double> m_values;
+        /// Flags of the computed blocks (set after the values of the block are written).
+        std::unique_ptr<std::atomic<bool>[]> m_isBlockReady;
+    };
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Private) class field:
+
+
+    /// The number of days and of blocks.
+    int dayCount, blockCount;
+
+    /// Guards the computation of blocks (computed blocks are read without it).
+    mutable QMutex mutex;
+
+    /// The memoized values of the derived columns.
+    mutable columnValues columns[COLUMN_CNT];
+
+    /// Mean temperature of every calendar month over all the days (index 0 is used by days with an unknown month).
+    mutable double monthlyMeanTemperature[13];
+    mutable bool isClimatologyReady;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Private) Methods section:
+
+
+    /** Used to get the memoized values of a derived column, making sure a block of them is computed.
+     *
+     * @param weatherArr - The days the object was built for.
+     * @param column - The derived column.
+     * @param block - The index of the block.
+     *
+     * @return The values of all the days of the column (only the computed blocks are filled).
+     */
+    const double* getBlock(const std::vector<CWather::weatherData>& weatherArr, DerivedColumn column, int block) const;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // DERIVEDCOLUMNS_H
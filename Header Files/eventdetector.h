@@ -0,0 +1,173 @@
+#ifndef EVENTDETECTOR_H
+#define EVENTDETECTOR_H
+
+#include "weatherview.h"
+
+class CWeatherDataset;
+
+
+/** @brief Detection of extreme weather events (heat waves, cold spells, sharp pressure falls) by configurable rules.
+ *
+ * Two kinds of rules are supported: runs of at least N days with a column above (or below) a percentile of its values, and
+changes of a column by at least X within a window of 1 - N days (e.g. a pressure fall of 8 mmHg within 72 hours). The
+percentiles are read from the monthly histograms of the cached rollups of the weather data, either of all the days or of the
+days of the same calendar month, so no day is read to find them.
+ *
+ * All the rules are then checked in one pass over the days: a run rule keeps the start of the current run, and a change rule
+keeps the extreme of the preceding window in a monotonic deque, so every day costs O(1) per rule whatever the window is.
+Overlapping windows of a change rule are merged, so every event is reported once, as a compact range of days.
+ */
+class CEventDetector
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// This enum identifies the kinds of rules.
+    enum ruleType
+    {
+        /// At least m_minDayCount days in a row with the column above the m_percentile percentile.
+        RunAbovePercentile = 0,
+        /// At least m_minDayCount days in a row with the column below the m_percentile percentile.
+        RunBelowPercentile = 1,
+        /// The column falls by at least m_minChange from a day within the m_windowDays days before.
+        FallWithinWindow = 2,
+        /// The column rises by at least m_minChange from a day within the m_windowDays days before.
+        RiseWithinWindow = 3
+    };
+
+
+    /// This struct represents a rule an event is detected by.
+    struct eventRule
+    {
+        /// The name of the event (e.g. "Heat wave").
+        QString m_name;
+        /// The kind of the rule.
+        ruleType m_type = RunAbovePercentile;
+        /// The weather column the rule checks.
+        WeatherColumn m_column = TemperatureColumn;
+        /// The percentile of the threshold (run rules, 0 - 100).
+        double m_percentile = 90;
+        /// Whether the threshold is the percentile of the days of the same calendar month instead of all the days (run rules).
+        bool m_isMonthlyPercentile = true;
+        /// The shortest run (run rules).
+        int m_minDayCount = 3;
+        /// The number of days before a day the change is measured from (change rules).
+        int m_windowDays = 3;
+        /// The smallest change (change rules, in the units of the column).
+        int m_minChange = 8;
+    };
+
+
+    /// This struct represents a detected event.
+    struct extremeEvent
+    {
+        /// The index of the rule the event was detected by.
+        int m_ruleIndex = 0;
+        /// The index of the first day of the event and the number of its days (when gaps are filled, the days can include
+        /// filled days, so the rows of the event need not follow each other: use the dates).
+        int m_firstIndex = 0;
+        int m_dayCount = 0;
+        /// The most extreme value of the column during a run, or the largest change.
+        int m_extremeValue = 0;
+        /// The dates of the first and the last day of the event.
+        QDate m_firstDate, m_lastDate;
+    };
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Constructors section:
+
+
+    /** @brief Constructor with parameters
+     *
+     * @param rules - The rules events are detected by (events refer to them by their index).
+     */
+    explicit CEventDetector(std::vector<eventRule> rules = getDefaultRules());
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /// Used to get the rules events are detected by.
+    const std::vector<eventRule>& getRules() const;
+
+
+    /** Detects the events in weather data.
+     *
+     * @param weather - Weather data (its cached rollups give the thresholds of the run rules).
+     * @param continuity - How missing days are treated: neighbouring days of the data are neighbouring days, events end at
+    gaps, or gaps are filled (linearly) before the search; events are always reported in the days of the data.
+     *
+     * @return The events of all the rules, by their first day (events of the same day in the order of the rules).
+     */
+    std::vector<extremeEvent> detect(const CWather& weather, DayContinuity continuity = AssumeConsecutiveDays) const;
+
+
+    /** Detects the events of every station of a dataset (stations are searched in parallel).
+     *
+     * @param dataset - The dataset.
+     * @param continuity - How missing days are treated (see detect()).
+     *
+     * @return The events of every station (in the order of the stations).
+     */
+    std::vector<std::vector<extremeEvent>> detectStations(const CWeatherDataset& dataset,
+                                                          DayContinuity continuity = AssumeConsecutiveDays) const;
+
+
+    /** Used to get the default rules.
+     *
+     * @return Heat waves (t above the 90th percentile of the month for 3 and more days), cold spells (t below the 10th
+    percentile of the month for 3 and more days) and pressure falls (by 8 mmHg and more within 3 days).
+     */
+    static std::vector<eventRule> getDefaultRules();
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) class field:
+
+
+    /// The rules events are detected by.
+    std::vector<eventRule> rules;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Private) Methods section:
+
+
+    /** Detects the events in a range of consecutive days.
+     *
+     * @param weather - Weather days.
+     * @param firstIndex - The index of the first day of the range.
+     * @param dayCount - The number of days of the range.
+     * @param thresholds - Thresholds of every rule (13 per rule: index 0 for all the days, 1 - 12 for the calendar months).
+     * @param events - Receives the events of the range.
+     */
+    void detectInRange(const WeatherView& weather, int firstIndex, int dayCount, const std::vector<int>& thresholds,
+                       std::vector<extremeEvent>& events) const;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // EVENTDETECTOR_H
@@ -0,0 +1,146 @@
+#ifndef EXTERNALSORT_H
+#define EXTERNALSORT_H
+
+#include "weatherstream.h"
+#include <QStringList>
+
+
+/** @brief Sorts and merges weather files of any size by date in bounded memory.
+ *
+ * The days of the input files (text or binary, in any order) are read in chunks that fit into the memory budget; every
+chunk is sorted by date and written to a temporary run (binary if all the inputs are binary; otherwise text, which holds
+every value a text file can hold, unlike the binary format). The runs are then merged in a k-way merge (each run is read
+through its own block buffer, so the disk is read in large sequential blocks) and written to the output file. If there are
+more runs than can be merged at once, groups of runs are merged into longer runs first.
+ *
+ * Days with the same date keep the order of the input files. Duplicate dates are either kept or dropped (the first day of
+the date is kept), and are reported in both cases. Days with invalid dates cannot be ordered and are skipped. The result is
+one date-ordered series, so files with the days of several stations are refused (their stations would be merged into one
+series); the station line of a file with one station is not written.
+ */
+class CWeatherExternalSort
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// How days with the date of the previous day are treated.
+    enum duplicatePolicy
+    {
+        KeepDuplicates,
+        DropDuplicates
+    };
+
+
+    /// This struct represents the result of sorting.
+    struct sortSummary
+    {
+        /// The number of days read from the input files.
+        qint64 m_readDayCount = 0;
+        /// The number of days written to the output file.
+        qint64 m_writtenDayCount = 0;
+        /// The number of skipped days with invalid dates.
+        qint64 m_invalidDayCount = 0;
+        /// The number of sorted runs written to temporary files.
+        int m_runCount = 0;
+        /// Dates that occurred more than once (each date is listed once).
+        std::vector<QDate> m_duplicateDates;
+    };
+
+
+    /// The default memory budget (in bytes).
+    static const qint64 DEFAULT_MEMORY_BUDGET = 256ll << 20;
+
+    /// The largest number of runs merged at once.
+    static const int MAX_MERGE_WAYS = 64;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Constructors section:
+
+
+    /** @brief Constructor with parameters
+     *
+     * @param memoryBudget - Memory (in bytes) used for the days of a run and for the block buffers of the merge.
+     * @param policy - How days with the date of the previous day are treated.
+     */
+    explicit CWeatherExternalSort(qint64 memoryBudget = DEFAULT_MEMORY_BUDGET, duplicatePolicy policy = DropDuplicates);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /** @brief Sorts and merges files
+     *
+     * @param inputFiles - The names of the input files (text or binary format).
+     * @param outputFile - The name of the output file (an existing file is overwritten).
+     * @param binaryOutput - True to write the binary format, False to write the text format.
+     *
+     * @throw QString - If a file could not be read or written, or if an input file contains several stations.
+     *
+     * @return The numbers of days and the duplicate dates.
+     */
+    sortSummary sortFiles(const QStringList& inputFiles, const QString& outputFile, bool binaryOutput) const;
+
+
+    /** @brief Runs the sort from the command line
+     *
+     * Usage: --sort [--binary] [--keep-duplicates] [--memory <MB>] <output file> <input files...>
+     *
+     * @param arguments - The arguments of the application (the first one is the name of the program).
+     *
+     * @return The exit code of the application (0 on success).
+     */
+    static int runCommandLine(const QStringList& arguments);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) class field:
+
+
+    /// Memory (in bytes) used for the days of a run and for the block buffers of the merge.
+    qint64 memoryBudget;
+
+    /// How days with the date of the previous day are treated.
+    duplicatePolicy policy;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Private) Methods section:
+
+
+    /** Merges sorted runs into one file.
+     *
+     * @param runFiles - The names of the runs, in input order.
+     * @param writer - The file the merged days are written to.
+     * @param summary - Receives the duplicate dates (only if it is given).
+     *
+     * @throw QString - If a run could not be read or the output could not be written.
+     */
+    void mergeRuns(const QStringList& runFiles, CWeatherFileWriter& writer, sortSummary* summary) const;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // EXTERNALSORT_H
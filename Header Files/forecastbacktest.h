@@ -0,0 +1,125 @@
+#ifndef FORECASTBACKTEST_H
+#define FORECASTBACKTEST_H
+
+#include "forecastengine.h"
+
+
+/** @brief Backtesting of the monthly weather forecast against the weather history.
+ *
+ * The history is replayed month by month: every month of the weather data (after a minimum history) is forecast the way
+CWather::forecastWeatherForNextMonth does it, from a climatology built only from the days before the month, and the forecast
+is compared with the days that were really observed. The errors of the temperature, pressure and humidity (MAE and RMSE) and
+the share of days with the right wind direction are reported for every month and for all of them together.
+ *
+ * The months are independent, so they are forecast and scored in parallel on all cores. Month i uses random stream i of the
+seed, so the result does not depend on how the months are scheduled between threads.
+ */
+class CForecastBacktest
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// The number of days of history a month needs to be forecast by default (one year, so every season has a climate).
+    static const int DEFAULT_MIN_HISTORY_DAYS = 365;
+
+
+    /// This struct represents the errors of the forecast of one weather parameter.
+    struct errorScore
+    {
+        /// Mean absolute error and root mean square error.
+        double m_mae = 0, m_rmse = 0;
+    };
+
+
+    /// This struct represents the score of the forecast of one month (or of all the months together).
+    struct monthScore
+    {
+        /// The year and the month (0 and Month::Unknown for all the months together).
+        int m_year = 0;
+        Month m_month = Month::Unknown;
+        /// The number of days of history the forecast was made from.
+        int m_historyDayCount = 0;
+        /// The number of scored days.
+        int m_dayCount = 0;
+        /// Errors of the temperature (degrees Celsius), pressure (mmHg) and humidity (per cent).
+        errorScore m_temperature, m_pressure, m_humidity;
+        /// The share of days with the right wind direction (0 - 1).
+        double m_windHitRate = 0;
+    };
+
+
+    /// This struct represents the result of a backtest.
+    struct backtestResult
+    {
+        /// Scores of the forecast months (in date order).
+        std::vector<monthScore> m_months;
+        /// The score of all the scored days together.
+        monthScore m_total;
+        /// The duration of the backtest (in seconds).
+        double m_seconds = 0;
+    };
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /** @brief Runs a backtest
+     *
+     * A month is a run of neighbouring days with the same year and month (the days are expected in date order). The
+    forecast of day N of a month is compared with the observed day with the date N; days with invalid dates are not scored.
+     *
+     * @param weather - The weather history.
+     * @param seed - The seed of the forecasts.
+     * @param minHistoryDays - Months with fewer days before them are not forecast.
+     *
+     * @return The scores of the months and the total score.
+     */
+    static backtestResult run(const WeatherView& weather, quint64 seed, int minHistoryDays = DEFAULT_MIN_HISTORY_DAYS);
+
+
+    /** Formats the total score of a backtest as a report.
+     *
+     * @param result - The result of the backtest.
+     *
+     * @return Lines of the report (months, days, time, errors of every parameter and the wind hit rate).
+     */
+    static QString toText(const backtestResult& result);
+
+
+    /** Formats the scores of the months of a backtest as comma-separated values.
+     *
+     * @param result - The result of the backtest.
+     * @param stationId - The station written in the first column.
+     * @param isHeaderIncluded - Whether the lines start with a header line (False when stations are written one after another).
+     *
+     * @return A line for every month, followed by a line with the total score (the year column is "total").
+     */
+    static QString toCsv(const backtestResult& result, const QString& stationId, bool isHeaderIncluded = true);
+
+
+    /** @brief Runs a backtest from the command line
+     *
+     * Usage: --backtest [--seed <n>] [--min-history <days>] [--csv <file>] <file>
+     *
+     * @param arguments - The arguments of the application (the first one is the name of the program).
+     *
+     * @return The exit code of the application.
+     */
+    static int runCommandLine(const QStringList& arguments);
+
+};
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // FORECASTBACKTEST_H
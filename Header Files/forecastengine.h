@@ -0,0 +1,250 @@
+#ifndef FORECASTENGINE_H
+#define FORECASTENGINE_H
+
+#include "weatherview.h"
+#include <array>
+
+
+/** @brief Counter-based random number stream.
+ *
+ * Every number is a SplitMix64 hash of (seed, stream, counter), so a stream has no shared state and no locks: the same seed
+and stream always give the same numbers, on any thread and in any order the streams are used.
+ */
+class CRandomStream
+{
+public:
+
+    /** @brief Constructor with parameters
+     *
+     * @param seed - The seed of the random numbers.
+     * @param stream - The number of an independent stream for the same seed (e.g. an ensemble member).
+     */
+    CRandomStream(quint64 seed, quint64 stream = 0) : key(mix(seed ^ mix(stream + 0x9E3779B97F4A7C15ull))), counter(0),
+        hasSpareGaussian(false), spareGaussian(0)
+    {}
+
+
+    /// Returns the next 64 random bits of the stream.
+    quint64 next()
+    {
+        return mix(key + (++counter) * 0x9E3779B97F4A7C15ull);
+    }
+
+
+    /// Returns the next random number in the range [0, 1).
+    double nextDouble()
+    {
+        return (next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+
+    /// Returns the next random number with the standard normal distribution (Box-Muller transform).
+    double nextGaussian();
+
+
+private:
+
+    /// SplitMix64 finalizer.
+    static quint64 mix(quint64 z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    /// The hash of the seed and the stream number.
+    quint64 key;
+
+    /// The number of random values taken from the stream.
+    quint64 counter;
+
+    /// Box-Muller gives two normal numbers at once; the second one is kept here.
+    bool hasSpareGaussian;
+    double spareGaussian;
+};
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+/** @brief Climatology-driven weather forecast engine.
+ *
+ * The engine builds a per-day-of-year climatology (mean and variance of temperature, pressure and humidity, wind direction
+frequencies) from weather history in one pass, and generates forecasts for any number of days from it. Forecasts are
+reproducible: the same seed gives the same weather.
+ */
+class CForecastEngine
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// Number of days in the climatology calendar (February 29 has its own day).
+    static const int DAYS_IN_CLIMATE_YEAR = 366;
+
+    /// Number of wind directions (WindDirection values 1..8).
+    static const int WIND_DIRECTION_CNT = 8;
+
+    /// The largest ensemble (forecasted days times members) the application runs.
+    static constexpr long long MAX_ENSEMBLE_SIZE = 20000000;
+
+    /// The number of values of one parameter generated before they are reduced (bounds the memory of an ensemble).
+    static constexpr int ENSEMBLE_BLOCK_SIZE = 1 << 20;
+
+
+    /// This struct represents the climate of one day of the year.
+    struct dayClimate
+    {
+        /// Mean and variance of the temperature (in degrees Celsius).
+        double m_temperatureMean = 0, m_temperatureVariance = 0;
+        /// Mean and variance of the pressure (in mmHg).
+        double m_pressureMean = 0, m_pressureVariance = 0;
+        /// Mean and variance of the humidity (in per cent).
+        double m_humidityMean = 0, m_humidityVariance = 0;
+        /// Cumulative frequencies of the wind directions (m_windCumulative[i] - share of directions 1..i+1).
+        std::array<double, WIND_DIRECTION_CNT> m_windCumulative {};
+        /// Number of observed days the climate is based on (0 if it was interpolated from neighbouring days).
+        int m_count = 0;
+    };
+
+
+    /// This struct represents the per-day percentile bands of one weather parameter in an ensemble forecast.
+    struct percentileBand
+    {
+        /// 10th, 50th (median) and 90th percentile of the parameter for each forecasted day.
+        std::vector<double> m_p10, m_p50, m_p90;
+    };
+
+
+    /// This struct represents the result of an ensemble forecast.
+    struct ensembleForecast
+    {
+        /// The date of the first forecasted day.
+        QDate m_startDate;
+        /// The number of forecast members the bands were computed from.
+        int m_memberCount = 0;
+        /// Percentile bands of the temperature, pressure and humidity.
+        percentileBand m_temperature, m_pressure, m_humidity;
+    };
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Constructors section:
+
+
+    /// Default constructor (empty climatology).
+    CForecastEngine();
+
+
+    /** @brief Constructor with parameters
+     *
+     * Builds the climatology from the weather history in one pass.
+     *
+     * @param history - Weather history (days with invalid dates are skipped).
+     * @param smoothingHalfWidth - Each day of the year is described by the days within ±smoothingHalfWidth days of it.
+     */
+    explicit CForecastEngine(const WeatherView& history, int smoothingHalfWidth = 7);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /** Determine if there is a climatology to forecast from.
+     *
+     * @return False if the history had no valid days, True otherwise.
+     */
+    bool isEmpty() const;
+
+
+    /** Used to get the climate of a certain day of the year.
+     *
+     * @param month - The month of the day.
+     * @param day - The day of the month (1 - 31).
+     */
+    const dayClimate& getDayClimate(Month month, unsigned day) const;
+
+
+    /** @brief Forecasts the weather for a number of days.
+     *
+     * Every day is drawn independently from the climate of its day of the year.
+     *
+     * @param startDate - The date of the first forecasted day.
+     * @param dayCount - The number of days to forecast.
+     * @param random - The random numbers the forecast is drawn from.
+     *
+     * @return Forecasted weather data for each day (empty if the climatology is empty).
+     */
+    std::vector<CWather::weatherData> forecast(QDate startDate, int dayCount, CRandomStream& random) const;
+
+
+    /** @brief Runs an ensemble (Monte Carlo) forecast.
+     *
+     * Forecast members are run in parallel on all cores. Member i uses random stream i of the seed, so the result does not
+    depend on how the members are scheduled between threads. The days are generated in blocks of about ENSEMBLE_BLOCK_SIZE
+    values per parameter, which are reduced into the bands and dropped before the next block, so the memory does not grow with
+    the number of days.
+     *
+     * @param startDate - The date of the first forecasted day.
+     * @param dayCount - The number of days to forecast.
+     * @param memberCount - The number of independent forecast members.
+     * @param seed - The seed of the ensemble.
+     *
+     * @return Per-day p10/p50/p90 bands of temperature, pressure and humidity (empty if the climatology is empty).
+     */
+    ensembleForecast forecastEnsemble(QDate startDate, int dayCount, int memberCount, quint64 seed) const;
+
+
+    /** @brief Build an ensemble graph
+     *
+     * Draws the median of a weather parameter as a line and its p10 - p90 range as a band, with dates on the x-axis.
+     *
+     * @param band - Percentile bands of the weather parameter.
+     * @param startDate - The date of the first day of the bands.
+     * @param graphTitle - Title of the graph that is being built.
+     */
+    static void buildEnsembleGraph(const percentileBand& band, QDate startDate, const QString& graphTitle);
+
+
+    /** Returns the index of a day in the climatology calendar.
+     *
+     * @param month - The month of the day.
+     * @param day - The day of the month (1 - 31).
+     *
+     * @return Index 0 .. DAYS_IN_CLIMATE_YEAR - 1, or -1 if the month or the day is invalid.
+     */
+    static int getDayOfYearIndex(Month month, unsigned day);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) class field:
+
+
+    /// Climate of every day of the climatology calendar.
+    std::vector<dayClimate> climate;
+
+    /// CWeatherCache stores the climatology and restores it without rebuilding.
+    friend class CWeatherCache;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // FORECASTENGINE_H
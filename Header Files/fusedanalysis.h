@@ -0,0 +1,197 @@
+#ifndef FUSEDANALYSIS_H
+#define FUSEDANALYSIS_H
+
+#include "weatherview.h"
+
+
+/** @brief Several analyses of weather days computed in one pass.
+ *
+ * The caller registers the analyses it needs and runs them over a view: every day is loaded once and handed to all the
+registered analyses, which share the loaded values and the comparisons with the previous day. A report that needs the
+averages, the highest humidity, the date range, the wind runs and the stable periods reads the days once instead of once per
+analysis.
+ *
+ * addDay() is the step run() makes for every day. It is the only implementation of the wind runs and of the stable periods:
+WeatherView and the streaming analysis of files feed their days to it, so their results follow the same rules.
+ */
+class CFusedAnalysis
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// The analyses that can be registered (they can be combined with |).
+    enum analysisKind
+    {
+        /// Sums and averages of temperature and pressure.
+        AveragesAnalysis = 1,
+        /// The highest humidity and the days it was observed.
+        HumidityAnalysis = 2,
+        /// The first and the last valid date.
+        DateRangeAnalysis = 4,
+        /// Runs of days when the wind direction did not change.
+        WindRunsAnalysis = 8,
+        /// Periods when the temperature and pressure changed within the ranges.
+        StablePeriodsAnalysis = 16,
+        /// All of the above.
+        AllAnalyses = 31
+    };
+
+
+    /// This struct represents a run of days (a wind run or a stable period) among the added days.
+    struct dayRange
+    {
+        /// The number of the first day (in the order the days were added) and the number of days.
+        int m_firstDay = 0;
+        int m_dayCount = 0;
+        /// The first and the last day of the range.
+        CWather::weatherData m_first, m_last;
+    };
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Constructors section:
+
+
+    /** @brief Constructor with parameters
+     *
+     * @param analyses - The registered analyses (analysisKind values combined with |).
+     * @param tRangePct - Percentage points within which the temperature can change in a stable period.
+     * @param psreRangePct - Percentage points within which the pressure can change in a stable period.
+     */
+    explicit CFusedAnalysis(int analyses = 0, double tRangePct = CWather::STABLE_T_RANGE_PCT,
+                            double psreRangePct = CWather::STABLE_PSRE_RANGE_PCT);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /// Registers an analysis (before run() is called).
+    void addAnalysis(analysisKind analysis);
+
+
+    /// Determine if an analysis is registered.
+    bool hasAnalysis(analysisKind analysis) const;
+
+
+    /** @brief Runs the registered analyses over the days in one pass
+     *
+     * The results of a previous run are replaced.
+     *
+     * @param weather - The analysed days (neighbouring days of the view are treated as consecutive days).
+     */
+    void run(const WeatherView& weather);
+
+
+    /** @brief Adds the next day to the registered analyses
+     *
+     * The days are treated as consecutive days until endSeries() is called. Results that refer to the days of a view
+(getHighestHumidityDays(), getWindRuns() and getStablePeriods()) are only made by run().
+     *
+     * @param wData - The weather data of the day.
+     */
+    void addDay(const CWather::weatherData& wData);
+
+
+    /// Ends the wind run and the stable period in progress (the next day starts a new series, e.g. of another station).
+    void endSeries();
+
+
+    /// Used to get the number of analysed days.
+    int getDayCount() const;
+
+
+    /// Used to get the exact sums of temperature and pressure (AveragesAnalysis).
+    long long getTemperatureSum() const;
+    long long getPressureSum() const;
+
+
+    /// Used to get the average temperature and pressure, rounded to two decimal places (0 without days; AveragesAnalysis).
+    double getAvgTemperature() const;
+    double getAvgPressure() const;
+
+
+    /// Used to get the highest humidity (0 without days) and the number of days it was observed (HumidityAnalysis).
+    int getMaxHumidity() const;
+    int getMaxHumidityDayCount() const;
+
+
+    /// Used to get the dates of the days with the highest humidity, as WeatherView::getHighestHumidityDays (HumidityAnalysis).
+    std::vector<QDate> getHighestHumidityDays() const;
+
+
+    /// Used to get the first and the last valid date (invalid dates if there are none; DateRangeAnalysis).
+    QDate getFirstDate() const;
+    QDate getLastDate() const;
+
+
+    /// Used to get the runs of days when the wind direction did not change, as WeatherView::findDaysWindNotChange (WindRunsAnalysis).
+    const std::vector<std::vector<unsigned>>& getWindRuns() const;
+
+
+    /// Used to get the stable periods, as WeatherView::findPeriodTemperatureAndPressureChangeWithinRange (StablePeriodsAnalysis).
+    const std::vector<WeatherView>& getStablePeriods() const;
+
+
+    /// Used to get the ended wind runs (2 and more days) and stable periods (3 and more days) of the added days.
+    const std::vector<dayRange>& getWindRunRanges() const;
+    const std::vector<dayRange>& getStablePeriodRanges() const;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) class field:
+
+
+    /// The registered analyses and the ranges of the stable periods.
+    int analyses;
+    double tRangePct, psreRangePct;
+
+    /// The analysed days.
+    WeatherView weather;
+    int dayCount;
+
+    /// Sums of temperature and pressure.
+    long long tSum, psreSum;
+
+    /// The highest humidity and the indexes of the days it was observed.
+    int maxHumidity;
+    std::vector<int> maxHumidityIndexes;
+
+    /// The first and the last valid date (and the same dates packed as (year, month, day) numbers).
+    QDate firstDate, lastDate;
+    long long firstDateKey, lastDateKey;
+
+    /// The wind run and the stable period in progress; the sums of the stable period give its averages without rescanning it.
+    dayRange windRun, stablePeriod;
+    double periodTSum, periodPsreSum;
+
+    /// Ended runs and periods.
+    std::vector<dayRange> windRunRanges, stablePeriodRanges;
+
+    /// Found runs and periods as indexes and views of the days of run().
+    std::vector<std::vector<unsigned>> windRuns;
+    std::vector<WeatherView> stablePeriods;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // FUSEDANALYSIS_H
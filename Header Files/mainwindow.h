@@ -3,6 +3,12 @@
 
 #include <QMainWindow>
 #include "cwather.h"
+#include "weatherview.h"
+#include "weatherquery.h"
+#include "weatherdataset.h"
+#include "weatherjournal.h"
+#include "weatherstream.h"
+#include "weathercache.h"
 #include "WeatherEnums.h"
 #include <QMessageBox>
 #include <QDateEdit>
@@ -10,6 +16,14 @@
 #include <QPushButton>
 #include <QLabel>
 #include <QComboBox>
+#include <QSpinBox>
+#include <QCheckBox>
+#include <QInputDialog>
+#include <QFutureWatcher>
+#include <QProgressBar>
+#include <QFileSystemWatcher>
+#include <QCloseEvent>
+#include <QTimer>
 
 
 QT_BEGIN_NAMESPACE
@@ -145,20 +159,30 @@ public:
     void deleteRow(int rowIndex);
 
 
+    /** Shows the days of the weather history most similar to the day of a row (its analog days).
+     *
+     * @param rowIndex - The index of the row of the day.
+     */
+    void findAnalogDays(int rowIndex);
+
+
     /** From the available weather information, it determines the weather for a certain period selected by the user.
      *
      * @param isSuccess - The variable to which the method is written if it was successful.
      *
-     * @return Weather (CWather) for the period selected by the user.
+     * @return View of the main weather for the period selected by the user.
      */
-    CWather getWeatherPeriod(bool& isSuccess);
+    WeatherView getWeatherPeriod(bool& isSuccess);
 
 
-    /** For each period (passed as a method parameter), it creates a weather table and displays its data.
+    /** Displays the periods (passed as a method parameter) in a dialog with a tab for each period.
+     *
+     * Tabs are lightweight tab bar entries that share one weather table; the table is filled only with the period of the
+    tab currently shown, so opening the dialog does not depend on the total number of days in the periods.
      *
      * @param - A vector of periods to be displayed.
      */
-    void displayWeatherPeriods(std::vector<CWather> periodsArr);
+    void displayWeatherPeriods(const std::vector<WeatherView>& periodsArr);
 
 
     /** This method is used to create and configure a QTableWidget (table).
@@ -167,7 +191,78 @@ public:
      *
      * @return A pointer to the created table.
      */
-    QTableWidget* createWeatherTable(CWather weather);
+    QTableWidget* createWeatherTable(const WeatherView& weather);
+
+
+    /** Builds the overlays drawn over a weather graph (moving averages, if they are switched on in the Graphs menu).
+     *
+     * @param column - The weather column the graph is built for.
+     *
+     * @return Overlays for the graph (empty if none are switched on).
+     */
+    std::vector<graphOverlay> getGraphOverlays(WeatherColumn column) const;
+
+
+    /** Hides the rows of the main weather table that do not match the active filter (shows all rows if there is no filter).
+     *
+     * Called after the main weather table is refilled, so the filter stays applied to new data.
+     */
+    void applyTableFilter();
+
+
+    /// Writes the main weather object back into the dataset as the data of the station shown in the table.
+    void storeCurrentStation();
+
+
+    /** Shows a station of the dataset in the main weather table.
+     *
+     * @param stationIndex - The index of the station.
+     */
+    void showStation(int stationIndex);
+
+
+    /// Fills the station selector with the stations of the dataset (it is shown only when there are several stations).
+    void updateStationComboBox();
+
+
+    /** Reads the dataset from a text file and shows its first station in the main weather table.
+     *
+     * @param fileName - The name of the file.
+     * @param isTemporaryFile - Whether the file is deleted after it is read (it is then neither cached nor followed).
+     */
+    void openDatasetFile(const QString& fileName, bool isTemporaryFile = false);
+
+
+    /// Waits for the background compaction of the journal (if one is running) and replaces the file with its result.
+    void finishJournalCompaction();
+
+
+    /// Waits for the background save (if one is running) and reports its error.
+    void finishBackgroundSave();
+
+
+    /// Adds the days appended to the followed file to the dataset and to the end of the main weather table.
+    void readFollowedFile();
+
+
+    /// Stops following the opened file.
+    void stopFollowingFile();
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+protected:
+
+// (Protected) Methods section:
+
+
+    /** Closes the window only when the background save has finished: a close requested during the save is done when it
+    finishes, and the errors of the save and of the compaction of the journal are reported while the window is alive.
+     *
+     * @param event - The close event (ignored while the file is being saved).
+     */
+    void closeEvent(QCloseEvent* event) override;
 
 
 // -------------------------------------------------------------------------------------------------------------------------
@@ -217,6 +312,78 @@ private slots:
     /// Predict the weather for the next month, taking into account the change of season, and write it at the end of the table.
     void on_actionForecast_weathe_for_next_month_triggered();
 
+    /// Run an ensemble forecast for a number of days chosen by the user and plot its p10/p50/p90 bands.
+    void on_actionForecast_ensemble_triggered();
+
+    /// Compute the 7/30/365-day rolling statistics of a weather parameter chosen by the user and show the latest values.
+    void on_actionRolling_statistics_triggered();
+
+    /// Show the weekly, monthly, seasonal or yearly summary (days, mean, min, max) of a weather parameter chosen by the user.
+    void on_actionRollup_summary_triggered();
+
+    /// Compiles the expression from the filter bar and shows only the days of the main weather table that match it.
+    void on_applyFilterButton_clicked();
+
+    /// Same as the Filter button (Enter pressed in the filter bar).
+    void on_filterLineEdit_returnPressed();
+
+    /// Removes the filter and shows all days of the main weather table.
+    void on_clearFilterButton_clicked();
+
+    /// Shows the station chosen in the station selector in the main weather table.
+    void on_stationComboBox_currentIndexChanged(int index);
+
+    /// Adds a new station without data to the dataset and shows it in the main weather table.
+    void on_actionAdd_station_triggered();
+
+    /// Run the analyses of every station in parallel and show the per-station and network summaries.
+    void on_actionNetwork_summary_triggered();
+
+    /// Plot a weather parameter of several stations aligned by date (every station, their mean or a difference of two).
+    void on_actionCompare_stations_triggered();
+
+    /// Report missing days, duplicate dates and days out of date order, and fill the missing days if the user wants to.
+    void on_actionCheck_dates_triggered();
+
+    /// Let the user choose how analyses of consecutive days treat missing days.
+    void on_actionMissing_days_in_analyses_triggered();
+
+    /// Show the p5, median and p95 of temperature, pressure and humidity over a range of months of one or all stations.
+    void on_actionPercentiles_triggered();
+
+    /// Plot the wind rose (direction frequencies) of every season and of the whole year.
+    void on_actionWind_rose_triggered();
+
+    /// Show how long each wind direction lasted and how often it changed to every other direction on the next day.
+    void on_actionWind_persistence_triggered();
+
+    /// Write the main weather to a file in the compact binary format.
+    void on_actionSave_as_binary_triggered();
+
+    /// Run the main analyses over a text or binary file in one streaming pass, without loading it into the table.
+    void on_actionAnalyse_file_triggered();
+
+    /// Sort several files by date in bounded memory, merge them into one series and open it.
+    void on_actionOpen_and_merge_triggered();
+
+    /// Save only the changes since the last save to the journal of the file (the first save writes the whole file).
+    void on_actionJournaled_save_triggered();
+
+    /// Turn on or off following the opened file: days appended to it by other programs are added to the table.
+    void on_actionFollow_file_triggered();
+
+    /// Plots a graph of a derived column chosen by the user (dew point, heat index, pressure tendency, temperature anomaly).
+    void on_actionBuild_graph_of_derived_column_triggered();
+
+    /// Within a season (3 months), sort the records by a derived column chosen by the user and update the main weather table.
+    void on_actionSort_by_derived_column_within_seasons_triggered();
+
+    /// Replay the history of the table: forecast every month from the days before it and show how far off the forecasts were.
+    void on_actionBacktest_forecasts_triggered();
+
+    /// Find heat waves, cold spells and pressure falls by the limits chosen by the user (in every station) and list them.
+    void on_actionFind_extreme_events_triggered();
+
 
 // -------------------------------------------------------------------------------------------------------------------------
 
@@ -232,6 +399,45 @@ private:
     /// A weather class object for basic work with weather data.
     CWather mainWeather;
 
+    /// Weather data of all stations (the station shown in the table is kept in mainWeather until it is stored back).
+    CWeatherDataset dataset;
+
+    /// The index of the station shown in the main weather table.
+    int currentStation = 0;
+
+    /// The filter applied to the main weather table (nullptr if all days are shown).
+    std::shared_ptr<const CWeatherQuery> tableFilter;
+
+    /// How analyses of consecutive days treat missing days, duplicate dates and days out of date order.
+    DayContinuity analysisContinuity = AssumeConsecutiveDays;
+
+    /// The journal of the opened file (inactive if the file has no journal and no journaled save has been made).
+    CWeatherJournal journal;
+
+    /// Watches the background compaction of the journal.
+    QFutureWatcher<CWeatherJournal::compactionResult> compactionWatcher;
+    bool isCompactionRunning = false;
+
+    /// Watches the background save and shows its progress in the status bar.
+    QFutureWatcher<QString> saveWatcher;
+    QProgressBar* saveProgressBar;
+    bool isSaveRunning = false;
+
+    /// True if the window was closed while the file was being saved (it is closed when the save finishes).
+    bool isCloseRequested = false;
+
+    /// The opened text file, the size that has been read from it and the station of its last station line.
+    QString openedFileName;
+    qint64 openedFileSize = 0;
+    QString openedFileStation;
+
+    /// Reads the days appended to the opened file while it is followed (nullptr if it is not followed).
+    std::unique_ptr<CWeatherFileFollower> fileFollower;
+    QFileSystemWatcher fileWatcher;
+
+    /// Writes the dataset of the last opened file to the cache in the background (waited for when the window is closed).
+    QFuture<void> cacheWrite;
+
 
 // -------------------------------------------------------------------------------------------------------------------------
 
@@ -0,0 +1,101 @@
+#ifndef ROLLINGSTATISTICS_H
+#define ROLLINGSTATISTICS_H
+
+#include "weatherview.h"
+
+
+/** @brief Streaming rolling-window statistics of a weather column.
+ *
+ * Computes the moving average, moving standard deviation and moving minimum/maximum of a column for several window sizes
+in one pass over the days. Extremes are kept in monotonic deques and moments in exact integer sums, so each day costs O(1)
+per window whatever the window size is.
+ */
+class CRollingStatistics
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// This struct represents the statistics of one window size. Element i describes the window of days i .. i + m_windowSize - 1.
+    struct rollingWindow
+    {
+        /// The number of days in the window.
+        int m_windowSize = 0;
+        /// Moving average of the column.
+        std::vector<double> m_mean;
+        /// Moving (population) standard deviation of the column.
+        std::vector<double> m_stdDev;
+        /// Moving minimum and maximum of the column.
+        std::vector<int> m_min, m_max;
+    };
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Constructors section:
+
+
+    /** @brief Constructor with parameters
+     *
+     * Computes the statistics of all window sizes in one pass over the column.
+     *
+     * @param weather - Weather days (in the order they follow each other).
+     * @param column - The column the statistics are computed for.
+     * @param windowSizes - Window sizes in days (sizes less than 1 or greater than the number of days give empty statistics).
+     */
+    CRollingStatistics(const WeatherView& weather, WeatherColumn column, const std::vector<int>& windowSizes);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /** Used to get the number of window sizes.
+     *
+     * @return The number of window sizes passed to the constructor.
+     */
+    int getWindowCount() const;
+
+
+    /** Used to get the statistics of a certain window size.
+     *
+     * @param index - The index of the window size (in the order they were passed to the constructor).
+     */
+    const rollingWindow& getWindow(int index) const;
+
+
+    /** Builds graph overlays with the moving averages of all window sizes.
+     *
+     * @return One overlay per window size, aligned with the last day of each window.
+     */
+    std::vector<graphOverlay> getMovingAverageOverlays() const;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) class field:
+
+
+    /// Statistics of each window size.
+    std::vector<rollingWindow> windows;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // ROLLINGSTATISTICS_H
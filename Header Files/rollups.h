@@ -0,0 +1,199 @@
+#ifndef ROLLUPS_H
+#define ROLLUPS_H
+
+#include "weatherview.h"
+#include "valuehistogram.h"
+#include <array>
+
+
+/** @brief Materialized weekly, monthly, seasonal and yearly aggregates of weather data.
+ *
+ * For every week (ISO 8601), month, season (December belongs to the winter of the next year) and year the rollups keep
+the number of days and the sum, minimum, maximum and mean of temperature, pressure and humidity. They are built in one pass
+and updated day by day when days are appended, so reports and graphs over long ranges read a few hundred buckets instead of
+every day.
+ *
+ * Every month also keeps exact histograms of the columns; the percentiles of any range of months (and of seasons and years)
+are read from the merged histograms of its months.
+ */
+class CWeatherRollups
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// Number of rollup periods (RollupPeriod values 0..3).
+    static const int ROLLUP_PERIOD_CNT = 4;
+
+    /// Number of aggregated columns (WeatherColumn values 1..3).
+    static const int COLUMN_CNT = 3;
+
+
+    /// This struct represents the aggregates of one weather column within a bucket.
+    struct columnAggregate
+    {
+        /// Sum of the column values (exact, the values are integers).
+        long long m_sum = 0;
+        /// Minimum and maximum of the column values.
+        int m_min = 0, m_max = 0;
+    };
+
+
+    /// This struct represents the aggregates of one calendar period (a week, month, season or year).
+    struct rollupBucket
+    {
+        /// The year of the period (the ISO week-numbering year for weeks, the year of January for seasons).
+        int m_year = 0;
+        /// The number of the period within the year (week 1 - 53, Month, Season, or 0 for years).
+        int m_number = 0;
+        /// The number of days in the bucket.
+        int m_count = 0;
+        /// Aggregates of temperature, pressure and humidity (indexed by WeatherColumn - 1).
+        std::array<columnAggregate, COLUMN_CNT> m_columns {};
+
+        /** Used to get the mean of a column within the bucket.
+         *
+         * @param column - The weather column.
+         */
+        double getMean(WeatherColumn column) const;
+
+        /** Used to get the aggregates of a column within the bucket.
+         *
+         * @param column - The weather column.
+         */
+        const columnAggregate& getColumn(WeatherColumn column) const;
+    };
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Constructors section:
+
+
+    /// Default constructor (no buckets).
+    CWeatherRollups();
+
+
+    /** @brief Constructor with parameters
+     *
+     * Builds the buckets of all periods in one pass over the days.
+     *
+     * @param weather - Weather days (days with invalid dates are skipped).
+     */
+    explicit CWeatherRollups(const WeatherView& weather);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /** @brief Adds one day to the buckets of all periods.
+     *
+     * Days added in date order only touch the last bucket of each period, so appending is constant time.
+     *
+     * @param wData - Weather data of the day (skipped if its date is invalid).
+     */
+    void addDay(const CWather::weatherData& wData);
+
+
+    /** Used to get the buckets of a period.
+     *
+     * @param period - The rollup period.
+     *
+     * @return Buckets in date order (only periods with at least one day have a bucket).
+     */
+    const std::vector<rollupBucket>& getBuckets(RollupPeriod period) const;
+
+
+    /** Used to find the bucket a certain date belongs to.
+     *
+     * @param period - The rollup period.
+     * @param date - The date.
+     *
+     * @return Pointer to the bucket, or nullptr if there are no days in that period.
+     */
+    const rollupBucket* findBucket(RollupPeriod period, QDate date) const;
+
+
+    /** Returns a text label of a bucket (e.g. "2023-W05", "01.2023", "Winter 2022/23", "2023").
+     *
+     * @param period - The rollup period the bucket belongs to.
+     * @param bucket - The bucket.
+     */
+    static QString getBucketLabel(RollupPeriod period, const rollupBucket& bucket);
+
+
+    /** Used to get the histogram of a column over a range of months.
+     *
+     * @param column - The weather column.
+     * @param firstMonth - A date in the first month of the range.
+     * @param lastMonth - A date in the last month of the range.
+     *
+     * @return Histogram of the column values of all the days of the months (empty if the dates are invalid).
+     */
+    CValueHistogram getHistogram(WeatherColumn column, QDate firstMonth, QDate lastMonth) const;
+
+
+    /** Used to get the histogram of a column within a month, season or year bucket.
+     *
+     * @param period - The rollup period the bucket belongs to.
+     * @param bucket - The bucket.
+     * @param column - The weather column.
+     *
+     * @return Histogram of the column values of the days of the bucket (empty for weeks, which do not consist of whole
+    months).
+     */
+    CValueHistogram getBucketHistogram(RollupPeriod period, const rollupBucket& bucket, WeatherColumn column) const;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) class field:
+
+
+    /// Buckets of every period (indexed by RollupPeriod), sorted by (m_year, m_number).
+    std::array<std::vector<rollupBucket>, ROLLUP_PERIOD_CNT> buckets;
+
+    /// Histograms of temperature, pressure and humidity of every month (in the order of the month buckets).
+    std::vector<std::array<CValueHistogram, COLUMN_CNT>> monthHistograms;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Private) Methods section:
+
+
+    /** Used to get the year and number of the period a date belongs to.
+     *
+     * @param period - The rollup period.
+     * @param date - A valid date.
+     *
+     * @return A pair (year, number within the year).
+     */
+    static std::pair<int, int> getBucketKey(RollupPeriod period, QDate date);
+
+
+    /// CWeatherCache stores the buckets and the histograms, and restores them without rebuilding.
+    friend class CWeatherCache;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // ROLLUPS_H
@@ -0,0 +1,72 @@
+#ifndef VALUEHISTOGRAM_H
+#define VALUEHISTOGRAM_H
+
+#include <utility>
+#include <vector>
+
+
+/** @brief Exact histogram of integer values.
+ *
+ * Weather values are integers with small ranges (degrees, mmHg, per cent), so a histogram keeps one counter per value
+between the smallest and the largest added value. Histograms are merged by adding their counters, so the percentiles of a
+long period are read from the merged histograms of its parts without sorting the days; the result is exact.
+ *
+ * The counters cover at most MAX_DENSE_RANGE values; a value that would stretch them further (e.g. a damaged day) is
+counted separately, so one outlier cannot allocate a counter for every value between it and the others.
+ */
+class CValueHistogram
+{
+public:
+
+    /// The largest number of values covered by the counters.
+    static constexpr int MAX_DENSE_RANGE = 4096;
+
+
+    /// Default constructor (empty histogram).
+    CValueHistogram();
+
+
+    /** Adds values to the histogram.
+     *
+     * @param value - The value.
+     * @param count - How many times the value is added.
+     */
+    void add(int value, int count = 1);
+
+
+    /// Adds the counters of another histogram to this one.
+    CValueHistogram& operator+=(const CValueHistogram& other);
+
+
+    /// Used to get the number of added values.
+    int getCount() const;
+
+
+    /** Used to get a percentile of the added values (nearest rank: the smallest value that at least 'percent' per cent of
+    the values do not exceed).
+     *
+     * @param percent - The percentile (0 - 100).
+     *
+     * @return The percentile, or 0 if the histogram is empty.
+     */
+    int getPercentile(double percent) const;
+
+private:
+
+    /// The value of the first counter.
+    int firstValue;
+
+    /// Counters of the values firstValue, firstValue + 1, ...
+    std::vector<int> counts;
+
+    /// Counters of the values outside the range of 'counts' (pairs of a value and its count, ordered by the value).
+    std::vector<std::pair<int, int>> outliers;
+
+    /// The number of added values.
+    int totalCount;
+
+    /// CWeatherCache stores the counters and restores them.
+    friend class CWeatherCache;
+};
+
+#endif // VALUEHISTOGRAM_H
@@ -0,0 +1,167 @@
+#ifndef WEATHERCACHE_H
+#define WEATHERCACHE_H
+
+#include "weatherdataset.h"
+#include <QFuture>
+
+
+/** @brief On-disk cache of opened weather files, keyed by the content of the file.
+ *
+ * Reading a large text file and building the data derived from it (rollups, forecast climatology, the runs found by the
+wind and stable-period analyses) is done once: the results are written to a cache file named by a 64-bit xxHash of the
+content. When a file with the same content is opened again, the cache file is mapped into memory and the days and the
+derived data are copied out of it, so nothing is parsed or rebuilt. A changed file has another hash and simply misses the
+cache.
+ *
+ * Cache files are written by the machine that reads them, so the values are stored in memory layout (the layout and the
+version are checked, and a cache that does not match is ignored). Only the last MAX_FILE_COUNT cache files are kept.
+ */
+class CWeatherCache
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// The number of cache files kept in the cache directory (the least recently written ones are removed).
+    static const int MAX_FILE_COUNT = 16;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Constructors section:
+
+
+    /// Default constructor (no file; load() returns False).
+    CWeatherCache();
+
+
+    /** @brief Constructor with parameters
+     *
+     * Reads the whole file (mapped into memory) to compute its hash.
+     *
+     * @param fileName - The name of the weather file.
+     *
+     * @throw QString - If the file could not be read.
+     */
+    explicit CWeatherCache(const QString& fileName);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /** @brief Reads the dataset of the file from the cache
+     *
+     * @param dataset - The dataset that receives the stations (with their rollups, forecast climatology and analysis runs
+    already built). It is not changed if the cache is missed.
+     *
+     * @return True if the cache had the file, False otherwise (no cache file, or a damaged or outdated one).
+     */
+    bool load(CWeatherDataset& dataset) const;
+
+
+    /** @brief Writes the dataset of the file to the cache
+     *
+     * The data derived from the days is built first (stations in parallel), so the dataset can also use it afterwards.
+     *
+     * @param dataset - The dataset read from the file.
+     *
+     * @throw QString - If the cache file could not be written.
+     */
+    void save(const CWeatherDataset& dataset) const;
+
+
+    /** @brief Writes the dataset of the file to the cache in a background thread
+     *
+     * The dataset is copied when the function is called (a constant-time copy). Errors are ignored: a missing cache file only
+    means the next open reads the file again.
+     *
+     * @param dataset - The dataset read from the file.
+     *
+     * @return The future of the background write.
+     */
+    QFuture<void> saveInBackground(const CWeatherDataset& dataset) const;
+
+
+    /// Used to get the size of the file when its hash was computed (in bytes).
+    qint64 getFileSize() const;
+
+
+    /// Used to get the directory of the cache files.
+    static QString getCacheDirectory();
+
+
+    /** Computes the 64-bit xxHash (XXH64) of data.
+     *
+     * @param data - The data.
+     * @param size - The size of the data (in bytes).
+     * @param seed - The seed of the hash.
+     *
+     * @return The hash.
+     */
+    static quint64 hash(const uchar* data, qint64 size, quint64 seed = 0);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) class field:
+
+
+    /// The hash and the size of the content of the file (the size is -1 if there is no file).
+    quint64 contentHash;
+    qint64 fileSize;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Private) Methods section:
+
+
+    /// Used to get the name of the cache file of the content.
+    QString getCacheFileName() const;
+
+
+    /** Writes the days of a station and the data derived from them.
+     *
+     * @param weather - The weather data of the station (its caches are built).
+     * @param data - The content of the cache file the station is added to.
+     */
+    static void appendWeather(const CWather& weather, QByteArray& data);
+
+
+    /** Reads the days of a station and the data derived from them.
+     *
+     * @param position - The position in the mapped cache file (moved after the station).
+     * @param end - The end of the mapped cache file.
+     *
+     * @throw QString - If the cache file ends too early.
+     *
+     * @return The weather data of the station with its caches.
+     */
+    static CWather readWeather(const uchar*& position, const uchar* end);
+
+
+    /// Removes the least recently written cache files above MAX_FILE_COUNT.
+    static void removeOldFiles();
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // WEATHERCACHE_H
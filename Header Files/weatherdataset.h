@@ -0,0 +1,266 @@
+#ifndef WEATHERDATASET_H
+#define WEATHERDATASET_H
+
+#include "weatherview.h"
+#include "rollups.h"
+#include <QtConcurrent>
+#include <numeric>
+
+
+/** @brief Weather data of a network of stations.
+ *
+ * The dataset is partitioned by station: every station has its own CWather series, so analyses of different stations are
+independent and run in parallel on all cores; their results are merged into network summaries at the end.
+ *
+ * In text files every station starts with a line "station <id>" followed by its days in the usual format (year month day t
+pressure humidity wind direction). A file without station lines is read as one unnamed station, and a dataset with one
+unnamed station is written without them, so single-station files stay compatible.
+ */
+class CWeatherDataset
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// This struct represents the weather series of one station.
+    struct station
+    {
+        /// The station identifier (empty for an unnamed station).
+        QString m_id;
+        /// Weather data of the station.
+        CWather m_weather;
+    };
+
+
+    /// This struct represents the results of the analyses of one station (or of the whole network, when merged).
+    struct stationSummary
+    {
+        /// The station identifier.
+        QString m_stationId;
+        /// The number of days and the number of stations the summary covers.
+        int m_dayCount = 0, m_stationCount = 0;
+        /// The first and the last date of the data.
+        QDate m_firstDate, m_lastDate;
+        /// Exact sums of temperature and pressure (kept so summaries can be merged without losing precision).
+        long long m_temperatureSum = 0, m_pressureSum = 0;
+        /// The highest humidity and the number of days it was observed.
+        int m_maxHumidity = 0, m_maxHumidityDayCount = 0;
+        /// The number of periods when the wind direction did not change.
+        int m_windNotChangePeriodCount = 0;
+        /// The number of periods when the pressure varied within ±2.5% and t within ±3.6%.
+        int m_stablePeriodCount = 0;
+
+        /// Used to get the average temperature (rounded to two decimal places).
+        double getAvgTemperature() const;
+
+        /// Used to get the average pressure (rounded to two decimal places).
+        double getAvgPressure() const;
+    };
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Constructors section:
+
+
+    /// Default constructor (one unnamed station without data).
+    CWeatherDataset();
+
+
+    /** @brief Constructor with parameters
+     *
+     * @param stations - The stations of the dataset (one unnamed station without data if there are none).
+     */
+    explicit CWeatherDataset(std::vector<station> stations);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /** Used to get the number of stations.
+     *
+     * @return The number of stations (at least 1).
+     */
+    int getStationCount() const;
+
+
+    /** Used to get a station.
+     *
+     * @param index - The index of the station.
+     */
+    const station& getStation(int index) const;
+
+
+    /** Used to find a station by its identifier.
+     *
+     * @param stationId - The station identifier.
+     *
+     * @return The index of the station, or -1 if there is no such station.
+     */
+    int findStation(const QString& stationId) const;
+
+
+    /** Adds a station without data to the end of the dataset.
+     *
+     * @param stationId - The station identifier.
+     *
+     * @throw QString - If the identifier is empty, contains line breaks or is already used.
+     *
+     * @return The index of the new station.
+     */
+    int addStation(const QString& stationId);
+
+
+    /** Replaces the weather data of a station (constant time, the data is shared).
+     *
+     * @param index - The index of the station.
+     * @param weather - New weather data of the station.
+     */
+    void setStationWeather(int index, const CWather& weather);
+
+
+    /** Adds days to the end of the weather data of a station (see CWather::appendDays).
+     *
+     * @param index - The index of the station.
+     * @param days - The days to add.
+     */
+    void appendStationDays(int index, const std::vector<CWather::weatherData>& days);
+
+
+    /** @brief Runs a function for every station in parallel.
+     *
+     * Stations are independent, so the function is called from several threads at once (it must only read the weather data
+    it is given).
+     *
+     * @param function - Function that takes the weather data of a station and returns a result.
+     *
+     * @return Results of the function in the order of the stations.
+     */
+    template <typename Function>
+    auto mapStations(Function function) const -> std::vector<decltype(function(std::declval<const CWather&>()))>
+    {
+        std::vector<decltype(function(std::declval<const CWather&>()))> results(stations.size());
+
+        std::vector<int> indexes(stations.size());
+        std::iota(indexes.begin(), indexes.end(), 0);
+
+        QtConcurrent::blockingMap(indexes, [this, &function, &results](int index) {
+            results[index] = function(stations[index].m_weather);
+        });
+
+        return results;
+    }
+
+
+    /** Runs the analyses of every station in parallel.
+     *
+     * @return Summary of every station (in the order of the stations).
+     */
+    std::vector<stationSummary> getStationSummaries() const;
+
+
+    /** Merges summaries of several stations into a network summary.
+     *
+     * @param summaries - Summaries of the stations.
+     * @param networkId - The identifier written into the merged summary.
+     *
+     * @return Summary of all the days of all the stations.
+     */
+    static stationSummary mergeSummaries(const std::vector<stationSummary>& summaries, const QString& networkId);
+
+
+    /** Used to get the histogram of a column over a range of months (merged from the monthly histograms of the stations).
+     *
+     * @param stationIndex - The index of the station, or -1 for all the stations.
+     * @param column - The weather column.
+     * @param firstMonth - A date in the first month of the range.
+     * @param lastMonth - A date in the last month of the range.
+     *
+     * @return Histogram of the column values of all the days of the months.
+     */
+    CValueHistogram getHistogram(int stationIndex, WeatherColumn column, QDate firstMonth, QDate lastMonth) const;
+
+
+    /// Within a season (3 months), sort the records of every station by Pressure (stations are sorted in parallel).
+    void sortPressureBySeason();
+
+
+    /** Forecasts the weather for the next month of every station and adds it to its data (stations are forecasted in parallel).
+     *
+     * @param seed - The seed of the forecast (every station gets its own random stream of the seed).
+     */
+    void forecastWeatherForNextMonth(quint64 seed);
+
+
+    /** @brief Writes the dataset to a file in a background thread
+     *
+     * The dataset is copied when the function is called (a constant-time copy, the weather data is shared), so it can be
+    changed while the copy is written. The file is written in the same format as the << operator writes, to a temporary
+    file that replaces the target only when it is complete and flushed to the disk; if writing fails, an existing file is
+    left unchanged. The progress of the future goes from 0 to 100.
+     *
+     * @param fileName - The name of the file.
+     *
+     * @return The future description of the error (empty if the file was written).
+     */
+    QFuture<QString> writeFileInBackground(const QString& fileName) const;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Operators section:
+
+
+    /// Reads a dataset from a file (with or without station lines).
+    friend QTextStream& operator>>(QTextStream& inFile, CWeatherDataset& dataset);
+
+
+    /// Writes a dataset to a file.
+    friend QTextStream& operator<<(QTextStream& out, const CWeatherDataset& dataset);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) class field:
+
+
+    /// Stations of the dataset.
+    std::vector<station> stations;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Private) Methods section:
+
+
+    /** Runs the analyses of one station.
+     *
+     * @param weather - Weather data of the station.
+     *
+     * @return Summary of the station (without the station identifier).
+     */
+    static stationSummary summarizeStation(const CWather& weather);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // WEATHERDATASET_H
@@ -0,0 +1,159 @@
+#ifndef WEATHERGAPS_H
+#define WEATHERGAPS_H
+
+#include "weatherview.h"
+
+
+/** @brief Missing and repeated days of weather data.
+ *
+ * The detector turns the dates of the days into a column of ordinal (Julian day) numbers and compares every day with the
+previous one in a single pass: a step of one day is normal, a longer step is a gap, a step of zero is a duplicate date and a
+negative step means the days are out of date order. The days between such breaks form continuous segments.
+ *
+ * Gaps are filled column by column: missing values of temperature, pressure and humidity are interpolated linearly, repeat
+the previous day or are taken from the climatology of the data (wind directions repeat the previous day, or are the most
+frequent direction of the climatology).
+ */
+class CWeatherGaps
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// How missing days are filled.
+    enum fillStrategy
+    {
+        /// Values on a straight line between the days around the gap.
+        LinearFill,
+        /// Values of the day before the gap.
+        PreviousValueFill,
+        /// Mean values of the same day of the year.
+        ClimatologyFill
+    };
+
+
+    /// This struct represents a run of missing days.
+    struct dateGap
+    {
+        /// The index of the day after the gap (the day before it has index m_index - 1).
+        int m_index = 0;
+        /// The number of missing days.
+        int m_missingDayCount = 0;
+    };
+
+
+    /// This struct represents a run of consecutive days.
+    struct daySegment
+    {
+        /// The index of the first day of the segment.
+        int m_firstIndex = 0;
+        /// The number of days in the segment.
+        int m_dayCount = 0;
+    };
+
+
+    /// This struct represents weather data with filled gaps.
+    struct filledWeather
+    {
+        /// Weather data for every day from the first to the last date (in date order, without duplicates).
+        CWather m_weather;
+        /// For every day of m_weather, the index of the day of the original view it comes from (-1 for a filled day).
+        std::vector<int> m_sourceIndexes;
+    };
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Constructors section:
+
+
+    /** @brief Constructor with parameters
+     *
+     * Finds the gaps, duplicate dates and out of order days of the weather data.
+     *
+     * @param weather - Weather days (expected to be in date order).
+     */
+    explicit CWeatherGaps(const WeatherView& weather);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /// Used to get the runs of missing days (in the order of the days).
+    const std::vector<dateGap>& getGaps() const;
+
+
+    /// Used to get the indexes of the days with the same date as the previous day.
+    const std::vector<int>& getDuplicateIndexes() const;
+
+
+    /// Used to get the indexes of the days with an earlier date than the previous day (or with an invalid date).
+    const std::vector<int>& getOutOfOrderIndexes() const;
+
+
+    /// Used to get the runs of consecutive days (together they cover all the days).
+    const std::vector<daySegment>& getSegments() const;
+
+
+    /// Used to get the total number of missing days.
+    int getMissingDayCount() const;
+
+
+    /** Determine if the days follow each other without gaps, duplicates and order breaks.
+     *
+     * @return True if all the days form one segment, False otherwise.
+     */
+    bool isContinuous() const;
+
+
+    /** @brief Fills the gaps of weather data.
+     *
+     * The days are put in date order first; of several days with the same date the first one is kept, and days with
+    invalid dates are dropped.
+     *
+     * @param weather - Weather days with gaps.
+     * @param strategy - How the missing days are filled.
+     *
+     * @return Weather data for every day from the first to the last date, and where each day comes from.
+     */
+    static filledWeather fillGaps(const WeatherView& weather, fillStrategy strategy);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) class field:
+
+
+    /// Runs of missing days.
+    std::vector<dateGap> gaps;
+
+    /// Indexes of the days with the same date as the previous day.
+    std::vector<int> duplicateIndexes;
+
+    /// Indexes of the days with an earlier (or invalid) date than the previous day.
+    std::vector<int> outOfOrderIndexes;
+
+    /// Runs of consecutive days.
+    std::vector<daySegment> segments;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // WEATHERGAPS_H
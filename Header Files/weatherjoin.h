@@ -0,0 +1,171 @@
+#ifndef WEATHERJOIN_H
+#define WEATHERJOIN_H
+
+#include "weatherview.h"
+
+
+/** @brief Several weather series aligned by date.
+ *
+ * The series (e.g. of different stations) are joined by a merge join on their ordinal (Julian day) dates, so day i of the
+join is the same calendar day in every series. A day that one of the series does not have is skipped, kept as a gap or
+filled with the previous day of that series, depending on the missing day policy.
+ *
+ * The join stores only the dates and, for every series, the indexes of its days; values are read from the joined views,
+so no weather data is copied.
+ */
+class CWeatherJoin
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// What to do with a day that some of the series do not have.
+    enum missingDayPolicy
+    {
+        /// Keep only the days every series has.
+        SkipMissingDays,
+        /// Keep every day of any series; the series without it have a gap there.
+        KeepMissingDays,
+        /// Keep every day of any series; the series without it repeat their previous day (gaps remain only before the
+        /// first day of a series).
+        FillMissingDays
+    };
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Constructors section:
+
+
+    /** @brief Constructor with parameters
+     *
+     * Joins the series by date. Days with invalid dates are ignored, and if a series has several days with the same date,
+    the first of them is used.
+     *
+     * @param series - Weather series to join (they do not have to be sorted by date).
+     * @param policy - What to do with a day that some of the series do not have.
+     */
+    CWeatherJoin(std::vector<WeatherView> series, missingDayPolicy policy);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /// Used to get the number of joined series.
+    int getSeriesCount() const;
+
+
+    /// Used to get the number of days of the join.
+    int getDayCount() const;
+
+
+    /// Used to get the date of a certain day of the join.
+    QDate getDate(int day) const;
+
+
+    /// Used to get the dates of all the days of the join (in ascending order).
+    std::vector<QDate> getDates() const;
+
+
+    /** Used to get the index of the day of a series that is aligned with a certain day of the join.
+     *
+     * @param seriesIndex - The index of the series.
+     * @param day - The index of the day of the join.
+     *
+     * @return The index of the day in the series view, or -1 if the series has a gap there.
+     */
+    int getRowIndex(int seriesIndex, int day) const;
+
+
+    /// Determine if a series has a value for a certain day of the join.
+    bool hasValue(int seriesIndex, int day) const;
+
+
+    /** Used to get the value of a weather column of a series for a certain day of the join.
+     *
+     * @param seriesIndex - The index of the series.
+     * @param column - The column (temperature, pressure or humidity).
+     * @param day - The index of the day of the join (the series must have a value there).
+     */
+    int getValue(int seriesIndex, WeatherColumn column, int day) const;
+
+
+    /** Used to get a series aligned with the join (no weather data is copied, only the row indexes).
+     *
+     * @param seriesIndex - The index of the series.
+     *
+     * @throw QString - If the series has gaps.
+     *
+     * @return View whose day i is day i of the join.
+     */
+    WeatherView getAlignedView(int seriesIndex) const;
+
+
+    /** Used to get a column of a series as a graph line.
+     *
+     * @param seriesIndex - The index of the series.
+     * @param column - The column (temperature, pressure or humidity).
+     * @param name - Name of the line.
+     *
+     * @return Line with the values of the days the series has.
+     */
+    graphOverlay getSeriesLine(int seriesIndex, WeatherColumn column, const QString& name) const;
+
+
+    /** Used to get the day-by-day difference of a column between two series as a graph line.
+     *
+     * @param firstSeries - The index of the series the other one is subtracted from.
+     * @param secondSeries - The index of the subtracted series.
+     * @param column - The column (temperature, pressure or humidity).
+     * @param name - Name of the line.
+     *
+     * @return Line with the differences of the days both series have.
+     */
+    graphOverlay getDifferenceLine(int firstSeries, int secondSeries, WeatherColumn column, const QString& name) const;
+
+
+    /** Used to get the day-by-day mean of a column over all the series as a graph line.
+     *
+     * @param column - The column (temperature, pressure or humidity).
+     * @param name - Name of the line.
+     *
+     * @return Line with the mean of the series that have a value for each day.
+     */
+    graphOverlay getMeanLine(WeatherColumn column, const QString& name) const;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) class field:
+
+
+    /// The joined series.
+    std::vector<WeatherView> series;
+
+    /// Ordinal (Julian day) dates of the days of the join.
+    std::vector<qint64> dates;
+
+    /// For every series, the index of its day aligned with each day of the join (-1 for a gap).
+    std::vector<std::vector<int>> rowIndexes;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // WEATHERJOIN_H
@@ -0,0 +1,250 @@
+#ifndef WEATHERJOURNAL_H
+#define WEATHERJOURNAL_H
+
+#include "weatherdataset.h"
+#include <QFuture>
+
+
+/** @brief Journaled storage of a dataset: a base file and an append-only log of changes next to it.
+ *
+ * The base file is an ordinary dataset file. Every save compares the dataset with the last saved one and appends only the
+changed days to "<file>.journal", so saving a small edit costs O(changes) disk writes. Each save is one transaction that
+ends with a "commit" line and is synced to the disk before the save is done; a save interrupted by a crash leaves an
+incomplete transaction, which is dropped when the file is opened. The base file is only replaced as a whole (a complete new file is renamed over it), so it is never left half
+written.
+ *
+ * Journal lines (station and row indexes start from 0; a day is written as in the base file):
+ * - "journal <hash of the base file>" - the first line; a journal of another base file is ignored;
+ * - "set <station> <row> <day>", "insert <station> <row> <day>", "delete <station> <row> <row count>";
+ * - "station <id>" - adds a station;
+ * - "commit <number of lines of the transaction>".
+ *
+ * When the journal grows large compared to the base file it is compacted in the background: the saved dataset is written
+to "<file>.compact" and synced to the disk, and then the compacted file is renamed over the base file and the journal starts
+again with the transactions saved in the meantime.
+ */
+class CWeatherJournal
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// This struct represents the result of a save.
+    struct saveResult
+    {
+        /// The number of journal lines written (without the commit line).
+        int m_changeCount = 0;
+        /// The number of bytes written.
+        qint64 m_writtenBytes = 0;
+        /// True if the whole base file was written instead of appending to the journal.
+        bool m_isFullWrite = false;
+    };
+
+
+    /// This struct represents the result of writing a compacted base file in the background.
+    struct compactionResult
+    {
+        /// The save the compacted file was written for (results of earlier saves are dropped).
+        int m_fullWriteNumber = 0;
+        /// The size of the journal when the compaction started (later transactions are kept).
+        qint64 m_journalSize = 0;
+        /// The hash of the compacted file.
+        QByteArray m_hash;
+        /// The size of the compacted file.
+        qint64 m_size = 0;
+        /// Description of the error (empty if the file was written).
+        QString m_error;
+    };
+
+
+    /// The journal is compacted when it is larger than the base file divided by this ratio...
+    static const int COMPACTION_RATIO = 4;
+
+    /// ...and larger than this size (in bytes).
+    static const qint64 MIN_COMPACTION_SIZE = 64 << 10;
+
+    /// The longest insertion or deletion recognised between two saves (longer ones are written as changed days).
+    static const int RESYNC_DISTANCE = 64;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Constructors section:
+
+
+    /// Default constructor (no file; isActive() returns False).
+    CWeatherJournal();
+
+
+    /** @brief Constructor with parameters
+     *
+     * Nothing is read or written until open() or save() is called.
+     *
+     * @param fileName - The name of the base file.
+     */
+    explicit CWeatherJournal(const QString& fileName);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /// Determine if a file has a journal (or an unfinished compaction) next to it.
+    static bool hasJournal(const QString& fileName);
+
+
+    /** @brief Opens the base file and applies the journal to it
+     *
+     * Finishes a compaction interrupted by a crash, drops an incomplete or damaged tail of the journal and ignores a journal
+    of another base file (e.g. when the base file was replaced by an ordinary save).
+     *
+     * @throw QString - If the files could not be read or the journal could not be repaired.
+     *
+     * @return The saved dataset.
+     */
+    CWeatherDataset open();
+
+
+    /** @brief Saves a dataset
+     *
+     * Appends the changes since the last save to the journal. The whole base file is written (and the journal started
+    again) on the first save and when the changes cannot be expressed in the journal (removed or renamed stations).
+     *
+     * @param dataset - The dataset to save.
+     *
+     * @throw QString - If the file could not be written.
+     *
+     * @return The size of the save.
+     */
+    saveResult save(const CWeatherDataset& dataset);
+
+
+    /// Determine if the journal has a base file.
+    bool isActive() const;
+
+
+    /// Used to get the name of the base file.
+    QString getFileName() const;
+
+
+    /// Determine if the journal is large enough to be compacted (and no compaction is running).
+    bool isCompactionNeeded() const;
+
+
+    /** @brief Starts writing a compacted base file in a background thread
+     *
+     * @return The future result, which is passed to finishCompaction() in the main thread.
+     */
+    QFuture<compactionResult> startCompaction();
+
+
+    /** @brief Replaces the base file with the compacted file
+     *
+     * Keeps the transactions saved while the compacted file was written. Results of a compaction that was overtaken by a
+    full write of the base file are dropped.
+     *
+     * @param result - The result of the background part of the compaction.
+     *
+     * @throw QString - If the compaction failed (the base file and the journal remain valid).
+     */
+    void finishCompaction(const compactionResult& result);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) class field:
+
+
+    /// The name of the base file.
+    QString fileName;
+
+    /// The dataset as it is saved in the files.
+    CWeatherDataset savedDataset;
+
+    /// The hash and the size of the base file (an empty hash if the base file has not been written by the journal).
+    QByteArray baseHash;
+    qint64 baseSize;
+
+    /// The size of the journal.
+    qint64 journalSize;
+
+    /// The number of full writes of the base file and True while a compaction is running.
+    int fullWriteNumber;
+    bool isCompacting;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Private) Methods section:
+
+
+    /// Used to get the names of the files next to the base file.
+    QString getJournalFileName() const;
+    QString getNewJournalFileName() const;
+    QString getCompactFileName() const;
+
+
+    /** Writes the whole dataset to the base file and starts a new journal.
+     *
+     * @throw QString - If the files could not be written.
+     */
+    void writeBase(const CWeatherDataset& dataset);
+
+
+    /** Applies the complete transactions of the journal to the saved dataset.
+     *
+     * Replaying stops at the first incomplete or damaged transaction (including a committed one that does not fit the
+dataset), so the saved dataset holds only the transactions applied in full.
+     *
+     * @param journalData - The content of the journal.
+     *
+     * @return The size of the applied transactions (the rest of the journal is dropped).
+     */
+    qint64 replay(const QByteArray& journalData);
+
+
+    /** Writes the dataset in the text format.
+     *
+     * @param dataset - The dataset.
+     *
+     * @return The content of the file.
+     */
+    static QByteArray formatDataset(const CWeatherDataset& dataset);
+
+
+    /// Writes a day as in the base file.
+    static QByteArray formatDay(const CWather::weatherData& wData);
+
+
+    /** Writes the changes of a station.
+     *
+     * @param stationIndex - The index of the station.
+     * @param savedWeather - The saved days of the station.
+     * @param weather - The current days of the station.
+     * @param lines - The journal lines the changes are added to.
+     *
+     * @return The number of added lines.
+     */
+    static int formatStationChanges(int stationIndex, const CWather& savedWeather, const CWather& weather, QByteArray& lines);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // WEATHERJOURNAL_H
@@ -0,0 +1,205 @@
+#ifndef WEATHERQUERY_H
+#define WEATHERQUERY_H
+
+#include "weatherview.h"
+#include <memory>
+
+
+/** @brief Set of selected days stored as a bitmap (one bit per day).
+ *
+ * Combining selections (and, or, not) works on 64 days at a time.
+ */
+class CSelectionBitmap
+{
+public:
+
+    /** @brief Constructor with parameters
+     *
+     * @param size - The number of days (all of them are not selected).
+     */
+    explicit CSelectionBitmap(int size = 0) : words((size + 63) / 64, 0), size(size)
+    {}
+
+
+    /// Used to get the number of days (selected or not).
+    int getSize() const { return size; }
+
+
+    /// Determine if a certain day is selected.
+    bool isSelected(int index) const { return (words[index >> 6] >> (index & 63)) & 1; }
+
+
+    /// Used to get the number of selected days.
+    int getSelectedCount() const;
+
+
+    /// Used to get the indexes of the selected days (in ascending order).
+    std::vector<int> getSelectedIndexes() const;
+
+
+    /// Keeps selected only the days selected in both bitmaps.
+    CSelectionBitmap& operator&=(const CSelectionBitmap& other);
+
+
+    /// Selects also the days selected in the other bitmap.
+    CSelectionBitmap& operator|=(const CSelectionBitmap& other);
+
+
+    /// Inverts the selection.
+    void invert();
+
+
+    /// Words of the bitmap (bit i of word w is day w * 64 + i; bits past the last day are always 0).
+    std::vector<quint64> words;
+
+private:
+
+    /// The number of days.
+    int size;
+};
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+/** @brief Compiled filter expression over weather columns.
+ *
+ * An expression compares columns with constants and combines the comparisons with "and", "or", "not" and parentheses,
+e.g. "season = winter and pressure > 780 and wind in (N, NE)" or "humidity > 70 and t < 0". Fields: t (temperature),
+pressure, humidity, wind, year, month, day, season and the derived columns dewpoint, heatindex, tendency (pressure tendency)
+and anomaly (temperature anomaly). Operators: =, !=, <, <=, >, >= and "in (value, ...)". Numbers can have a decimal
+fraction (e.g. "dewpoint > 10.5"). Wind directions (N, NE, ...), seasons (winter, spring, summer, autumn) and months
+(january or jan, ...) can be written by name.
+ *
+ * The expression is parsed once. Each comparison is executed as a tight scan over one contiguous column that produces a
+selection bitmap, and the bitmaps are combined word by word. Derived columns are taken from the memoized values of the
+weather object, so they are computed only once for all the queries.
+ */
+class CWeatherQuery
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// Columns a query can filter by.
+    enum queryField
+    {
+        YearField,
+        MonthField,
+        DayField,
+        TemperatureField,
+        PressureField,
+        HumidityField,
+        WindField,
+        SeasonField,
+        DewPointField,
+        HeatIndexField,
+        PressureTendencyField,
+        TemperatureAnomalyField,
+        FIELD_CNT
+    };
+
+
+    /// Comparison operators.
+    enum compareOperator
+    {
+        Equal,
+        NotEqual,
+        Less,
+        LessOrEqual,
+        Greater,
+        GreaterOrEqual
+    };
+
+
+    /// This struct represents a node of a compiled expression.
+    struct queryNode
+    {
+        /// The kind of the node: a comparison of a column with a constant, or a combination of child nodes.
+        enum nodeKind { Compare, And, Or, Not } m_kind = Compare;
+        /// The compared column and operator, and the constant it is compared with (Compare nodes only; it can have a fraction,
+        /// e.g. for the derived columns).
+        queryField m_field = YearField;
+        compareOperator m_operator = Equal;
+        double m_value = 0;
+        /// Child nodes (the right one is not used by Not nodes).
+        std::shared_ptr<const queryNode> m_left, m_right;
+    };
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Constructors section:
+
+
+    /** @brief Constructor with parameters
+     *
+     * Parses and compiles the expression.
+     *
+     * @param expression - The filter expression.
+     *
+     * @throw QString - Description of the error if the expression is invalid.
+     */
+    explicit CWeatherQuery(const QString& expression);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /** Used to get the text of the expression.
+     *
+     * @return The expression the query was compiled from.
+     */
+    QString getExpression() const;
+
+
+    /** Finds the days that match the expression.
+     *
+     * @param weather - Weather days to filter.
+     *
+     * @return Bitmap of the matching days (bit i is day i of 'weather').
+     */
+    CSelectionBitmap evaluate(const WeatherView& weather) const;
+
+
+    /** Finds the days that match the expression.
+     *
+     * @param weather - Weather days to filter.
+     *
+     * @return View of the matching days (in the order of 'weather'; no weather data is copied).
+     */
+    WeatherView select(const WeatherView& weather) const;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) class field:
+
+
+    /// The text of the expression.
+    QString expression;
+
+    /// The root of the compiled expression.
+    std::shared_ptr<const queryNode> root;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // WEATHERQUERY_H
@@ -0,0 +1,247 @@
+#ifndef WEATHERSERVER_H
+#define WEATHERSERVER_H
+
+#include "weatherdataset.h"
+#include <QFutureWatcher>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPointer>
+
+
+/** @brief Headless server that keeps datasets in memory and answers weather queries over a local socket.
+ *
+ * Other tools connect to the local socket (a Unix domain socket on Unix, a named pipe on Windows) instead of parsing the
+files and re-implementing the analyses. A request is one line "<id> <query>", and the answer is one line "<id> ok
+<values...>" or "<id> error <message>". The id is any word chosen by the client and is echoed back, so a client can send many
+requests without waiting for the answers (answers to one connection come in the order of its requests).
+ *
+ * Queries (stations are given by index; dates as yyyy-MM-dd):
+ * - "info" - "<station count>" followed by "<days> <first date> <last date>" of every station;
+ * - "avg <station> <from> <to>" - "<days> <average t> <average pressure>";
+ * - "extremes <station> <from> <to>" - "<days> <min t> <max t> <min pressure> <max pressure> <min humidity> <max humidity>";
+ * - "wind <station> <from> <to>" - periods when the wind direction did not change: "<count> <longest days> <its first date>";
+ * - "stable <station> <from> <to> [<t %> <pressure %>]" - periods when t and pressure changed within the ranges (3.6% and
+2.5% by default): "<count> <longest days> <its first date>";
+ * - "forecast <station> <days> <seed>" - the forecast after the last day: "<days>" followed by "<date>,<t>,<pressure>,
+<humidity>,<wind direction>" of every day.
+ *
+ * Requests that arrive while a batch is being answered are collected into the next batch. Equal queries of a batch are
+answered once, and the different ones are answered in parallel on the global thread pool. All queries share the data of the
+stations, the date indexes built when the server starts and the caches of CWather (e.g. the forecast engine).
+ */
+class CWeatherServer : public QObject
+{
+    Q_OBJECT
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Constructors section:
+
+
+    /** @brief Constructor with parameters
+     *
+     * @param stations - The stations the queries are answered from (the weather data is shared, not copied).
+     * @param parent - The parent object.
+     */
+    explicit CWeatherServer(const std::vector<CWeatherDataset::station>& stations, QObject* parent = nullptr);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /** @brief Starts accepting connections
+     *
+     * @param serverName - The name of the local socket (a stale socket of a crashed server is removed).
+     *
+     * @throw QString - If the socket could not be created.
+     */
+    void listen(const QString& serverName);
+
+
+    /** @brief Answers a query (thread-safe)
+     *
+     * @param query - The query without the request id.
+     *
+     * @return The answer without the request id ("ok <values...>" or "error <message>").
+     */
+    QByteArray answer(const QByteArray& query) const;
+
+
+    /** @brief Runs the server from the command line
+     *
+     * Usage: --serve [--name <name>] <files...> (the stations of all files are served; an unnamed station gets the name of
+    its file).
+     *
+     * @param arguments - The arguments of the application (the first one is the name of the program).
+     *
+     * @return The exit code of the application.
+     */
+    static int runCommandLine(const QStringList& arguments);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private slots:
+
+// (Private) Slots section:
+
+
+    /// Accepts the waiting connections.
+    void acceptConnections();
+
+    /// Collects the complete request lines of a connection.
+    void readRequests();
+
+    /// Sends the answers of the finished batch and starts the next one.
+    void finishBatch();
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) Types section:
+
+
+    /// This struct represents a request waiting for its answer.
+    struct pendingRequest
+    {
+        /// The connection of the request (null if it has been closed).
+        QPointer<QLocalSocket> m_socket;
+        /// The request id and the index of the query in the batch.
+        QByteArray m_id;
+        int m_queryIndex = 0;
+        /// The query.
+        QByteArray m_query;
+    };
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Private) class field:
+
+
+    /// The served stations.
+    std::vector<CWeatherDataset::station> stations;
+
+    /// Dates (Julian days) of the days of every station, or an empty vector if the days of the station are not in date order.
+    std::vector<std::vector<qint64>> stationDates;
+
+    /// The local socket.
+    QLocalServer server;
+
+    /// Requests of the next batch and of the batch being answered.
+    std::vector<pendingRequest> pendingRequests, batchRequests;
+
+    /// Different queries of the batch being answered and their answers.
+    QList<QByteArray> batchQueries;
+    QFutureWatcher<QByteArray> batchWatcher;
+    bool isBatchRunning;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Private) Methods section:
+
+
+    /// Starts answering the pending requests.
+    void startBatch();
+
+
+    /** Used to get the days of a station within a period (found by binary search when the days are in date order).
+     *
+     * @param stationIndex - The index of the station.
+     * @param startDate - The first date of the period.
+     * @param endDate - The last date of the period.
+     *
+     * @return The days of the period.
+     */
+    WeatherView getPeriod(int stationIndex, QDate startDate, QDate endDate) const;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+/** @brief Load generator for CWeatherServer.
+ *
+ * Opens several connections, each in its own thread, and sends a mix of random queries over random periods of the stations,
+keeping a number of requests in flight on every connection. Prints the throughput and the latency percentiles of the
+answers.
+ */
+class CWeatherLoadGenerator
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// This struct represents the result of a load test.
+    struct loadSummary
+    {
+        /// The number of answered requests and of answers with an error.
+        qint64 m_requestCount = 0, m_errorCount = 0;
+        /// The duration of the test (in seconds).
+        double m_seconds = 0;
+        /// Latencies of the answers (in microseconds).
+        double m_p50 = 0, m_p90 = 0, m_p99 = 0, m_max = 0;
+    };
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /** @brief Runs a load test
+     *
+     * @param serverName - The name of the local socket of the server.
+     * @param connectionCount - The number of connections.
+     * @param requestCount - The number of requests sent over every connection.
+     * @param pipelineDepth - The number of requests sent over a connection before waiting for an answer.
+     * @param seed - The seed of the random queries.
+     *
+     * @throw QString - If the server could not be reached or closed a connection.
+     *
+     * @return The throughput and the latencies.
+     */
+    static loadSummary run(const QString& serverName, int connectionCount, int requestCount, int pipelineDepth, quint64 seed);
+
+
+    /** @brief Runs a load test from the command line
+     *
+     * Usage: --load-test [--name <name>] [--connections <n>] [--requests <n>] [--pipeline <n>] [--seed <n>]
+     *
+     * @param arguments - The arguments of the application (the first one is the name of the program).
+     *
+     * @return The exit code of the application.
+     */
+    static int runCommandLine(const QStringList& arguments);
+
+};
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // WEATHERSERVER_H
@@ -0,0 +1,499 @@
+#ifndef WEATHERSTREAM_H
+#define WEATHERSTREAM_H
+
+#include "fusedanalysis.h"
+#include <QFile>
+#include <QSaveFile>
+
+
+/** @brief Reader of weather files that streams days one by one.
+ *
+ * The file is read in large blocks and parsed in place, so reading is bound by the speed of the disk and the memory used
+does not depend on the size of the file. Two formats are read:
+ * - the text format of the application (year month day t pressure humidity wind direction, one day per line; "station
+<id>" lines of multi-station files separate the stations);
+ * - the binary format written by writeBinary(): an 8-byte signature followed by 12-byte little-endian records (year: 4
+bytes, month, day: 1 byte, t: 2 bytes, pressure: 2 bytes, humidity, wind direction: 1 byte).
+ */
+class CWeatherFileReader
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// The size of the blocks the file is read in (in bytes).
+    static const int BLOCK_SIZE = 1 << 22;
+
+    /// The size of a day record in binary files (in bytes).
+    static const int BINARY_RECORD_SIZE = 12;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Constructors section:
+
+
+    /** @brief Constructor with parameters
+     *
+     * Opens the file and detects its format.
+     *
+     * @param fileName - The name of the file.
+     * @param blockSize - The size of the blocks the file is read in (smaller blocks when many files are read at once).
+     *
+     * @throw QString - If the file could not be opened.
+     */
+    explicit CWeatherFileReader(const QString& fileName, int blockSize = BLOCK_SIZE);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /** Reads the next day of the file.
+     *
+     * @param wData - The read day.
+     *
+     * @throw QString - Description of the error if the file is damaged (with the number of the line for text files).
+     *
+     * @return False if there are no more days, True otherwise.
+     */
+    bool readDay(CWather::weatherData& wData);
+
+
+    /// Used to get the number of station lines read so far (days of different stations do not follow each other).
+    int getStationNumber() const;
+
+
+    /// Determine if the file is in the binary format.
+    bool isBinary() const;
+
+
+    /** Writes weather days to a file in the binary format.
+     *
+     * @param fileName - The name of the file.
+     * @param weather - Weather days to write.
+     *
+     * @throw QString - If the file could not be written.
+     */
+    static void writeBinary(const QString& fileName, const WeatherView& weather);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) class field:
+
+
+    /// The read file.
+    QFile file;
+
+    /// The current block of the file and the position of the first unread byte in it.
+    QByteArray buffer;
+    int position;
+
+    /// The size of the blocks the file is read in.
+    int blockSize;
+
+    /// True if the file is in the binary format.
+    bool binary;
+
+    /// True when the whole file has been read into the buffer.
+    bool isFileEnd;
+
+    /// The number of the last read line (text files) and the number of station lines read.
+    int lineNumber, stationNumber;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Private) Methods section:
+
+
+    /** Keeps the unread bytes of the buffer and appends the next block of the file to them.
+     *
+     * @return False if the file has no more data, True otherwise.
+     */
+    bool readNextBlock();
+
+
+    /** Parses one line of a text file.
+     *
+     * @param line - The first character of the line.
+     * @param lineEnd - The character after the last character of the line.
+     * @param wData - The read day.
+     *
+     * @throw QString - If the line is not a day or a station line.
+     *
+     * @return True if the line is a day, False if it is empty or a station line.
+     */
+    bool parseLine(const char* line, const char* lineEnd, CWather::weatherData& wData);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+/** @brief Writer of weather files that streams days one by one.
+ *
+ * Days are formatted into a block in memory and the block is written when it is full, so any number of days can be written
+in bounded memory. Text files are the same as those written by the << operator of CWather (or of CWeatherDataset, when
+station lines are written); binary files can be read by CWeatherFileReader.
+ *
+ * The days are written to a temporary file next to the target, which replaces the target only when close() succeeds (the
+data is flushed to the disk first). A writer that fails or is destroyed before close() leaves an existing file unchanged.
+ */
+class CWeatherFileWriter
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Constructors section:
+
+
+    /** @brief Constructor with parameters
+     *
+     * @param fileName - The name of the file (an existing file is replaced by close()).
+     * @param binary - True to write the binary format, False to write the text format.
+     * @param blockSize - The size of the blocks the file is written in.
+     *
+     * @throw QString - If the file could not be opened.
+     */
+    CWeatherFileWriter(const QString& fileName, bool binary, int blockSize = CWeatherFileReader::BLOCK_SIZE);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /** Adds a day to the file.
+     *
+     * @param wData - The day.
+     *
+     * @throw QString - If a value of the day does not fit into the binary format or the file could not be written.
+     */
+    void writeDay(const CWather::weatherData& wData);
+
+
+    /** Adds a station line ("station <id>") to the file; the days written after it belong to the station.
+     *
+     * @param stationId - The station identifier.
+     *
+     * @throw QString - If the file is in the binary format (it has no stations) or could not be written.
+     */
+    void writeStation(const QString& stationId);
+
+
+    /** Writes the days that have not been written yet and replaces the target file with the written one.
+     *
+     * @throw QString - If the file could not be written.
+     */
+    void close();
+
+
+    /// Used to get the number of written days.
+    qint64 getDayCount() const;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) class field:
+
+
+    /// The written file (a temporary file until it is committed).
+    QSaveFile file;
+
+    /// Days that have not been written yet and the size at which they are written.
+    QByteArray buffer;
+    int blockSize;
+
+    /// True if the file is in the binary format.
+    bool binary;
+
+    /// The number of written days and True if a line has been written (lines of a text file are separated by line ends).
+    qint64 dayCount;
+    bool isLineWritten;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Private) Methods section:
+
+
+    /// Writes the buffer to the file and clears it (throws QString if the file could not be written).
+    void writeBuffer();
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+/** @brief Follows a text weather file that other programs append days to.
+ *
+ * Only the bytes appended since the last read are read and parsed, so following a file costs the same whatever the size
+of its history. A line is read only when its line end has been written (a logger may be in the middle of writing it), and
+days belong to the station of the last station line of the file.
+ */
+class CWeatherFileFollower
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// This struct represents days appended to one station.
+    struct appendedDays
+    {
+        /// The station identifier (empty for days before the first station line).
+        QString m_stationId;
+        /// The days in the order of the file.
+        std::vector<CWather::weatherData> m_days;
+    };
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Constructors section:
+
+
+    /** @brief Constructor with parameters
+     *
+     * @param fileName - The name of the file.
+     * @param position - The size of the part of the file that has already been read.
+     * @param stationId - The station of the last station line in the part that has been read.
+     */
+    CWeatherFileFollower(const QString& fileName, qint64 position, const QString& stationId);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /** Reads the days appended to the file since the last read.
+     *
+     * @throw QString - If the file could not be read, has become shorter (it has been replaced) or an appended line is
+    damaged (the lines before it are not read either).
+     *
+     * @return The appended days grouped by station in the order of the file (a station line starts a new group, even before
+    its first day is appended; empty if nothing has been appended).
+     */
+    std::vector<appendedDays> readAppendedDays();
+
+
+    /// Used to get the size of the part of the file that has been read (a new follower can continue from it).
+    qint64 getPosition() const;
+
+
+    /// Used to get the station of the last read station line.
+    QString getStationId() const;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) class field:
+
+
+    /// The name of the followed file.
+    QString fileName;
+
+    /// The size of the part of the file that has been read (it ends after a line end or where the reading started).
+    qint64 position;
+
+    /// The station of the last read station line.
+    QString stationId;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+/** @brief The analyses of the main window computed while days stream by.
+ *
+ * The average temperature and pressure, the highest humidity days, the periods when the wind direction did not change and
+the periods when the pressure and temperature changed within given limits are all computed in a single pass; only the
+results are kept, so the memory used depends on the number of found days and periods, not on the number of days. The
+results are the same as those of WeatherView for the days of the date window.
+ */
+class CWeatherStreamAnalysis
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// This struct represents a period of days following each other in the file.
+    struct dayPeriod
+    {
+        /// The first and the last date of the period.
+        QDate m_firstDate, m_lastDate;
+        /// The number of days in the period.
+        int m_dayCount = 0;
+        /// The wind direction of the period (only for periods when the wind direction did not change).
+        WindDirection m_windDirection = Undefined;
+    };
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Constructors section:
+
+
+    /** @brief Constructor with parameters
+     *
+     * @param startDate - The first date of the analysed window.
+     * @param endDate - The last date of the analysed window.
+     * @param tRangePct - Percentage points within which the temperature can change in a stable period.
+     * @param psreRangePct - Percentage points within which the pressure can change in a stable period.
+     */
+    CWeatherStreamAnalysis(QDate startDate, QDate endDate, double tRangePct = CWather::STABLE_T_RANGE_PCT,
+                           double psreRangePct = CWather::STABLE_PSRE_RANGE_PCT);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /// Adds the next day (days outside the date window are skipped).
+    void addDay(const CWather::weatherData& wData);
+
+
+    /// Ends the periods in progress (the next day starts a new series, e.g. of another station).
+    void startNewSeries();
+
+
+    /** @brief Analyses a file without loading it.
+     *
+     * @param fileName - The name of the file (text or binary format).
+     * @param startDate - The first date of the analysed window.
+     * @param endDate - The last date of the analysed window.
+     *
+     * @throw QString - If the file could not be read.
+     *
+     * @return The results of the analyses.
+     */
+    static CWeatherStreamAnalysis analyseFile(const QString& fileName, QDate startDate, QDate endDate);
+
+
+    /// Used to get the number of analysed days.
+    int getDayCount() const;
+
+
+    /// Used to get the average temperature (rounded to two decimal places).
+    double getAvgTemperature() const;
+
+
+    /// Used to get the average pressure (rounded to two decimal places).
+    double getAvgPressure() const;
+
+
+    /// Used to get the highest humidity.
+    int getMaxHumidity() const;
+
+
+    /// Used to get the dates of the days with the highest humidity.
+    const std::vector<QDate>& getHighestHumidityDays() const;
+
+
+    /// Used to get the periods (2 and more days) when the wind direction did not change.
+    const std::vector<dayPeriod>& getWindPeriods() const;
+
+
+    /// Used to get the periods (3 and more days) when the pressure and temperature changed within the limits.
+    const std::vector<dayPeriod>& getStablePeriods() const;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) class field:
+
+
+    /// The analysed window.
+    QDate startDate, endDate;
+
+    /// The number of days and the sums of temperature and pressure.
+    int dayCount;
+    double tSum, psreSum;
+
+    /// The highest humidity and the days it was observed.
+    int maxHumidity;
+    std::vector<QDate> highestHumidityDays;
+
+    /// Finds the wind runs and the stable periods of the days in the window.
+    CFusedAnalysis periodAnalysis;
+
+    /// Found periods.
+    std::vector<dayPeriod> windPeriods, stablePeriods;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Private) Methods section:
+
+
+    /// Adds the periods the period analysis has ended since the last call.
+    void collectEndedPeriods();
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // WEATHERSTREAM_H
@@ -0,0 +1,280 @@
+#ifndef WEATHERVIEW_H
+#define WEATHERVIEW_H
+
+#include "cwather.h"
+#include <memory>
+
+
+/** @brief Lightweight read-only range over weather days.
+ *
+ * A view refers to days stored in a CWather object either as a contiguous range or as a list of selected row indexes.
+Creating a view, taking a sub-view or passing it by value never copies weather data. A view shares the (implicitly shared)
+storage of the CWather object it was taken from, so it is a consistent snapshot: it stays valid and unchanged even if that
+object is modified or destroyed later.
+ */
+class WeatherView
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Constructors section:
+
+
+    /// Default constructor (empty view).
+    WeatherView();
+
+
+    /** @brief Constructor with parameters
+     *
+     * Creates a view over all days of the weather object (implicit, so a CWather can be passed wherever a view is expected).
+     *
+     * @param weather - Weather data to be viewed.
+     */
+    WeatherView(const CWather& weather);
+
+
+    /** @brief Constructor with parameters
+     *
+     * Creates a view over the selected rows of the weather object.
+     *
+     * @param weather - Weather data to be viewed.
+     * @param rowIndexes - Indexes of the weather "array" elements that form the view (in view order).
+     */
+    WeatherView(const CWather& weather, std::vector<int> rowIndexes);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /** Used to get the number of days in the view.
+     *
+     * @return The number of days in the view.
+     */
+    int getWeatherSize() const;
+
+
+    /** Used to get the weather data for a certain day of the view.
+     *
+     * @param index - The index (0 .. getWeatherSize() - 1) of the day in the view.
+     */
+    const CWather::weatherData& at(int index) const;
+
+
+    /// Used to get the temperature for a certain day of the view.
+    int getTemperature(int index) const;
+
+
+    /// Used to get the pressure for a certain day of the view.
+    unsigned getPressure(int index) const;
+
+
+    /// Used to get the humidity for a certain day of the view.
+    int getHumidity(int index) const;
+
+
+    /// Used to get the wind direction for a certain day of the view.
+    WindDirection getWindDirection(int index) const;
+
+
+    /// Used to get the date of a certain day of the view.
+    QDate getDate(int index) const;
+
+
+    /** Used to get the value of a weather column for a certain day of the view.
+     *
+     * @param column - The column (temperature, pressure or humidity).
+     * @param index - The index of the day in the view.
+     */
+    int getColumnValue(WeatherColumn column, int index) const;
+
+
+    /** Copies one weather column of the viewed days into a contiguous array (for column-wise analyses).
+     *
+     * @param column - The column (temperature, pressure or humidity).
+     *
+     * @return Values of the column in view order.
+     */
+    std::vector<int> getColumn(WeatherColumn column) const;
+
+
+    /** Used to get the value of a derived column for a certain day of the view.
+     *
+     * @param column - The derived column (dew point, heat index, pressure tendency or temperature anomaly).
+     * @param index - The index of the day in the view.
+     *
+     * @return The value, computed over the whole weather object the view was taken from (the pressure tendency is the change
+    since the row before, the anomaly is against the climatology of all its days).
+     */
+    double getDerivedValue(DerivedColumn column, int index) const;
+
+
+    /** Copies one derived column of the viewed days into a contiguous array (for column-wise analyses).
+     *
+     * @param column - The derived column.
+     *
+     * @return Values of the column in view order.
+     */
+    std::vector<double> getDerivedColumn(DerivedColumn column) const;
+
+
+    /** Used to get a part of the view (constant time, no data is copied).
+     *
+     * @param startIndex - The index of the first day of the part.
+     * @param count - The number of days in the part.
+     *
+     * @return View of 'count' days starting from 'startIndex'.
+     */
+    WeatherView getSubView(int startIndex, int count) const;
+
+
+    /** Used to get a selection of the viewed days (no weather data is copied, only the row indexes).
+     *
+     * @param indexes - Indexes of the selected days in this view (in the order they should follow in the selection).
+     *
+     * @return View of the selected days.
+     */
+    WeatherView getSelection(const std::vector<int>& indexes) const;
+
+
+    /** Used to get the row of the weather object a certain day of the view comes from.
+     *
+     * @param index - The index of the day in the view.
+     *
+     * @return The index of the weather "array" element (the row number in a table filled from the whole weather object).
+     */
+    int getRowIndex(int index) const;
+
+
+    /** Copies the viewed days into a new weather object (use only when an owning copy is really needed).
+     *
+     * @return Weather object with the viewed days.
+     */
+    CWather toWeather() const;
+
+
+    /** @brief Fills the weather table.
+     *
+     * This method fills a table with 7 columns (year, month, day, t, pressure, humidity, wind direction) using the viewed days.
+     *
+     * @param weatherTable - Weather table neet to be filled.
+     */
+    void completeTable(QTableWidget* weatherTable) const;
+
+
+    /** Adds the viewed days from an index on to the end of the weather table (the rows already in it are not changed).
+     *
+     * @param weatherTable - Weather table with 7 columns.
+     * @param firstIndex - The index of the first day to add.
+     */
+    void appendToTable(QTableWidget* weatherTable, int firstIndex) const;
+
+
+    /** @brief Build a weather graph
+     *
+     * Draws a weather graph with weather data on the y-axis and dates on the x-axis.
+     *
+     * @param getWeatherData - Function that takes the index of a day in the view and returns data about one of the
+    weather parameters (temperature, pressure, humidity or a derived column).
+     * @param graphTitle - Title of the graph that is being built.
+     * @param overlays - Additional lines drawn over the graph (e.g. moving averages).
+     */
+    void buildWeatherGraph(std::function<double(int)> getWeatherData, const QString& graphTitle,
+                           const std::vector<graphOverlay>& overlays = {}) const;
+
+
+    /** @brief Build a weather graph with several lines
+     *
+     * Draws lines of weather data (e.g. of several stations) in one graph with dates on the x-axis.
+     *
+     * @param dates - Dates of the x-axis (the index of a date is the index of a day in the lines).
+     * @param lines - Lines of the graph (shown in the legend when there are several of them).
+     * @param graphTitle - Title of the graph that is being built.
+     */
+    static void buildWeatherGraph(const std::vector<QDate>& dates, const std::vector<graphOverlay>& lines,
+                                  const QString& graphTitle);
+
+
+    /** Finds the indixes of days in the view during which the wind direction did not change.
+     *
+     * @param continuity - How missing days are treated: neighbouring days of the view are neighbouring days, periods end at
+    gaps, or gaps are filled (linearly) before the search and only the days of the view are returned.
+     *
+     * @return A vector of vectors from the found indexes (each "internal" vector is a sequential view indices when the wind
+    direction did not change).
+     */
+    std::vector<std::vector<unsigned>> findDaysWindNotChange(DayContinuity continuity = AssumeConsecutiveDays) const;
+
+
+    /** Calculate the average temperature of the viewed days.
+     *
+     * @return The average temperature rounded to two decimal places.
+     */
+    double getAvgTemperature() const;
+
+
+    /** Calculate the average pressure of the viewed days.
+     *
+     * @return The average pressure rounded to two decimal places.
+     */
+    double getAvgPressure() const;
+
+
+    /** Finds the days when the humidity is highest.
+     *
+     * @return Vector of dates when the humidity is highest.
+     */
+    std::vector<QDate> getHighestHumidityDays() const;
+
+
+    /** Finds periods when the temperature and pressure changed within certain percentages.
+     *
+     * @param tRangePct - Percentage points within which the temperature can change (+-tRangePct).
+     * @param psreRangePct - Percentage points within which the pressure can change (+-psreRangePct).
+     * @param continuity - How missing days are treated: neighbouring days of the view are neighbouring days, periods end at
+    gaps, or gaps are filled (linearly) before the search.
+     *
+     * @return Periods (3 and more days) when the weather changes only within specified limits, as sub-views of this view
+    (views of the filled data when the gaps are filled).
+     */
+    std::vector<WeatherView> findPeriodTemperatureAndPressureChangeWithinRange(double tRangePct, double psreRangePct,
+                                                                               DayContinuity continuity = AssumeConsecutiveDays) const;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) class field:
+
+
+    /// The shared weather data storage that keeps the viewed days alive.
+    QSharedDataPointer<CWather::WeatherStorage> storage;
+
+    /// Pointer to the first element of the viewed weather "array" (inside 'storage').
+    const CWather::weatherData* rows;
+
+    /// Index of the first viewed day (in 'rows' or in 'rowIndexes' when the view is a selection).
+    int offset;
+
+    /// The number of viewed days.
+    int size;
+
+    /// Selected row indexes (nullptr when the view is a contiguous range of 'rows'). Shared between sub-views.
+    std::shared_ptr<const std::vector<int>> rowIndexes;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // WEATHERVIEW_H
@@ -0,0 +1,132 @@
+#ifndef WINDSTATISTICS_H
+#define WINDSTATISTICS_H
+
+#include "weatherview.h"
+#include <array>
+
+
+/** @brief Wind rose, wind persistence and wind direction transitions.
+ *
+ * All the statistics are accumulated in one pass over the days into fixed-size counters: direction frequencies for every
+month (seasons and the whole year are sums of months), histograms of how many days in a row each direction lasted, and the
+number of times each direction was followed by each direction on the next day. Runs and transitions only connect days with
+consecutive dates, so missing days and days out of date order break them.
+ */
+class CWindStatistics
+{
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+public:
+
+// (Public) Types section:
+
+
+    /// Number of wind directions (WindDirection values 1..8).
+    static const int WIND_DIRECTION_CNT = 8;
+
+    /// Direction frequencies (indexed by WindDirection - 1).
+    using windRose = std::array<int, WIND_DIRECTION_CNT>;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Constructors section:
+
+
+    /** @brief Constructor with parameters
+     *
+     * Builds all the statistics in one pass over the days.
+     *
+     * @param weather - Weather days (days with invalid dates or an undefined wind direction are skipped).
+     */
+    explicit CWindStatistics(const WeatherView& weather);
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// (Public) Methods section:
+
+
+    /// Used to get the direction frequencies of a month.
+    const windRose& getMonthRose(Month month) const;
+
+
+    /// Used to get the direction frequencies of a season.
+    windRose getSeasonRose(Season season) const;
+
+
+    /// Used to get the direction frequencies of all the days.
+    windRose getTotalRose() const;
+
+
+    /** Used to get how long a direction lasted.
+     *
+     * @param direction - The wind direction.
+     *
+     * @return Histogram of run lengths (element i is the number of runs of exactly i days; element 0 is always 0).
+     */
+    const std::vector<int>& getPersistenceHistogram(WindDirection direction) const;
+
+
+    /// Used to get the average number of days a direction lasted (0 if it was never observed).
+    double getMeanPersistence(WindDirection direction) const;
+
+
+    /** Used to get the number of times a direction was followed by a direction on the next day.
+     *
+     * @param from - The direction of the first day.
+     * @param to - The direction of the next day.
+     */
+    int getTransitionCount(WindDirection from, WindDirection to) const;
+
+
+    /** Used to get the probability that a direction is followed by a direction on the next day.
+     *
+     * @param from - The direction of the first day.
+     * @param to - The direction of the next day.
+     *
+     * @return The share (0 - 1) of the days with direction 'from' followed by direction 'to' (0 if 'from' was never
+    followed by a day).
+     */
+    double getTransitionProbability(WindDirection from, WindDirection to) const;
+
+
+    /** @brief Build a wind rose graph
+     *
+     * Draws the direction frequencies (in per cent) of every season and of the whole year on a polar chart.
+     *
+     * @param graphTitle - Title of the graph that is being built.
+     */
+    void buildWindRoseGraph(const QString& graphTitle) const;
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+private:
+
+// (Private) class field:
+
+
+    /// Direction frequencies of every month (indexed by Month - 1).
+    std::array<windRose, 12> monthRoses {};
+
+    /// Run length histograms of every direction.
+    std::array<std::vector<int>, WIND_DIRECTION_CNT> persistence;
+
+    /// Transition counts (transitions[from - 1][to - 1]).
+    std::array<windRose, WIND_DIRECTION_CNT> transitions {};
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+};
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+#endif // WINDSTATISTICS_H
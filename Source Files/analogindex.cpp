@@ -0,0 +1,279 @@
+#include "../Header Files/analogindex.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <queue>
+
+
+// Ranges of at most this many points are not split: they are scanned as a whole.
+static const int LEAF_SIZE = 8;
+
+
+// Unit vectors of the wind directions on the compass (x to the east, y to the north), by WindDirection value.
+static const float windVectors[9][2] = {
+    { 0.0f, 0.0f },                // Undefined
+    { 0.0f, 1.0f },                // North
+    { 0.0f, -1.0f },               // South
+    { 1.0f, 0.0f },                // East
+    { -1.0f, 0.0f },               // West
+    { 0.70710678f, 0.70710678f },  // Northeast
+    { -0.70710678f, 0.70710678f }, // Northwest
+    { 0.70710678f, -0.70710678f }, // Southeast
+    { -0.70710678f, -0.70710678f } // Southwest
+};
+
+
+// Squared distance of two points.
+static float getSquaredDistance(const float* a, const float* b)
+{
+    float distance = 0;
+
+    for (int d = 0; d < CAnalogIndex::DIMENSION_CNT; ++d) {
+        float difference = a[d] - b[d];
+        distance += difference * difference;
+    }
+
+    return distance;
+}
+
+
+// Default constructor (no days).
+CAnalogIndex::CAnalogIndex() : dayCount(0), means{0, 0, 0}, deviations{1, 1, 1}
+{}
+
+
+// Builds the trees of the days.
+CAnalogIndex::CAnalogIndex(const WeatherView& weather) : dayCount(weather.getWeatherSize()), means{0, 0, 0}, deviations{1, 1, 1}
+{
+    // Means and standard deviations of the temperature, pressure and humidity (one pass).
+    double sums[3] = {}, squareSums[3] = {};
+
+    for (int i = 0; i < dayCount; ++i)
+    {
+        const CWather::weatherData& wData = weather.at(i);
+        double values[3] = { static_cast<double>(wData.m_temperature), static_cast<double>(wData.m_pressure),
+                             static_cast<double>(wData.m_humidity) };
+
+        for (int f = 0; f < 3; ++f) {
+            sums[f] += values[f];
+            squareSums[f] += values[f] * values[f];
+        }
+    }
+
+    for (int f = 0; f < 3 && dayCount > 0; ++f)
+    {
+        means[f] = sums[f] / dayCount;
+        double variance = squareSums[f] / dayCount - means[f] * means[f];
+
+        // A parameter that never changes does not tell the days apart, so it is left unscaled.
+        deviations[f] = variance > 1e-9 ? std::sqrt(variance) : 1.0;
+    }
+
+    // The points of all the days and the days of every season.
+    std::vector<float> points(static_cast<size_t>(dayCount) * DIMENSION_CNT);
+    std::vector<int> indexes(dayCount);
+    std::vector<int> seasonIndexes[4];
+
+    for (int i = 0; i < dayCount; ++i)
+    {
+        const CWather::weatherData& wData = weather.at(i);
+        getPoint(wData, &points[static_cast<size_t>(i) * DIMENSION_CNT]);
+        indexes[i] = i;
+
+        if (wData.m_month >= 1 && wData.m_month <= 12) {
+            seasonIndexes[getSeason(wData.m_month) - 1].push_back(i);
+        }
+    }
+
+    allDays = buildTree(points, indexes);
+
+    for (int s = 0; s < 4; ++s)
+    {
+        std::vector<float> seasonPoints(seasonIndexes[s].size() * DIMENSION_CNT);
+
+        for (int j = 0; j < seasonIndexes[s].size(); ++j) {
+            std::copy_n(&points[static_cast<size_t>(seasonIndexes[s][j]) * DIMENSION_CNT], DIMENSION_CNT,
+                        &seasonPoints[static_cast<size_t>(j) * DIMENSION_CNT]);
+        }
+
+        seasonDays[s] = buildTree(seasonPoints, seasonIndexes[s]);
+    }
+}
+
+
+// Finds the indexed days most similar to a day.
+std::vector<CAnalogIndex::analogDay> CAnalogIndex::findNearest(const CWather::weatherData& day, int count, bool isSameSeason,
+                                                               int excludedIndex) const
+{
+    if (count <= 0) {
+        return {};
+    }
+
+    float point[DIMENSION_CNT];
+    getPoint(day, point);
+
+    if (!isSameSeason) {
+        return searchTree(allDays, point, count, excludedIndex);
+    }
+
+    if (day.m_month < 1 || day.m_month > 12) {
+        return {};
+    }
+
+    return searchTree(seasonDays[getSeason(day.m_month) - 1], point, count, excludedIndex);
+}
+
+
+// Used to get the number of indexed days.
+int CAnalogIndex::getDayCount() const
+{
+    return dayCount;
+}
+
+
+// Computes the point of a day.
+void CAnalogIndex::getPoint(const CWather::weatherData& day, float* point) const
+{
+    point[0] = static_cast<float>((day.m_temperature - means[0]) / deviations[0]);
+    point[1] = static_cast<float>((static_cast<double>(day.m_pressure) - means[1]) / deviations[1]);
+    point[2] = static_cast<float>((day.m_humidity - means[2]) / deviations[2]);
+
+    int direction = day.m_windDirection >= 1 && day.m_windDirection <= 8 ? day.m_windDirection : 0;
+    point[3] = windVectors[direction][0];
+    point[4] = windVectors[direction][1];
+}
+
+
+// Builds a tree.
+CAnalogIndex::kdTree CAnalogIndex::buildTree(const std::vector<float>& points, const std::vector<int>& indexes)
+{
+    int pointCount = indexes.size();
+
+    std::vector<int> order(pointCount);
+    std::iota(order.begin(), order.end(), 0);
+
+    kdTree tree;
+    tree.m_splitDimensions.assign(pointCount, 0);
+
+    // Split every range at its median by the dimension with the largest spread (the ranges are kept on a stack).
+    std::vector<std::pair<int, int>> ranges;
+    if (pointCount > LEAF_SIZE) {
+        ranges.push_back({0, pointCount});
+    }
+
+    while (!ranges.empty())
+    {
+        auto [first, last] = ranges.back();
+        ranges.pop_back();
+
+        float minValues[DIMENSION_CNT], maxValues[DIMENSION_CNT];
+        std::fill(minValues, minValues + DIMENSION_CNT, INFINITY);
+        std::fill(maxValues, maxValues + DIMENSION_CNT, -INFINITY);
+
+        for (int j = first; j < last; ++j) {
+            const float* point = &points[static_cast<size_t>(order[j]) * DIMENSION_CNT];
+            for (int d = 0; d < DIMENSION_CNT; ++d) {
+                minValues[d] = std::min(minValues[d], point[d]);
+                maxValues[d] = std::max(maxValues[d], point[d]);
+            }
+        }
+
+        int dimension = 0;
+        for (int d = 1; d < DIMENSION_CNT; ++d) {
+            if (maxValues[d] - minValues[d] > maxValues[dimension] - minValues[dimension]) {
+                dimension = d;
+            }
+        }
+
+        int middle = (first + last) / 2;
+        std::nth_element(order.begin() + first, order.begin() + middle, order.begin() + last, [&points, dimension](int a, int b) {
+            return points[static_cast<size_t>(a) * DIMENSION_CNT + dimension] < points[static_cast<size_t>(b) * DIMENSION_CNT + dimension];
+        });
+        tree.m_splitDimensions[middle] = dimension;
+
+        if (middle - first > LEAF_SIZE) {
+            ranges.push_back({first, middle});
+        }
+        if (last - (middle + 1) > LEAF_SIZE) {
+            ranges.push_back({middle + 1, last});
+        }
+    }
+
+    // Store the points in tree order.
+    tree.m_points.resize(points.size());
+    tree.m_indexes.resize(pointCount);
+
+    for (int j = 0; j < pointCount; ++j) {
+        std::copy_n(&points[static_cast<size_t>(order[j]) * DIMENSION_CNT], DIMENSION_CNT,
+                    &tree.m_points[static_cast<size_t>(j) * DIMENSION_CNT]);
+        tree.m_indexes[j] = indexes[order[j]];
+    }
+
+    return tree;
+}
+
+
+// Finds the points of a tree nearest to a point.
+std::vector<CAnalogIndex::analogDay> CAnalogIndex::searchTree(const kdTree& tree, const float* point, int count, int excludedIndex)
+{
+    // The nearest points found so far (squared distance and day index), the farthest of them on top.
+    std::priority_queue<std::pair<float, int>> nearest;
+
+    // Takes a point of the tree into account.
+    auto visitPoint = [&](int position) {
+        int index = tree.m_indexes[position];
+        if (index == excludedIndex) {
+            return;
+        }
+
+        std::pair<float, int> candidate(getSquaredDistance(&tree.m_points[static_cast<size_t>(position) * DIMENSION_CNT], point), index);
+
+        if (nearest.size() < count) {
+            nearest.push(candidate);
+        } else if (candidate < nearest.top()) {
+            nearest.pop();
+            nearest.push(candidate);
+        }
+    };
+
+    // Searches a range of the tree: the half the point is in first, the other half only if it can hold a nearer point.
+    auto searchRange = [&](auto& self, int first, int last) -> void {
+        if (last - first <= LEAF_SIZE) {
+            for (int j = first; j < last; ++j) {
+                visitPoint(j);
+            }
+            return;
+        }
+
+        int middle = (first + last) / 2;
+        visitPoint(middle);
+
+        int dimension = tree.m_splitDimensions[middle];
+        float difference = point[dimension] - tree.m_points[static_cast<size_t>(middle) * DIMENSION_CNT + dimension];
+
+        if (difference < 0) {
+            self(self, first, middle);
+            if (nearest.size() < count || difference * difference < nearest.top().first) {
+                self(self, middle + 1, last);
+            }
+        } else {
+            self(self, middle + 1, last);
+            if (nearest.size() < count || difference * difference < nearest.top().first) {
+                self(self, first, middle);
+            }
+        }
+    };
+
+    searchRange(searchRange, 0, static_cast<int>(tree.m_indexes.size()));
+
+    // The farthest day is on top, so the days are taken out from the last one.
+    std::vector<analogDay> days(nearest.size());
+
+    for (int j = static_cast<int>(days.size()) - 1; j >= 0; --j) {
+        days[j].m_index = nearest.top().second;
+        days[j].m_distance = std::sqrt(nearest.top().first);
+        nearest.pop();
+    }
+
+    return days;
+}
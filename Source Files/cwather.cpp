@@ -1,17 +1,25 @@
 #include "../Header Files/cwather.h"
+#include "../Header Files/weatherview.h"
+#include "../Header Files/forecastengine.h"
+#include "../Header Files/rollups.h"
+#include "../Header Files/derivedcolumns.h"
+#include "../Header Files/analogindex.h"
+#include <numeric>
+#include <cmath>
 
 
 // Default constructor
-CWather::CWather()
+CWather::CWather() : d(new WeatherStorage)
 {
-    weatherArr.reserve(1000);
+    d->weatherArr.reserve(1000);
 }
 
 
 // Constructor for retrieving weather data from a weather table with 7 columns (year, month, day, t, pressure, humidity, wind direction).
-CWather::CWather(QTableWidget * weatherTable, const int& rowCount)
+CWather::CWather(QTableWidget * weatherTable, const int& rowCount) : d(new WeatherStorage)
 {
-    weatherArr.clear();
+    std::vector<weatherData>& weatherArr = d->weatherArr;
+    weatherArr.reserve(rowCount);
 
     // Iterate through each row in the weather table.
     for(int i = 0; i < rowCount; ++i)
@@ -28,14 +36,34 @@ CWather::CWather(QTableWidget * weatherTable, const int& rowCount)
         // Create a new weather data entry and add it to the array.
         weatherArr.push_back(weatherData(year, month, day, t, pressure, humidity, windDirection));
     }
+
+    // Build the rollups while the data is loaded.
+    getRollups();
+}
+
+
+// Constructor that takes over already read weather data.
+CWather::CWather(std::vector<weatherData> weatherArr) : d(new WeatherStorage)
+{
+    d->weatherArr = std::move(weatherArr);
+
+    // Build the rollups while the data is loaded.
+    getRollups();
 }
 
 
 // Copy constructor
-CWather::CWather(const CWather& weather) : weatherArr(weather.weatherArr)
+CWather::CWather(const CWather& weather) : d(weather.d)
 {}
 
 
+// Move constructor
+CWather::CWather(CWather&& weather) noexcept : d(std::move(weather.d))
+{
+    weather.d = sharedEmptyStorage();
+}
+
+
 // Copy assignment operator
 CWather& CWather::operator=(const CWather& other)
 {
@@ -43,7 +71,21 @@ CWather& CWather::operator=(const CWather& other)
         return *this;
     }
 
-    weatherArr = other.weatherArr;
+    d = other.d;
+
+    return *this;
+}
+
+
+// Move assignment operator
+CWather& CWather::operator=(CWather&& other) noexcept
+{
+    if (this == &other) {
+        return *this;
+    }
+
+    d = std::move(other.d);
+    other.d = sharedEmptyStorage();
 
     return *this;
 }
@@ -51,16 +93,22 @@ CWather& CWather::operator=(const CWather& other)
 
 // Default destructor
 CWather::~CWather()
+{}
+
+
+// Used to get the storage left in an object whose data was moved out.
+QSharedDataPointer<CWather::WeatherStorage> CWather::sharedEmptyStorage()
 {
-    weatherArr.clear();
+    static const QSharedDataPointer<WeatherStorage> emptyStorage(new WeatherStorage);
+    return emptyStorage;
 }
 
 
 // Determine if the weather data set meets all requirements.
-bool CWather::isWeatherDataValid()
+bool CWather::isWeatherDataValid() const
 {
     // Iterate through each weather data entry in the array.
-    for (const weatherData& wData: weatherArr)
+    for (const weatherData& wData: d->weatherArr)
     {
         int intMonth = static_cast<int>(wData.m_month);
         int day = wData.m_day;
@@ -83,6 +131,7 @@ bool CWather::isWeatherDataValid()
 // Sorting the weather range (specified by parameters) by pressure.
 void CWather::selectionSortByPressure(int startIndex, int endIndex)
 {
+    std::vector<weatherData>& weatherArr = d->weatherArr;
     int minIndex;
 
     // Iterate through the specified weather range using selection sort.
@@ -105,6 +154,7 @@ void CWather::selectionSortByPressure(int startIndex, int endIndex)
 // Within a season (3 months), sort the records by Pressure.
 void CWather::sortPressureBySeason()
 {
+    std::vector<weatherData>& weatherArr = d->weatherArr;
     int startIndex = 0, endIndex = 0;
 
     // Iterate through the weather data array.
@@ -120,112 +170,86 @@ void CWather::sortPressureBySeason()
             selectionSortByPressure(startIndex, endIndex);
         }
     }
+
+    invalidateCaches();
 }
 
 
-// Fills the weather table.
-void CWather::completeTable(QTableWidget* weatherTable)
+// Within a season (3 months), sort the records by a derived column.
+void CWather::sortBySeason(DerivedColumn column)
 {
-    // Set the number of rows in the table to match the size of the weather data array.
-    weatherTable->setRowCount(weatherArr.size());
+    std::vector<weatherData>& weatherArr = d->weatherArr;
+    int size = weatherArr.size();
 
-    // Populate the table with weather data.
-    for (int i = 0; i < weatherArr.size(); ++i) {
-        weatherTable->setItem(i, 0, new QTableWidgetItem(QString::number(weatherArr[i].m_year)));
-        weatherTable->setItem(i, 1, new QTableWidgetItem(QString::number(static_cast<int>(weatherArr[i].m_month))));
-        weatherTable->setItem(i, 2, new QTableWidgetItem(QString::number(weatherArr[i].m_day)));
-        weatherTable->setItem(i, 3, new QTableWidgetItem(QString::number(weatherArr[i].m_temperature)));
-        weatherTable->setItem(i, 4, new QTableWidgetItem(QString::number(weatherArr[i].m_pressure)));
-        weatherTable->setItem(i, 5, new QTableWidgetItem(QString::number(weatherArr[i].m_humidity)));
-        weatherTable->setItem(i, 6, new QTableWidgetItem(convertWindDirToText(weatherArr[i].m_windDirection)));
-    }
-}
+    // The values depend on the order of the days (e.g. the pressure tendency), so all of them are taken before sorting.
+    std::vector<double> values(size);
+    getDerivedColumns(*d)->getValues(weatherArr, column, 0, size, values.data());
 
+    std::vector<int> order(size);
+    std::iota(order.begin(), order.end(), 0);
 
-// Draws a weather graph with weather data on the y-axis and dates on the x-axis.
-void CWather::buildWeatherGraph(std::function<int (int)> getWeatherData, const QString &graphTitle)
-{
-    // Check if there is enough data to build the graph.
-    if(weatherArr.size() < 3){
-        QMessageBox::information(nullptr, "Not enough data.", "Data is required to build the graph."
-                                " Please add 3 or more rows to the table and save it.", QMessageBox::Ok);
-        return;
+    // Sort the indexes of the days of each season by the values.
+    for (int startIndex = 0, endIndex = 1; startIndex < size; ++endIndex)
+    {
+        if (endIndex == size || isSeasonChanged(weatherArr[endIndex - 1].m_month, weatherArr[endIndex - 1].m_year,
+                                                weatherArr[endIndex].m_month, weatherArr[endIndex].m_year))
+        {
+            // Days without a value (NaN, e.g. the pressure tendency after a missing day) go after the others.
+            std::stable_sort(order.begin() + startIndex, order.begin() + endIndex, [&values](int a, int b) {
+                return std::isnan(values[b]) ? !std::isnan(values[a]) : values[a] < values[b];
+            });
+            startIndex = endIndex;
+        }
     }
 
-    // Create a new line series for the graph.
-    QLineSeries* series = new QLineSeries();
-
-    // Add points to the series.
-    for(int i = 0; i < weatherArr.size(); ++i){
-        series->append(i, getWeatherData(i));
+    // Move the days into the sorted order.
+    std::vector<weatherData> sortedArr;
+    sortedArr.reserve(size);
+    for (int index : order) {
+        sortedArr.push_back(weatherArr[index]);
     }
+    weatherArr = std::move(sortedArr);
 
-    // Create a new chart and add the series to it.
-    QChart* chart = new QChart();
-    chart->legend()->hide();
-    chart->addSeries(series);
-    chart->createDefaultAxes();
-
-    chart->setTitle(graphTitle);
-
-    chart->setAnimationOptions(QChart::AllAnimations);
-
-    // Create axis x for the dates.
-    QCategoryAxis *axisX = new QCategoryAxis();
-    axisX->setLabelsPosition(QCategoryAxis::AxisLabelsPositionOnValue);
+    invalidateCaches();
+}
 
-    // Append dates to the axis.
-    for(int i = 0; i < weatherArr.size(); ++i){
-        QString date = QString::asprintf("%02d.%02d", static_cast<int>(weatherArr[i].m_month), weatherArr[i].m_year);
-        axisX->append(date, i);
-    }
 
-    // Set the X-axis for the chart.
-    chart->setAxisX(axisX, series);
+// Fills the weather table.
+void CWather::completeTable(QTableWidget* weatherTable) const
+{
+    getView().completeTable(weatherTable);
+}
 
-    // Create a chart view and set rendering options.
-    QChartView *chartView = new QChartView(chart);
-    chartView->setRenderHint(QPainter::Antialiasing);
 
-    // Create a dialog to display the chart.
-    QDialog *dialog = new QDialog;
-    dialog->setMinimumSize(800, 500);
+// Adds the days from an index on to the end of the weather table.
+void CWather::appendToTable(QTableWidget* weatherTable, int firstIndex) const
+{
+    getView().appendToTable(weatherTable, firstIndex);
+}
 
-    // Create a layout for the dialog and add the chart view to it.
-    QVBoxLayout *layout = new QVBoxLayout;
-    dialog->setLayout(layout);
-    layout->addWidget(chartView);
 
-    // Show the dialog.
-    dialog->exec();
+// Draws a weather graph with weather data on the y-axis and dates on the x-axis.
+void CWather::buildWeatherGraph(std::function<double (int)> getWeatherData, const QString &graphTitle,
+                                const std::vector<graphOverlay>& overlays) const
+{
+    getView().buildWeatherGraph(getWeatherData, graphTitle, overlays);
 }
 
 
 // Finds the indixes of weather "array" elements during which the wind direction did not change.
-std::vector<std::vector<unsigned>> CWather::findDaysWindNotChange()
+std::vector<std::vector<unsigned>> CWather::findDaysWindNotChange(DayContinuity continuity) const
 {
-    // Vector to store vectors of indices where the wind direction did not change.
-    std::vector<std::vector<unsigned>> windNotChangeArr;
-
-    // Iterate through the weather array to find consecutive days with the same wind direction.
-    for (int i = 0; i < weatherArr.size() - 1; ++i) {
-        // Check if the wind direction for the current day is the same as the next day.
-        if (weatherArr[i].m_windDirection == weatherArr[i + 1].m_windDirection) {
-            // Vector to store indices of consecutive days with the same wind direction.
-            std::vector<unsigned> indexArr;
-
-            // Add the index of the current day to the vector.
-            indexArr.push_back(i);
+    if (continuity != AssumeConsecutiveDays) {
+        return getView().findDaysWindNotChange(continuity);
+    }
 
-            // Continue adding indices while the wind direction remains the same.
-            while (weatherArr[i].m_windDirection == weatherArr[i + 1].m_windDirection) {
-                indexArr.push_back(i + 1);
-                i++;
-            }
+    // The runs of consecutive days are found once and cached.
+    std::shared_ptr<const std::vector<dayRun>> runs = getWindRuns();
 
-            // Add the vector of indices to the main vector.
-            windNotChangeArr.push_back(indexArr);
-        }
+    std::vector<std::vector<unsigned>> windNotChangeArr(runs->size());
+    for (int i = 0; i < runs->size(); ++i) {
+        windNotChangeArr[i].resize((*runs)[i].m_dayCount);
+        std::iota(windNotChangeArr[i].begin(), windNotChangeArr[i].end(), static_cast<unsigned>((*runs)[i].m_firstIndex));
     }
 
     return windNotChangeArr;
@@ -233,110 +257,42 @@ std::vector<std::vector<unsigned>> CWather::findDaysWindNotChange()
 
 
 // Calculate the average temperature in the weather array.
-double CWather::getAvgTemperature()
+double CWather::getAvgTemperature() const
 {
-    // Variable to store the sum of temperature values.
-    double sum = 0;
-
-    // Calculate the sum of temperature values in the weather array.
-    for (int i = 0; i < weatherArr.size(); ++i) {
-        sum += weatherArr[i].m_temperature;
-    }
-
-    // Calculate and return the average temperature rounded to two decimal places.
-    return qRound(sum / weatherArr.size() * 100.0) / 100.0;
+    return getView().getAvgTemperature();
 }
 
 
 // Calculate the average pressure in the weather array.
-double CWather::getAvgPressure()
+double CWather::getAvgPressure() const
 {
-    // Variable to store the sum of pressure values.
-    double sum = 0;
-
-    // Calculate the sum of pressure values in the weather array.
-    for (int i = 0; i < weatherArr.size(); ++i) {
-        sum += weatherArr[i].m_pressure;
-    }
-
-    // Calculate and return the average pressure rounded to two decimal places.
-    return qRound(sum / weatherArr.size() * 100.0) / 100.0;
+    return getView().getAvgPressure();
 }
 
 
-// Calculate the average humidity in the weather array.
-std::vector<QDate> CWather::getHighestHumidityDays()
+// Finds the days when the humidity is highest.
+std::vector<QDate> CWather::getHighestHumidityDays() const
 {
-    // Vector to store dates with the highest humidity.
-    std::vector<QDate> highestHumDaysArr;
-
-    // Variable to store the maximum humidity value.
-    int maxHumidity = 0;
-
-    // Find the maximum humidity value in the weather array.
-    for (int i = 0; i < weatherArr.size(); ++i) {
-        if (weatherArr[i].m_humidity > maxHumidity) {
-            maxHumidity = weatherArr[i].m_humidity;
-        }
-    }
-
-    // Find dates with the highest humidity and add them to the vector.
-    for (int i = 0; i < weatherArr.size(); ++i) {
-        if (weatherArr[i].m_humidity == maxHumidity) {
-            highestHumDaysArr.push_back(QDate(weatherArr[i].m_year, weatherArr[i].m_month, weatherArr[i].m_day));
-        }
-    }
-
-    return highestHumDaysArr;
+    return getView().getHighestHumidityDays();
 }
 
 
 // Finds periods when the temperature and pressure changed within certain percentages.
-std::vector<CWather> CWather::findPeriodTemperatureAndPressureChangeWithinRange(double tRangePct, double psreRangePct)
+std::vector<WeatherView> CWather::findPeriodTemperatureAndPressureChangeWithinRange(double tRangePct, double psreRangePct,
+                                                                                    DayContinuity continuity) const
 {
-    // Vector to store periods with temperature and pressure changes within the specified percentages.
-    std::vector<CWather> periodsArr;
-
-    // Initialize variables to keep track of the current element in weatherArr and the current period index.
-    int currEl = 0, periodIndex = 0;
-
-    // Iterate through weatherArr to find periods with desired changes.
-    while (currEl < weatherArr.size())
-    {
-        // Check if periodsArr needs a new period at the current index.
-        if (periodsArr.size() < periodIndex + 1)
-        {
-            CWather periodWeather;
-            periodWeather.pushWeatherDataEnd(weatherArr[currEl]);
-            periodsArr.push_back(periodWeather);
-        }
-        // Check if the current weather data fits within the percentage change criteria.
-        else if (fabs(periodsArr[periodIndex].getAvgPressure() - static_cast<double>(weatherArr[currEl].m_pressure))
-                     <= getPercentageOf(periodsArr[periodIndex].getAvgPressure()) * psreRangePct
-                 && fabs(periodsArr[periodIndex].getAvgTemperature() - static_cast<double>(weatherArr[currEl].m_temperature))
-                        <= getPercentageOf(periodsArr[periodIndex].getAvgTemperature()) * tRangePct)
-        {
-            // Add the current weather data to the current period.
-            periodsArr[periodIndex].pushWeatherDataEnd(weatherArr[currEl]);
-        }
-        else
-        {
-            // Move to the next period index.
-            periodIndex++;
-            continue;
-        }
-
-        // Move to the next element in weatherArr.
-        currEl++;
+    // Only the periods of the ranges the main window and the summaries use are cached.
+    if (continuity != AssumeConsecutiveDays || tRangePct != STABLE_T_RANGE_PCT || psreRangePct != STABLE_PSRE_RANGE_PCT) {
+        return getView().findPeriodTemperatureAndPressureChangeWithinRange(tRangePct, psreRangePct, continuity);
     }
 
-    // Remove periods with less than 3 weather data entries.
-    for (auto it = periodsArr.begin(); it != periodsArr.end(); ) {
-        if ((*it).weatherArr.size() < 3) {
-            it = periodsArr.erase(it);
-        } else {
-            ++it;
-        }
+    WeatherView view = getView();
+    std::shared_ptr<const std::vector<dayRun>> periods = getStablePeriods();
+
+    std::vector<WeatherView> periodsArr;
+    periodsArr.reserve(periods->size());
+    for (const dayRun& period : *periods) {
+        periodsArr.push_back(view.getSubView(period.m_firstIndex, period.m_dayCount));
     }
 
     return periodsArr;
@@ -344,10 +300,19 @@ std::vector<CWather> CWather::findPeriodTemperatureAndPressureChangeWithinRange(
 
 
 // Retrieve weather data for a specific period between two dates.
-CWather CWather::getWeatherByPeriod(QDate startDate, QDate endDate)
+CWather CWather::getWeatherByPeriod(QDate startDate, QDate endDate) const
 {
-    // Create a new instance of CWather to store weather data for the specified period.
-    CWather weatherPeriod;
+    return getViewByPeriod(startDate, endDate).toWeather();
+}
+
+
+// Retrieve a view of the weather data for a specific period between two dates (no days are copied).
+WeatherView CWather::getViewByPeriod(QDate startDate, QDate endDate) const
+{
+    const std::vector<weatherData>& weatherArr = d->weatherArr;
+
+    // Indexes of the days within the specified date range.
+    std::vector<int> rowIndexes;
 
     // Loop through the existing weatherArr to find data within the specified date range.
     for (int i = 0; i < weatherArr.size(); ++i) {
@@ -356,140 +321,257 @@ CWather CWather::getWeatherByPeriod(QDate startDate, QDate endDate)
 
         // Check if the currentTableDate is within the specified date range.
         if (currentTableDate >= startDate && currentTableDate <= endDate) {
-            // Add the weather data to the weatherPeriod's weatherArr.
-            weatherPeriod.weatherArr.push_back(weatherArr[i]);
+            rowIndexes.push_back(i);
         }
     }
 
-    return weatherPeriod;
+    // Days of a date-ordered table form a contiguous range, which is viewed without the index list.
+    if (!rowIndexes.empty() && rowIndexes.back() - rowIndexes.front() + 1 == static_cast<int>(rowIndexes.size())) {
+        return getView().getSubView(rowIndexes.front(), static_cast<int>(rowIndexes.size()));
+    }
+
+    return WeatherView(*this, std::move(rowIndexes));
+}
+
+
+// Used to get a view over all the weather data.
+WeatherView CWather::getView() const
+{
+    return WeatherView(*this);
 }
 
 
 // Forecasts the weather for the next month and adds it to the existing weather data (at the end).
 void CWather::forecastWeatherForNextMonth()
 {
+    forecastWeatherForNextMonth(QRandomGenerator::global()->generate64());
+}
+
+
+// Forecasts the weather for the next month (with the given seed) and adds it to the existing weather data (at the end).
+void CWather::forecastWeatherForNextMonth(quint64 seed)
+{
+    const std::vector<weatherData>& weatherArr = std::as_const(d)->weatherArr;
+
+    if (weatherArr.empty()) {
+        return;
+    }
+
     int lastElIndex = weatherArr.size() - 1;
 
     // Calculating the next month and year based on the last element in the vector.
     Month month = getNextMonth(weatherArr[lastElIndex].m_month);
     int year = month == Month::January ? weatherArr[lastElIndex].m_year + 1 : weatherArr[lastElIndex].m_year;
 
-    // Variables to store forecasted weather data.
-    int temperature;
-    unsigned pressure;
-    int humidity;
-    WindDirection windDirection;
+    // Generate the whole month at once from the climatology of the weather data.
+    CRandomStream random(seed);
+    std::vector<weatherData> forecastArr = getForecastEngine()->forecast(QDate(year, month, 1), getNumDaysInMonth(month, year), random);
 
-    // Looping through each day in the next month.
-    for (int day = 1; day <= getNumDaysInMonth(month, year); ++day)
-    {
-        // Generating forecasted weather data based on the month.
-        switch (month) {
-        case Month::December:
-            temperature = QRandomGenerator::global()->bounded(-5, 6);
-            pressure = QRandomGenerator::global()->bounded(770, 781);
-            humidity = QRandomGenerator::global()->bounded(30, 41);
-            break;
-        case Month::January:
-            temperature = QRandomGenerator::global()->bounded(-10, 1);
-            pressure = QRandomGenerator::global()->bounded(780, 791);
-            humidity = QRandomGenerator::global()->bounded(20, 31);
-            break;
-        case Month::February:
-            temperature = QRandomGenerator::global()->bounded(0, 11);
-            pressure = QRandomGenerator::global()->bounded(760, 771);
-            humidity = QRandomGenerator::global()->bounded(30, 46);
-            break;
-        case Month::March:
-            temperature = QRandomGenerator::global()->bounded(10, 16);
-            pressure = QRandomGenerator::global()->bounded(750, 761);
-            humidity = QRandomGenerator::global()->bounded(45, 56);
-            break;
-        case Month::April:
-            temperature = QRandomGenerator::global()->bounded(16, 21);
-            pressure = QRandomGenerator::global()->bounded(740, 751);
-            humidity = QRandomGenerator::global()->bounded(55, 66);
-            break;
-        case Month::May:
-            temperature = QRandomGenerator::global()->bounded(20, 26);
-            pressure = QRandomGenerator::global()->bounded(730, 741);
-            humidity = QRandomGenerator::global()->bounded(65, 71);
-            break;
-        case Month::June:
-            temperature = QRandomGenerator::global()->bounded(20, 31);
-            pressure = QRandomGenerator::global()->bounded(721, 731);
-            humidity = QRandomGenerator::global()->bounded(65, 76);
-            break;
-        case Month::July:
-            temperature = QRandomGenerator::global()->bounded(25, 36);
-            pressure = QRandomGenerator::global()->bounded(710, 721);
-            humidity = QRandomGenerator::global()->bounded(70, 81);
-            break;
-        case Month::August:
-            temperature = QRandomGenerator::global()->bounded(20, 31);
-            pressure = QRandomGenerator::global()->bounded(721, 731);
-            humidity = QRandomGenerator::global()->bounded(62, 76);
-            break;
-        case Month::September:
-            temperature = QRandomGenerator::global()->bounded(15, 21);
-            pressure = QRandomGenerator::global()->bounded(736, 751);
-            humidity = QRandomGenerator::global()->bounded(60, 71);
-            break;
-        case Month::October:
-            temperature = QRandomGenerator::global()->bounded(10, 16);
-            pressure = QRandomGenerator::global()->bounded(751, 766);
-            humidity = QRandomGenerator::global()->bounded(50, 61);
-            break;
-        case Month::November:
-            temperature = QRandomGenerator::global()->bounded(5, 11);
-            pressure = QRandomGenerator::global()->bounded(760, 771);
-            humidity = QRandomGenerator::global()->bounded(40, 51);
-            break;
-        default:
-            break;
-        }
+    std::vector<weatherData>& newWeatherArr = d->weatherArr;
+    int firstNewIndex = newWeatherArr.size();
+    newWeatherArr.insert(newWeatherArr.end(), forecastArr.begin(), forecastArr.end());
+    updateCachesOnAppend(firstNewIndex);
+}
+
+
+// Adds days to the end of the weather data.
+void CWather::appendDays(const std::vector<weatherData>& days)
+{
+    if (days.empty()) {
+        return;
+    }
+
+    std::vector<weatherData>& weatherArr = d->weatherArr;
+    int firstNewIndex = weatherArr.size();
+    weatherArr.insert(weatherArr.end(), days.begin(), days.end());
+    updateCachesOnAppend(firstNewIndex);
+}
+
+
+// Used to get the forecast engine built from the climatology of the weather data.
+std::shared_ptr<const CForecastEngine> CWather::getForecastEngine() const
+{
+    QMutexLocker locker(&d->cacheMutex);
+
+    if (!d->forecastEngine) {
+        d->forecastEngine = std::make_shared<const CForecastEngine>(getView());
+    }
+
+    return d->forecastEngine;
+}
+
+
+// Used to get the weekly, monthly, seasonal and yearly aggregates of the weather data.
+std::shared_ptr<const CWeatherRollups> CWather::getRollups() const
+{
+    QMutexLocker locker(&d->cacheMutex);
+
+    if (!d->rollups) {
+        d->rollups = std::make_shared<CWeatherRollups>(getView());
+    }
+
+    return d->rollups;
+}
+
+
+// Used to get the index for finding the days most similar to a given day.
+std::shared_ptr<const CAnalogIndex> CWather::getAnalogIndex() const
+{
+    QMutexLocker locker(&d->cacheMutex);
+
+    if (!d->analogIndex) {
+        d->analogIndex = std::make_shared<const CAnalogIndex>(getView());
+    }
+
+    return d->analogIndex;
+}
+
+
+// Drops all data derived from the weather data.
+void CWather::invalidateCaches()
+{
+    QMutexLocker locker(&d->cacheMutex);
+    d->forecastEngine.reset();
+    d->rollups.reset();
+    d->windRuns.reset();
+    d->stablePeriods.reset();
+    d->derivedColumns.reset();
+    d->analogIndex.reset();
+}
 
-        // Generating a random wind direction.
-        windDirection = static_cast<WindDirection>(QRandomGenerator::global()->bounded(1, 9));
 
-        // Adding the forecasted weather data to the weatherArr vector.
-        weatherArr.push_back(weatherData(year, month, day, temperature, pressure, humidity, windDirection));
+// Updates the data derived from the weather data after days were appended.
+void CWather::updateCachesOnAppend(int firstNewIndex)
+{
+    QMutexLocker locker(&d->cacheMutex);
+
+    // The climatology changes with every day, so the forecast engine, the derived columns (the temperature anomaly) and the
+    // analog index (scaled by the means of all the days) are rebuilt when they are needed again, as are the runs, the last
+    // of which may go on in the appended days.
+    d->forecastEngine.reset();
+    d->windRuns.reset();
+    d->stablePeriods.reset();
+    d->derivedColumns.reset();
+    d->analogIndex.reset();
+
+    if (!d->rollups) {
+        return;
+    }
+
+    // Rollups held by other objects or callers are left as they are, and the appended days go into a copy.
+    if (d->rollups.use_count() > 1) {
+        d->rollups = std::make_shared<CWeatherRollups>(*d->rollups);
+    }
+
+    const std::vector<weatherData>& weatherArr = d->weatherArr;
+    for (int i = firstNewIndex; i < weatherArr.size(); ++i) {
+        d->rollups->addDay(weatherArr[i]);
     }
 }
 
 
 // Used to get the number of days for which weather data was added.
-int CWather::getWeatherSize()
+int CWather::getWeatherSize() const
 {
-    return weatherArr.size();
+    return d->weatherArr.size();
 }
 
 
 // Used to get the temperature for a certain day.
-int CWather::getTemperature(int index)
+int CWather::getTemperature(int index) const
 {
-    return weatherArr[index].m_temperature;
+    return d->weatherArr[index].m_temperature;
 }
 
 
 // Used to get the pressure for a certain day.
-unsigned int CWather::getPressure(int index)
+unsigned int CWather::getPressure(int index) const
 {
-    return weatherArr[index].m_pressure;
+    return d->weatherArr[index].m_pressure;
 }
 
 
 // Used to get the humidity for a certain day.
-int CWather::getHumidity(int index)
+int CWather::getHumidity(int index) const
+{
+    return d->weatherArr[index].m_humidity;
+}
+
+
+// Used to get the date of a certain day.
+QDate CWather::getDate(int index) const
+{
+    const weatherData& wData = d->weatherArr[index];
+    return QDate(wData.m_year, wData.m_month, wData.m_day);
+}
+
+
+// Used to get the value of a derived column for a certain day.
+double CWather::getDerivedValue(DerivedColumn column, int index) const
+{
+    return getDerivedColumns(*d)->getValue(d->weatherArr, column, index);
+}
+
+
+// Used to get the derived columns of a storage.
+std::shared_ptr<const CDerivedColumns> CWather::getDerivedColumns(const WeatherStorage& storage)
+{
+    QMutexLocker locker(&storage.cacheMutex);
+
+    if (!storage.derivedColumns) {
+        storage.derivedColumns = std::make_shared<const CDerivedColumns>(static_cast<int>(storage.weatherArr.size()));
+    }
+
+    return storage.derivedColumns;
+}
+
+
+// Used to get the cached runs of consecutive days when the wind direction did not change.
+std::shared_ptr<const std::vector<CWather::dayRun>> CWather::getWindRuns() const
 {
-    return weatherArr[index].m_humidity;
+    QMutexLocker locker(&d->cacheMutex);
+
+    if (!d->windRuns) {
+        auto runs = std::make_shared<std::vector<dayRun>>();
+        for (const std::vector<unsigned>& indexArr : getView().findDaysWindNotChange()) {
+            runs->push_back({static_cast<int>(indexArr.front()), static_cast<int>(indexArr.size())});
+        }
+
+        d->windRuns = runs;
+    }
+
+    return d->windRuns;
+}
+
+
+// Used to get the cached stable periods of consecutive days.
+std::shared_ptr<const std::vector<CWather::dayRun>> CWather::getStablePeriods() const
+{
+    QMutexLocker locker(&d->cacheMutex);
+
+    if (!d->stablePeriods) {
+        WeatherView view = getView();
+        auto periods = std::make_shared<std::vector<dayRun>>();
+
+        for (const WeatherView& period : view.findPeriodTemperatureAndPressureChangeWithinRange(STABLE_T_RANGE_PCT,
+                                                                                                STABLE_PSRE_RANGE_PCT)) {
+            // The periods are parts of the view of all days, so their first days are found by address.
+            periods->push_back({static_cast<int>(&period.at(0) - &view.at(0)), period.getWeatherSize()});
+        }
+
+        d->stablePeriods = periods;
+    }
+
+    return d->stablePeriods;
 }
 
 
 // Overriding the >> operation for reading data from a file using QTextStream.
 QTextStream& operator>>(QTextStream &inFile, CWather &weather)
 {
-    weather.weatherArr.clear();
+    // Start from a new storage, so data shared with other objects is not copied just to be cleared.
+    weather.d.reset(new CWather::WeatherStorage);
+    std::vector<CWather::weatherData>& weatherArr = weather.d->weatherArr;
 
     // Reading data until the end of the file is reached.
     while (!inFile.atEnd())
@@ -510,9 +592,12 @@ QTextStream& operator>>(QTextStream &inFile, CWather &weather)
         wData.m_windDirection = convertTextToWindDir(windDirection);
 
         // Adding the constructed weatherData object to the weatherArr vector.
-        weather.weatherArr.push_back(wData);
+        weatherArr.push_back(wData);
     }
 
+    // Build the rollups while the data is loaded.
+    weather.getRollups();
+
     return inFile;
 }
 
@@ -520,22 +605,25 @@ QTextStream& operator>>(QTextStream &inFile, CWather &weather)
 // Adds data about one day of weather.
 void CWather::pushWeatherDataEnd(const weatherData &wData)
 {
-    weatherArr.push_back(wData);
+    d->weatherArr.push_back(wData);
+    updateCachesOnAppend(d->weatherArr.size() - 1);
 }
 
 
 // Overriding the << operation for writing data to a file using QTextStream.
 QTextStream& operator<<(QTextStream& out, const CWather& weather)
 {
-    for (int i = 0; i < weather.weatherArr.size(); ++i)
+    const std::vector<CWather::weatherData>& weatherArr = weather.d->weatherArr;
+
+    for (int i = 0; i < weatherArr.size(); ++i)
     {
         // Writing weather data to the QTextStream.
-        out << weather.weatherArr[i].m_year << " " << static_cast<int>(weather.weatherArr[i].m_month) << " " << weather.weatherArr[i].m_day
-            << " " <<  weather.weatherArr[i].m_temperature << " " << weather.weatherArr[i].m_pressure << " " << weather.weatherArr[i].m_humidity
-            << " " << convertWindDirToText(weather.weatherArr[i].m_windDirection);
+        out << weatherArr[i].m_year << " " << static_cast<int>(weatherArr[i].m_month) << " " << weatherArr[i].m_day
+            << " " <<  weatherArr[i].m_temperature << " " << weatherArr[i].m_pressure << " " << weatherArr[i].m_humidity
+            << " " << convertWindDirToText(weatherArr[i].m_windDirection);
 
         // Adding a newline character unless it's the last record.
-        if(i != weather.weatherArr.size() - 1){
+        if(i != weatherArr.size() - 1){
             out << "\n";
         }
     }
@@ -632,6 +720,13 @@ double getPercentageOf(double digit)
 }
 
 
+// Rounds a value to two decimal places.
+double roundToHundredths(double value)
+{
+    return qRound(value * 100.0) / 100.0;
+}
+
+
 // Returns the number of days in a specific month of a given year.
 int getNumDaysInMonth(Month month, int year)
 {
@@ -0,0 +1,246 @@
+#include "../Header Files/derivedcolumns.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+// The measured columns of a block of days copied into contiguous arrays (the input of the derived column expressions).
+struct columnBlock
+{
+    int m_count = 0;
+    std::vector<double> m_temperature, m_pressure, m_previousPressure, m_humidity, m_monthlyMeanTemperature;
+};
+
+
+// Declaration of a derived column: its names and the expression that computes the values of a block of days.
+struct columnDeclaration
+{
+    const char* m_name;
+    const char* m_title;
+    bool m_isClimatologyUsed;
+    void (*m_compute)(const columnBlock& block, double* values);
+};
+
+
+// Dew point (Magnus formula); humidity below 1% is taken as 1%, where the dew point is still defined.
+static void computeDewPoint(const columnBlock& block, double* values)
+{
+    const double b = 17.62, c = 243.12;
+
+    for (int i = 0; i < block.m_count; ++i)
+    {
+        double humidity = std::min(std::max(block.m_humidity[i], 1.0), 100.0);
+        double gamma = std::log(humidity / 100.0) + b * block.m_temperature[i] / (c + block.m_temperature[i]);
+        values[i] = c * gamma / (b - gamma);
+    }
+}
+
+
+// Heat index (the regression of the US National Weather Service, computed in °F); below 80°F the simple formula is used.
+static void computeHeatIndex(const columnBlock& block, double* values)
+{
+    for (int i = 0; i < block.m_count; ++i)
+    {
+        double t = block.m_temperature[i] * 9.0 / 5.0 + 32.0;
+        double rh = block.m_humidity[i];
+
+        double heatIndex = 0.5 * (t + 61.0 + (t - 68.0) * 1.2 + rh * 0.094);
+
+        if ((heatIndex + t) / 2.0 >= 80.0)
+        {
+            heatIndex = -42.379 + 2.04901523 * t + 10.14333127 * rh - 0.22475541 * t * rh - 0.00683783 * t * t
+                        - 0.05481717 * rh * rh + 0.00122874 * t * t * rh + 0.00085282 * t * rh * rh
+                        - 0.00000199 * t * t * rh * rh;
+
+            // Adjustments for dry and for humid air.
+            if (rh < 13.0 && t >= 80.0 && t <= 112.0) {
+                heatIndex -= (13.0 - rh) / 4.0 * std::sqrt((17.0 - std::fabs(t - 95.0)) / 17.0);
+            } else if (rh > 85.0 && t >= 80.0 && t <= 87.0) {
+                heatIndex += (rh - 85.0) / 10.0 * ((87.0 - t) / 5.0);
+            }
+        }
+
+        values[i] = (heatIndex - 32.0) * 5.0 / 9.0;
+    }
+}
+
+
+// Pressure tendency: the change of the pressure since the day before (NaN when the previous row is not the day before, as
+// for the first day or after a missing day).
+static void computePressureTendency(const columnBlock& block, double* values)
+{
+    for (int i = 0; i < block.m_count; ++i) {
+        values[i] = block.m_pressure[i] - block.m_previousPressure[i];
+    }
+}
+
+
+// Temperature anomaly: the difference from the mean temperature of the calendar month.
+static void computeTemperatureAnomaly(const columnBlock& block, double* values)
+{
+    for (int i = 0; i < block.m_count; ++i) {
+        values[i] = block.m_temperature[i] - block.m_monthlyMeanTemperature[i];
+    }
+}
+
+
+// Declarations of the derived columns (in the order of DerivedColumn).
+static const columnDeclaration declarations[CDerivedColumns::COLUMN_CNT] = {
+    { "dewpoint", "Dew point, °C", false, computeDewPoint },
+    { "heatindex", "Heat index, °C", false, computeHeatIndex },
+    { "tendency", "Pressure tendency, mmHg/day", false, computePressureTendency },
+    { "anomaly", "Temperature anomaly, °C", true, computeTemperatureAnomaly }
+};
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// Constructor with parameters.
+CDerivedColumns::CDerivedColumns(int dayCount)
+    : dayCount(dayCount), blockCount((dayCount + BLOCK_SIZE - 1) / BLOCK_SIZE), isClimatologyReady(false)
+{
+    for (columnValues& values : columns) {
+        values.m_isBlockReady.reset(new std::atomic<bool>[blockCount]());
+    }
+
+    std::fill(monthlyMeanTemperature, monthlyMeanTemperature + 13, 0.0);
+}
+
+
+// Used to get the value of a derived column for a certain day.
+double CDerivedColumns::getValue(const std::vector<CWather::weatherData>& weatherArr, DerivedColumn column, int index) const
+{
+    return getBlock(weatherArr, column, index / BLOCK_SIZE)[index];
+}
+
+
+// Copies the values of a derived column for a range of days into a contiguous array.
+void CDerivedColumns::getValues(const std::vector<CWather::weatherData>& weatherArr, DerivedColumn column, int firstIndex,
+                                int count, double* values) const
+{
+    int endIndex = firstIndex + count;
+
+    // Copy the part of every block the range covers.
+    for (int index = firstIndex; index < endIndex; )
+    {
+        int blockEnd = std::min((index / BLOCK_SIZE + 1) * BLOCK_SIZE, endIndex);
+        const double* blockValues = getBlock(weatherArr, column, index / BLOCK_SIZE);
+
+        values = std::copy(blockValues + index, blockValues + blockEnd, values);
+        index = blockEnd;
+    }
+}
+
+
+// Used to get the name of a derived column in filter expressions.
+QString CDerivedColumns::getName(DerivedColumn column)
+{
+    return QString(declarations[column - 1].m_name);
+}
+
+
+// Used to get the title of a derived column with its unit.
+QString CDerivedColumns::getTitle(DerivedColumn column)
+{
+    return QString(declarations[column - 1].m_title);
+}
+
+
+// Finds a derived column by its name in filter expressions.
+bool CDerivedColumns::findColumn(const QString& name, DerivedColumn& column)
+{
+    for (int i = 0; i < COLUMN_CNT; ++i) {
+        if (name.toLower() == declarations[i].m_name) {
+            column = static_cast<DerivedColumn>(i + 1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+// Used to get the memoized values of a derived column, making sure a block of them is computed.
+const double* CDerivedColumns::getBlock(const std::vector<CWather::weatherData>& weatherArr, DerivedColumn column, int block) const
+{
+    columnValues& values = columns[column - 1];
+
+    // A computed block is read without locking.
+    if (values.m_isBlockReady[block].load(std::memory_order_acquire)) {
+        return values.m_values.data();
+    }
+
+    QMutexLocker locker(&mutex);
+
+    // Another thread may have computed the block in the meantime.
+    if (values.m_isBlockReady[block].load(std::memory_order_relaxed)) {
+        return values.m_values.data();
+    }
+
+    if (values.m_values.empty()) {
+        values.m_values.resize(dayCount);
+    }
+
+    const columnDeclaration& declaration = declarations[column - 1];
+
+    // The climatology of the temperature anomaly needs all the days, so it is computed once, with the first such block.
+    if (declaration.m_isClimatologyUsed && !isClimatologyReady)
+    {
+        double temperatureSums[13] = {};
+        int dayCounts[13] = {};
+
+        for (const CWather::weatherData& wData : weatherArr) {
+            int month = wData.m_month >= 1 && wData.m_month <= 12 ? wData.m_month : 0;
+            temperatureSums[month] += wData.m_temperature;
+            dayCounts[month]++;
+        }
+
+        for (int month = 0; month < 13; ++month) {
+            monthlyMeanTemperature[month] = dayCounts[month] == 0 ? 0 : temperatureSums[month] / dayCounts[month];
+        }
+
+        isClimatologyReady = true;
+    }
+
+    // Copy the measured columns of the block into contiguous arrays, so the expression runs over plain arrays.
+    int firstIndex = block * BLOCK_SIZE;
+
+    columnBlock input;
+    input.m_count = std::min(BLOCK_SIZE, dayCount - firstIndex);
+    input.m_temperature.resize(input.m_count);
+    input.m_pressure.resize(input.m_count);
+    input.m_previousPressure.resize(input.m_count);
+    input.m_humidity.resize(input.m_count);
+    input.m_monthlyMeanTemperature.resize(input.m_count);
+
+    // The previous pressure is known only when the previous row is the day before (-1 is the day number of an invalid date).
+    auto getDayNumber = [](const CWather::weatherData& wData) {
+        QDate date(wData.m_year, wData.m_month, wData.m_day);
+        return date.isValid() ? date.toJulianDay() : qint64(-1);
+    };
+
+    qint64 previousDayNumber = firstIndex == 0 ? -1 : getDayNumber(weatherArr[firstIndex - 1]);
+
+    for (int i = 0; i < input.m_count; ++i)
+    {
+        const CWather::weatherData& wData = weatherArr[firstIndex + i];
+        int month = wData.m_month >= 1 && wData.m_month <= 12 ? wData.m_month : 0;
+        qint64 dayNumber = getDayNumber(wData);
+
+        input.m_temperature[i] = wData.m_temperature;
+        input.m_pressure[i] = wData.m_pressure;
+        input.m_previousPressure[i] = dayNumber != -1 && previousDayNumber != -1 && dayNumber == previousDayNumber + 1
+                                          ? weatherArr[firstIndex + i - 1].m_pressure : std::numeric_limits<double>::quiet_NaN();
+        input.m_humidity[i] = wData.m_humidity;
+        input.m_monthlyMeanTemperature[i] = monthlyMeanTemperature[month];
+
+        previousDayNumber = dayNumber;
+    }
+
+    declaration.m_compute(input, values.m_values.data() + firstIndex);
+
+    values.m_isBlockReady[block].store(true, std::memory_order_release);
+
+    return values.m_values.data();
+}
@@ -0,0 +1,273 @@
+#include "../Header Files/eventdetector.h"
+#include "../Header Files/weatherdataset.h"
+#include "../Header Files/rollups.h"
+#include "../Header Files/weathergaps.h"
+#include <algorithm>
+#include <array>
+#include <deque>
+
+
+// State of one rule while the days are scanned.
+struct ruleState
+{
+    // The first day and the most extreme value of the current run (run rules, -1 when there is no run).
+    int m_runStart = -1;
+    int m_runExtreme = 0;
+    // Days of the preceding window that can still be its extreme (change rules): index and the value times the sign of
+    // the rule, the values decrease from the front.
+    std::deque<std::pair<int, int>> m_candidates;
+    // The range and the largest change of the current event (change rules, -1 when there is no event).
+    int m_eventStart = -1, m_eventEnd = -1;
+    int m_eventExtreme = 0;
+};
+
+
+// Constructor with parameters.
+CEventDetector::CEventDetector(std::vector<eventRule> rules) : rules(std::move(rules))
+{}
+
+
+// Used to get the rules events are detected by.
+const std::vector<CEventDetector::eventRule>& CEventDetector::getRules() const
+{
+    return rules;
+}
+
+
+// Detects the events in weather data.
+std::vector<CEventDetector::extremeEvent> CEventDetector::detect(const CWather& weather, DayContinuity continuity) const
+{
+    // Histograms of every used column over all the days (index 0) and the days of every calendar month, merged from the
+    // monthly histograms of the rollups.
+    std::shared_ptr<const CWeatherRollups> rollups = weather.getRollups();
+    std::array<std::vector<CValueHistogram>, 3> histograms;
+
+    for (const eventRule& rule : rules)
+    {
+        std::vector<CValueHistogram>& columnHistograms = histograms[rule.m_column - 1];
+        if (rule.m_type > RunBelowPercentile || !columnHistograms.empty()) {
+            continue;
+        }
+
+        columnHistograms.resize(13);
+        for (const CWeatherRollups::rollupBucket& bucket : rollups->getBuckets(MonthRollup)) {
+            CValueHistogram histogram = rollups->getBucketHistogram(MonthRollup, bucket, rule.m_column);
+            columnHistograms[bucket.m_number] += histogram;
+            columnHistograms[0] += histogram;
+        }
+    }
+
+    // The thresholds of the run rules (a month without days uses the threshold of all the days).
+    std::vector<int> thresholds(rules.size() * 13, 0);
+
+    for (int r = 0; r < rules.size(); ++r)
+    {
+        const eventRule& rule = rules[r];
+        if (rule.m_type > RunBelowPercentile) {
+            continue;
+        }
+
+        const std::vector<CValueHistogram>& columnHistograms = histograms[rule.m_column - 1];
+        int allDaysThreshold = columnHistograms[0].getPercentile(rule.m_percentile);
+
+        for (int month = 0; month <= 12; ++month) {
+            thresholds[r * 13 + month] = rule.m_isMonthlyPercentile && columnHistograms[month].getCount() > 0
+                                             ? columnHistograms[month].getPercentile(rule.m_percentile) : allDaysThreshold;
+        }
+    }
+
+    // Scan the runs of consecutive days.
+    std::vector<extremeEvent> events;
+    WeatherView view = weather.getView();
+
+    if (continuity == AssumeConsecutiveDays)
+    {
+        detectInRange(view, 0, view.getWeatherSize(), thresholds, events);
+    }
+    else if (continuity == SplitAtGaps)
+    {
+        CWeatherGaps gaps(view);
+        for (const CWeatherGaps::daySegment& segment : gaps.getSegments()) {
+            detectInRange(view, segment.m_firstIndex, segment.m_dayCount, thresholds, events);
+        }
+    }
+    else
+    {
+        // Scan the filled days and trim every event to the first and the last original day it covers (an event of filled
+        // days only is dropped). The filled days are in date order, which the rows need not be, so the event keeps its
+        // dates and the number of days between them, and refers to the row of its first day.
+        CWeatherGaps::filledWeather filled = CWeatherGaps::fillGaps(view, CWeatherGaps::LinearFill);
+        WeatherView filledView = filled.m_weather.getView();
+
+        std::vector<extremeEvent> filledEvents;
+        detectInRange(filledView, 0, filledView.getWeatherSize(), thresholds, filledEvents);
+
+        for (extremeEvent event : filledEvents)
+        {
+            int first = event.m_firstIndex, last = event.m_firstIndex + event.m_dayCount - 1;
+            while (first <= last && filled.m_sourceIndexes[first] < 0) {
+                first++;
+            }
+            while (last >= first && filled.m_sourceIndexes[last] < 0) {
+                last--;
+            }
+
+            if (first <= last) {
+                event.m_firstIndex = filled.m_sourceIndexes[first];
+                event.m_dayCount = last - first + 1;
+                event.m_firstDate = filledView.getDate(first);
+                event.m_lastDate = filledView.getDate(last);
+                events.push_back(event);
+            }
+        }
+    }
+
+    std::sort(events.begin(), events.end(), [](const extremeEvent& a, const extremeEvent& b) {
+        return a.m_firstIndex != b.m_firstIndex ? a.m_firstIndex < b.m_firstIndex : a.m_ruleIndex < b.m_ruleIndex;
+    });
+
+    return events;
+}
+
+
+// Detects the events of every station of a dataset (stations are searched in parallel).
+std::vector<std::vector<CEventDetector::extremeEvent>> CEventDetector::detectStations(const CWeatherDataset& dataset,
+                                                                                     DayContinuity continuity) const
+{
+    return dataset.mapStations([this, continuity](const CWather& weather) {
+        return detect(weather, continuity);
+    });
+}
+
+
+// Used to get the default rules.
+std::vector<CEventDetector::eventRule> CEventDetector::getDefaultRules()
+{
+    eventRule heatWave;
+    heatWave.m_name = "Heat wave";
+    heatWave.m_type = RunAbovePercentile;
+    heatWave.m_column = TemperatureColumn;
+    heatWave.m_percentile = 90;
+    heatWave.m_minDayCount = 3;
+
+    eventRule coldSpell;
+    coldSpell.m_name = "Cold spell";
+    coldSpell.m_type = RunBelowPercentile;
+    coldSpell.m_column = TemperatureColumn;
+    coldSpell.m_percentile = 10;
+    coldSpell.m_minDayCount = 3;
+
+    eventRule pressureFall;
+    pressureFall.m_name = "Pressure fall";
+    pressureFall.m_type = FallWithinWindow;
+    pressureFall.m_column = PressureColumn;
+    pressureFall.m_windowDays = 3;
+    pressureFall.m_minChange = 8;
+
+    return { heatWave, coldSpell, pressureFall };
+}
+
+
+// Detects the events in a range of consecutive days.
+void CEventDetector::detectInRange(const WeatherView& weather, int firstIndex, int dayCount, const std::vector<int>& thresholds,
+                                   std::vector<extremeEvent>& events) const
+{
+    std::vector<ruleState> states(rules.size());
+    int endIndex = firstIndex + dayCount;
+
+    // Adds the current run of a rule to the events if it is long enough.
+    auto closeRun = [&](int r, int endDay) {
+        ruleState& state = states[r];
+        if (state.m_runStart >= 0 && endDay - state.m_runStart >= std::max(1, rules[r].m_minDayCount)) {
+            events.push_back({r, state.m_runStart, endDay - state.m_runStart, state.m_runExtreme, weather.getDate(state.m_runStart),
+                              weather.getDate(endDay - 1)});
+        }
+        state.m_runStart = -1;
+    };
+
+    // Adds the current event of a change rule to the events.
+    auto closeEvent = [&](int r) {
+        ruleState& state = states[r];
+        if (state.m_eventStart >= 0) {
+            events.push_back({r, state.m_eventStart, state.m_eventEnd - state.m_eventStart + 1, state.m_eventExtreme,
+                              weather.getDate(state.m_eventStart), weather.getDate(state.m_eventEnd)});
+        }
+        state.m_eventStart = -1;
+    };
+
+    // Move all the rules forward by one day at a time.
+    for (int i = firstIndex; i < endIndex; ++i)
+    {
+        int month = weather.at(i).m_month;
+        if (month < 1 || month > 12) {
+            month = 0;
+        }
+
+        for (int r = 0; r < rules.size(); ++r)
+        {
+            const eventRule& rule = rules[r];
+            ruleState& state = states[r];
+            int value = weather.getColumnValue(rule.m_column, i);
+
+            if (rule.m_type == RunAbovePercentile || rule.m_type == RunBelowPercentile)
+            {
+                int threshold = thresholds[r * 13 + month];
+                bool isAbove = rule.m_type == RunAbovePercentile;
+
+                if (isAbove ? value > threshold : value < threshold) {
+                    if (state.m_runStart < 0) {
+                        state.m_runStart = i;
+                        state.m_runExtreme = value;
+                    } else {
+                        state.m_runExtreme = isAbove ? std::max(state.m_runExtreme, value) : std::min(state.m_runExtreme, value);
+                    }
+                } else {
+                    closeRun(r, i);
+                }
+
+                continue;
+            }
+
+            // A fall is measured from the highest value of the window, a rise from the lowest one: both are the highest
+            // value times the sign.
+            int signedValue = rule.m_type == FallWithinWindow ? value : -value;
+
+            // Remove the day that left the window.
+            while (!state.m_candidates.empty() && state.m_candidates.front().first < i - rule.m_windowDays) {
+                state.m_candidates.pop_front();
+            }
+
+            // Start or extend an event if the change from the extreme of the window is large enough (windows that overlap
+            // the current event extend it).
+            if (!state.m_candidates.empty())
+            {
+                auto [extremeIndex, extremeValue] = state.m_candidates.front();
+                int change = extremeValue - signedValue;
+
+                if (change >= rule.m_minChange && change > 0)
+                {
+                    if (state.m_eventStart >= 0 && extremeIndex <= state.m_eventEnd) {
+                        state.m_eventEnd = i;
+                        state.m_eventExtreme = std::max(state.m_eventExtreme, change);
+                    } else {
+                        closeEvent(r);
+                        state.m_eventStart = extremeIndex;
+                        state.m_eventEnd = i;
+                        state.m_eventExtreme = change;
+                    }
+                }
+            }
+
+            // Add the day to the window.
+            while (!state.m_candidates.empty() && state.m_candidates.back().second <= signedValue) {
+                state.m_candidates.pop_back();
+            }
+            state.m_candidates.push_back({i, signedValue});
+        }
+    }
+
+    for (int r = 0; r < rules.size(); ++r) {
+        closeRun(r, endIndex);
+        closeEvent(r);
+    }
+}
@@ -0,0 +1,246 @@
+#include "../Header Files/externalsort.h"
+#include <QCommandLineParser>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <memory>
+#include <queue>
+
+
+// Constructor with parameters.
+CWeatherExternalSort::CWeatherExternalSort(qint64 memoryBudget, duplicatePolicy policy)
+    : memoryBudget(memoryBudget), policy(policy)
+{}
+
+
+// Sorts and merges files.
+CWeatherExternalSort::sortSummary CWeatherExternalSort::sortFiles(const QStringList& inputFiles, const QString& outputFile,
+                                                                  bool binaryOutput) const
+{
+    sortSummary summary;
+
+    QTemporaryDir runDir;
+    if (!runDir.isValid()) {
+        throw QString("A temporary folder for sorting could not be created.");
+    }
+
+    // A run takes the memory budget less the block buffers of the reader and of the run writer.
+    int blockSize = static_cast<int>(std::min<qint64>(CWeatherFileReader::BLOCK_SIZE, std::max<qint64>(memoryBudget / 8, 1 << 16)));
+    qint64 runDayCount = std::max<qint64>((memoryBudget - 2 * blockSize) / static_cast<qint64>(sizeof(CWather::weatherData)), 1024);
+
+    // The binary format holds a smaller range of values than the text one, so the runs are binary only if all the inputs are.
+    bool binaryRuns = true;
+    for (const QString& inputFile : inputFiles) {
+        if (!CWeatherFileReader(inputFile, 64).isBinary()) {
+            binaryRuns = false;
+            break;
+        }
+    }
+
+    // Days of the current run with their dates as ordinal numbers.
+    std::vector<std::pair<qint64, CWather::weatherData>> runDays;
+    runDays.reserve(static_cast<size_t>(std::min<qint64>(runDayCount, 1 << 20)));
+    QStringList runFiles;
+
+    // Sorts the days of the current run (days with the same date keep their order) and writes them to a new run.
+    auto writeRun = [&]() {
+        std::stable_sort(runDays.begin(), runDays.end(), [](const std::pair<qint64, CWather::weatherData>& a,
+                                                            const std::pair<qint64, CWather::weatherData>& b) {
+            return a.first < b.first;
+        });
+
+        runFiles << runDir.filePath(QString("run%1.run").arg(runFiles.size()));
+        CWeatherFileWriter writer(runFiles.back(), binaryRuns, blockSize);
+        for (const std::pair<qint64, CWather::weatherData>& day : runDays) {
+            writer.writeDay(day.second);
+        }
+        writer.close();
+
+        runDays.clear();
+    };
+
+    // Split the input into sorted runs.
+    for (const QString& inputFile : inputFiles)
+    {
+        CWeatherFileReader reader(inputFile, blockSize);
+        CWather::weatherData wData;
+        int stationNumber = -1;
+
+        while (reader.readDay(wData))
+        {
+            // The days of different stations would be merged into one series (and dropped as duplicates).
+            if (stationNumber < 0) {
+                stationNumber = reader.getStationNumber();
+            } else if (reader.getStationNumber() != stationNumber) {
+                throw QString(inputFile + ": The file contains several stations; only files of one station can be sorted.");
+            }
+
+            summary.m_readDayCount++;
+
+            QDate date(wData.m_year, wData.m_month, wData.m_day);
+            if (!date.isValid()) {
+                summary.m_invalidDayCount++;
+                continue;
+            }
+
+            runDays.emplace_back(date.toJulianDay(), wData);
+
+            if (static_cast<qint64>(runDays.size()) >= runDayCount) {
+                writeRun();
+            }
+        }
+    }
+
+    if (!runDays.empty() || runFiles.isEmpty()) {
+        writeRun();
+    }
+
+    std::vector<std::pair<qint64, CWather::weatherData>>().swap(runDays);
+    summary.m_runCount = runFiles.size();
+
+    // Merge groups of runs into longer runs until all of them can be merged at once.
+    int passNumber = 0;
+    while (runFiles.size() > MAX_MERGE_WAYS)
+    {
+        QStringList mergedFiles;
+        passNumber++;
+
+        for (int first = 0; first < runFiles.size(); first += MAX_MERGE_WAYS) {
+            mergedFiles << runDir.filePath(QString("pass%1_run%2.run").arg(passNumber).arg(mergedFiles.size()));
+            CWeatherFileWriter writer(mergedFiles.back(), binaryRuns, blockSize);
+            mergeRuns(runFiles.mid(first, MAX_MERGE_WAYS), writer, nullptr);
+            writer.close();
+        }
+
+        for (const QString& runFile : runFiles) {
+            QFile::remove(runFile);
+        }
+
+        runFiles = mergedFiles;
+    }
+
+    // The last merge writes the output (and finds the duplicates).
+    CWeatherFileWriter writer(outputFile, binaryOutput, blockSize);
+    mergeRuns(runFiles, writer, &summary);
+    writer.close();
+
+    summary.m_writtenDayCount = writer.getDayCount();
+
+    return summary;
+}
+
+
+// Merges sorted runs into one file.
+void CWeatherExternalSort::mergeRuns(const QStringList& runFiles, CWeatherFileWriter& writer, sortSummary* summary) const
+{
+    // The memory budget is shared by the block buffers of the runs.
+    int blockSize = static_cast<int>(std::clamp<qint64>(memoryBudget / (runFiles.size() + 1), 1 << 16, CWeatherFileReader::BLOCK_SIZE));
+
+    std::vector<std::unique_ptr<CWeatherFileReader>> readers;
+    std::vector<CWather::weatherData> heads(runFiles.size());
+
+    // The next day of every run ordered by date, then by run (earlier runs hold earlier input days).
+    using headKey = std::pair<qint64, int>;
+    std::priority_queue<headKey, std::vector<headKey>, std::greater<headKey>> queue;
+
+    // Reads the next day of a run into the queue.
+    auto readHead = [&](int runIndex) {
+        CWather::weatherData& wData = heads[runIndex];
+        if (readers[runIndex]->readDay(wData)) {
+            queue.emplace(QDate(wData.m_year, wData.m_month, wData.m_day).toJulianDay(), runIndex);
+        }
+    };
+
+    for (int i = 0; i < runFiles.size(); ++i) {
+        readers.push_back(std::make_unique<CWeatherFileReader>(runFiles[i], blockSize));
+        readHead(i);
+    }
+
+    qint64 previousDate = 0;
+    bool isFirstDay = true;
+
+    while (!queue.empty())
+    {
+        headKey head = queue.top();
+        queue.pop();
+
+        bool isDuplicate = !isFirstDay && head.first == previousDate;
+
+        if (summary != nullptr && isDuplicate && (summary->m_duplicateDates.empty()
+                                                  || summary->m_duplicateDates.back().toJulianDay() != head.first)) {
+            summary->m_duplicateDates.push_back(QDate::fromJulianDay(head.first));
+        }
+
+        if (summary == nullptr || !isDuplicate || policy == KeepDuplicates) {
+            writer.writeDay(heads[head.second]);
+        }
+
+        previousDate = head.first;
+        isFirstDay = false;
+
+        readHead(head.second);
+    }
+}
+
+
+// Runs the sort from the command line.
+int CWeatherExternalSort::runCommandLine(const QStringList& arguments)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Sorts weather files by date and merges them into one file.");
+    parser.addHelpOption();
+
+    QCommandLineOption sortOption("sort", "Sort and merge files (without opening the window).");
+    QCommandLineOption binaryOption("binary", "Write the output in the binary format.");
+    QCommandLineOption keepOption("keep-duplicates", "Keep days with the date of the previous day.");
+    QCommandLineOption memoryOption("memory", "Memory budget in megabytes (256 by default).", "MB", "256");
+    parser.addOption(sortOption);
+    parser.addOption(binaryOption);
+    parser.addOption(keepOption);
+    parser.addOption(memoryOption);
+    parser.addPositionalArgument("output", "The output file.");
+    parser.addPositionalArgument("inputs", "The input files (text or binary).", "<inputs...>");
+
+    if (!parser.parse(arguments)) {
+        err << parser.errorText() << "\n";
+        return 1;
+    }
+
+    if (parser.isSet("help")) {
+        out << parser.helpText();
+        return 0;
+    }
+
+    bool isOk;
+    int memoryMb = parser.value(memoryOption).toInt(&isOk);
+    QStringList files = parser.positionalArguments();
+
+    if (!isOk || memoryMb <= 0 || files.size() < 2) {
+        err << parser.helpText();
+        return 1;
+    }
+
+    CWeatherExternalSort sorter(static_cast<qint64>(memoryMb) << 20, parser.isSet(keepOption) ? KeepDuplicates : DropDuplicates);
+
+    try {
+        sortSummary summary = sorter.sortFiles(files.mid(1), files.front(), parser.isSet(binaryOption));
+
+        out << "Read days: " << summary.m_readDayCount << "\n"
+            << "Written days: " << summary.m_writtenDayCount << "\n"
+            << "Sorted runs: " << summary.m_runCount << "\n"
+            << "Days with invalid dates (skipped): " << summary.m_invalidDayCount << "\n"
+            << "Duplicate dates" << (parser.isSet(keepOption) ? " (kept)" : " (dropped)") << ": " << summary.m_duplicateDates.size() << "\n";
+
+        for (const QDate& date : summary.m_duplicateDates) {
+            out << "  " << date.toString("dd.MM.yyyy") << "\n";
+        }
+    } catch (const QString& exception) {
+        err << exception << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,293 @@
+#include "../Header Files/forecastbacktest.h"
+#include "../Header Files/weatherdataset.h"
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QtConcurrent>
+#include <cmath>
+
+
+// Sums of the errors of forecast days.
+struct errorSums
+{
+    double m_tAbs = 0, m_tSq = 0;
+    double m_pAbs = 0, m_pSq = 0;
+    double m_hAbs = 0, m_hSq = 0;
+    int m_windHits = 0;
+    int m_dayCount = 0;
+
+    // Adds the errors of one day.
+    void add(const CWather::weatherData& forecast, const CWather::weatherData& observed)
+    {
+        double tError = static_cast<double>(forecast.m_temperature) - observed.m_temperature;
+        double pError = static_cast<double>(forecast.m_pressure) - static_cast<double>(observed.m_pressure);
+        double hError = static_cast<double>(forecast.m_humidity) - observed.m_humidity;
+
+        m_tAbs += std::fabs(tError);
+        m_tSq += tError * tError;
+        m_pAbs += std::fabs(pError);
+        m_pSq += pError * pError;
+        m_hAbs += std::fabs(hError);
+        m_hSq += hError * hError;
+        m_windHits += forecast.m_windDirection == observed.m_windDirection ? 1 : 0;
+        m_dayCount++;
+    }
+
+    // Adds the sums of another month.
+    void add(const errorSums& other)
+    {
+        m_tAbs += other.m_tAbs;
+        m_tSq += other.m_tSq;
+        m_pAbs += other.m_pAbs;
+        m_pSq += other.m_pSq;
+        m_hAbs += other.m_hAbs;
+        m_hSq += other.m_hSq;
+        m_windHits += other.m_windHits;
+        m_dayCount += other.m_dayCount;
+    }
+
+    // Writes the mean errors into a score.
+    void toScore(CForecastBacktest::monthScore& score) const
+    {
+        score.m_dayCount = m_dayCount;
+
+        if (m_dayCount == 0) {
+            return;
+        }
+
+        score.m_temperature.m_mae = m_tAbs / m_dayCount;
+        score.m_temperature.m_rmse = std::sqrt(m_tSq / m_dayCount);
+        score.m_pressure.m_mae = m_pAbs / m_dayCount;
+        score.m_pressure.m_rmse = std::sqrt(m_pSq / m_dayCount);
+        score.m_humidity.m_mae = m_hAbs / m_dayCount;
+        score.m_humidity.m_rmse = std::sqrt(m_hSq / m_dayCount);
+        score.m_windHitRate = static_cast<double>(m_windHits) / m_dayCount;
+    }
+};
+
+
+// A month of the backtest: its days in the weather history and the errors of its forecast.
+struct backtestMonth
+{
+    int m_index = 0;
+    int m_firstIndex = 0;
+    int m_dayCount = 0;
+    CForecastBacktest::monthScore m_score;
+    errorSums m_sums;
+};
+
+
+// Runs a backtest.
+CForecastBacktest::backtestResult CForecastBacktest::run(const WeatherView& weather, quint64 seed, int minHistoryDays)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // Find the months: runs of neighbouring days with the same year and month, after the minimum history.
+    std::vector<backtestMonth> months;
+    int size = weather.getWeatherSize();
+
+    for (int i = 0; i < size; )
+    {
+        const CWather::weatherData& first = weather.at(i);
+        int end = i + 1;
+        while (end < size && weather.at(end).m_year == first.m_year && weather.at(end).m_month == first.m_month) {
+            end++;
+        }
+
+        if (i >= minHistoryDays && QDate(first.m_year, first.m_month, 1).isValid())
+        {
+            backtestMonth month;
+            month.m_index = months.size();
+            month.m_firstIndex = i;
+            month.m_dayCount = end - i;
+            month.m_score.m_year = first.m_year;
+            month.m_score.m_month = first.m_month;
+            month.m_score.m_historyDayCount = i;
+            months.push_back(month);
+        }
+
+        i = end;
+    }
+
+    // Forecast every month from the days before it and compare the forecast with the observed days (months in parallel).
+    QtConcurrent::blockingMap(months, [&weather, seed](backtestMonth& month) {
+        CForecastEngine engine(weather.getSubView(0, month.m_firstIndex));
+        if (engine.isEmpty()) {
+            return;
+        }
+
+        Month monthOfYear = month.m_score.m_month;
+        int year = month.m_score.m_year;
+        int dayCount = getNumDaysInMonth(monthOfYear, year);
+
+        CRandomStream random(seed, month.m_index);
+        std::vector<CWather::weatherData> forecastArr = engine.forecast(QDate(year, monthOfYear, 1), dayCount, random);
+
+        for (int i = month.m_firstIndex; i < month.m_firstIndex + month.m_dayCount; ++i)
+        {
+            const CWather::weatherData& observed = weather.at(i);
+            if (QDate(observed.m_year, observed.m_month, observed.m_day).isValid() && observed.m_day <= forecastArr.size()) {
+                month.m_sums.add(forecastArr[observed.m_day - 1], observed);
+            }
+        }
+
+        month.m_sums.toScore(month.m_score);
+    });
+
+    // Collect the scored months and the total score.
+    backtestResult result;
+    errorSums totalSums;
+
+    for (const backtestMonth& month : months) {
+        if (month.m_sums.m_dayCount > 0) {
+            result.m_months.push_back(month.m_score);
+            totalSums.add(month.m_sums);
+        }
+    }
+
+    totalSums.toScore(result.m_total);
+    result.m_seconds = timer.nsecsElapsed() / 1e9;
+
+    return result;
+}
+
+
+// Formats the total score of a backtest as a report.
+QString CForecastBacktest::toText(const backtestResult& result)
+{
+    const monthScore& total = result.m_total;
+
+    return QString("Months: %1 (days: %2)\n").arg(result.m_months.size()).arg(total.m_dayCount)
+           + QString("Time: %1 s\n").arg(result.m_seconds, 0, 'f', 3)
+           + QString("Temperature MAE / RMSE: %1 / %2 °C\n").arg(total.m_temperature.m_mae, 0, 'f', 2)
+                 .arg(total.m_temperature.m_rmse, 0, 'f', 2)
+           + QString("Pressure MAE / RMSE: %1 / %2 mmHg\n").arg(total.m_pressure.m_mae, 0, 'f', 2)
+                 .arg(total.m_pressure.m_rmse, 0, 'f', 2)
+           + QString("Humidity MAE / RMSE: %1 / %2 %\n").arg(total.m_humidity.m_mae, 0, 'f', 2)
+                 .arg(total.m_humidity.m_rmse, 0, 'f', 2)
+           + QString("Wind hit rate: %1 %\n").arg(total.m_windHitRate * 100.0, 0, 'f', 1);
+}
+
+
+// Formats the scores of the months of a backtest as comma-separated values.
+QString CForecastBacktest::toCsv(const backtestResult& result, const QString& stationId, bool isHeaderIncluded)
+{
+    QString csv;
+
+    if (isHeaderIncluded) {
+        csv += "station,year,month,history_days,days,t_mae,t_rmse,pressure_mae,pressure_rmse,humidity_mae,humidity_rmse,"
+               "wind_hit_rate\n";
+    }
+
+    // Writes one line of the scores (the year and month columns are given as text).
+    auto appendLine = [&csv, &stationId](const QString& year, const QString& month, const monthScore& score) {
+        csv += stationId + "," + year + "," + month + "," + QString::number(score.m_historyDayCount) + ","
+               + QString::number(score.m_dayCount) + ","
+               + QString::number(score.m_temperature.m_mae, 'f', 3) + "," + QString::number(score.m_temperature.m_rmse, 'f', 3) + ","
+               + QString::number(score.m_pressure.m_mae, 'f', 3) + "," + QString::number(score.m_pressure.m_rmse, 'f', 3) + ","
+               + QString::number(score.m_humidity.m_mae, 'f', 3) + "," + QString::number(score.m_humidity.m_rmse, 'f', 3) + ","
+               + QString::number(score.m_windHitRate, 'f', 4) + "\n";
+    };
+
+    for (const monthScore& score : result.m_months) {
+        appendLine(QString::number(score.m_year), QString::number(static_cast<int>(score.m_month)), score);
+    }
+
+    appendLine("total", "", result.m_total);
+
+    return csv;
+}
+
+
+// Runs a backtest from the command line.
+int CForecastBacktest::runCommandLine(const QStringList& arguments)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays the history of a weather file and scores the monthly forecast of every month.");
+    parser.addHelpOption();
+
+    QCommandLineOption backtestOption("backtest", "Run the backtest (without opening the window).");
+    QCommandLineOption seedOption("seed", "The seed of the forecasts (1 by default).", "n", "1");
+    QCommandLineOption minHistoryOption("min-history", "The days of history a month needs to be forecast (365 by default).",
+                                        "days", QString::number(DEFAULT_MIN_HISTORY_DAYS));
+    QCommandLineOption csvOption("csv", "Write the scores of every month to a CSV file.", "file");
+    parser.addOption(backtestOption);
+    parser.addOption(seedOption);
+    parser.addOption(minHistoryOption);
+    parser.addOption(csvOption);
+    parser.addPositionalArgument("file", "The weather file (every station of it is backtested).", "<file>");
+
+    if (!parser.parse(arguments)) {
+        err << parser.errorText() << "\n";
+        return 1;
+    }
+
+    if (parser.isSet("help")) {
+        out << parser.helpText();
+        return 0;
+    }
+
+    bool isSeedOk, isMinHistoryOk;
+    quint64 seed = parser.value(seedOption).toULongLong(&isSeedOk);
+    int minHistoryDays = parser.value(minHistoryOption).toInt(&isMinHistoryOk);
+    QStringList files = parser.positionalArguments();
+
+    if (!isSeedOk || !isMinHistoryOk || minHistoryDays < 1 || files.size() != 1) {
+        err << parser.helpText();
+        return 1;
+    }
+
+    QString fileName = files.front();
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        err << fileName << ": File could not be opened.\n";
+        return 1;
+    }
+
+    CWeatherDataset dataset;
+    QTextStream in(&file);
+
+    try {
+        in >> dataset;
+    } catch (const QString& exception) {
+        err << fileName << ": " << exception << "\n";
+        return 1;
+    }
+
+    // Backtest the stations one after another (the months of each of them run in parallel).
+    QString csv;
+
+    for (int i = 0; i < dataset.getStationCount(); ++i)
+    {
+        CWeatherDataset::station stationData = dataset.getStation(i);
+        if (stationData.m_id.isEmpty()) {
+            stationData.m_id = QFileInfo(fileName).completeBaseName();
+        }
+
+        backtestResult result = run(stationData.m_weather, seed, minHistoryDays);
+
+        out << "Station " << stationData.m_id << "\n" << toText(result);
+        out.flush();
+
+        csv += toCsv(result, stationData.m_id, i == 0);
+    }
+
+    if (parser.isSet(csvOption))
+    {
+        QFile csvFile(parser.value(csvOption));
+        if (!csvFile.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+            err << csvFile.fileName() << ": File could not be written.\n";
+            return 1;
+        }
+
+        QTextStream csvOut(&csvFile);
+        csvOut << csv;
+    }
+
+    return 0;
+}
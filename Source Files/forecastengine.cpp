@@ -0,0 +1,427 @@
+#include "../Header Files/forecastengine.h"
+#include <QtMath>
+#include <QtConcurrent>
+#include <numeric>
+
+
+// Returns the next random number with the standard normal distribution (Box-Muller transform).
+double CRandomStream::nextGaussian()
+{
+    if (hasSpareGaussian) {
+        hasSpareGaussian = false;
+        return spareGaussian;
+    }
+
+    // 1 - nextDouble() is in (0, 1], so the logarithm is always defined.
+    double radius = std::sqrt(-2.0 * std::log(1.0 - nextDouble()));
+    double angle = 2.0 * M_PI * nextDouble();
+
+    spareGaussian = radius * std::sin(angle);
+    hasSpareGaussian = true;
+
+    return radius * std::cos(angle);
+}
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// Sums of the observations of one day of the year (or of a window of days).
+struct climateSums
+{
+    double m_count = 0;
+    double m_t = 0, m_tSq = 0;
+    double m_p = 0, m_pSq = 0;
+    double m_h = 0, m_hSq = 0;
+    std::array<double, CForecastEngine::WIND_DIRECTION_CNT> m_wind {};
+
+    // Adds the sums of another day (or window) to these sums.
+    void add(const climateSums& other)
+    {
+        m_count += other.m_count;
+        m_t += other.m_t;
+        m_tSq += other.m_tSq;
+        m_p += other.m_p;
+        m_pSq += other.m_pSq;
+        m_h += other.m_h;
+        m_hSq += other.m_hSq;
+
+        for (int i = 0; i < CForecastEngine::WIND_DIRECTION_CNT; ++i) {
+            m_wind[i] += other.m_wind[i];
+        }
+    }
+};
+
+
+// Variance from the sum and the sum of squares (never negative because of rounding errors).
+static double getVariance(double sum, double sumSq, double count)
+{
+    double mean = sum / count;
+    return std::max(0.0, sumSq / count - mean * mean);
+}
+
+
+// Linear interpolation between two climates (weight - share of 'to').
+static CForecastEngine::dayClimate interpolateClimate(const CForecastEngine::dayClimate& from,
+                                                      const CForecastEngine::dayClimate& to, double weight)
+{
+    CForecastEngine::dayClimate result;
+
+    auto lerp = [weight](double a, double b) { return a + (b - a) * weight; };
+
+    result.m_temperatureMean = lerp(from.m_temperatureMean, to.m_temperatureMean);
+    result.m_temperatureVariance = lerp(from.m_temperatureVariance, to.m_temperatureVariance);
+    result.m_pressureMean = lerp(from.m_pressureMean, to.m_pressureMean);
+    result.m_pressureVariance = lerp(from.m_pressureVariance, to.m_pressureVariance);
+    result.m_humidityMean = lerp(from.m_humidityMean, to.m_humidityMean);
+    result.m_humidityVariance = lerp(from.m_humidityVariance, to.m_humidityVariance);
+
+    for (int i = 0; i < CForecastEngine::WIND_DIRECTION_CNT; ++i) {
+        result.m_windCumulative[i] = lerp(from.m_windCumulative[i], to.m_windCumulative[i]);
+    }
+
+    return result;
+}
+
+
+// Draws the weather of one day from its climate.
+static CWather::weatherData drawWeather(const CForecastEngine::dayClimate& dClimate, const QDate& date, CRandomStream& random)
+{
+    // Draw the weather parameters from the normal distributions of the day.
+    int temperature = qRound(dClimate.m_temperatureMean + std::sqrt(dClimate.m_temperatureVariance) * random.nextGaussian());
+    int pressure = qRound(dClimate.m_pressureMean + std::sqrt(dClimate.m_pressureVariance) * random.nextGaussian());
+    int humidity = qRound(dClimate.m_humidityMean + std::sqrt(dClimate.m_humidityVariance) * random.nextGaussian());
+
+    // Draw the wind direction from the wind frequencies of the day.
+    double windValue = random.nextDouble();
+    int windIndex = 0;
+    while (windIndex < CForecastEngine::WIND_DIRECTION_CNT - 1 && windValue >= dClimate.m_windCumulative[windIndex]) {
+        windIndex++;
+    }
+
+    return CWather::weatherData(date.year(), static_cast<Month>(date.month()), date.day(), temperature,
+                                static_cast<unsigned>(std::max(1, pressure)), qBound(0, humidity, 100),
+                                static_cast<WindDirection>(windIndex + 1));
+}
+
+
+// Percentile of sorted values (linear interpolation between the closest ranks).
+static double getPercentile(std::vector<int>::const_iterator sortedFirst, int count, double percentile)
+{
+    double rank = percentile / 100.0 * (count - 1);
+    int lowerRank = static_cast<int>(rank);
+    int upperRank = std::min(lowerRank + 1, count - 1);
+
+    return sortedFirst[lowerRank] + (sortedFirst[upperRank] - sortedFirst[lowerRank]) * (rank - lowerRank);
+}
+
+
+// Default constructor (empty climatology).
+CForecastEngine::CForecastEngine()
+{}
+
+
+// Builds the climatology from the weather history in one pass.
+CForecastEngine::CForecastEngine(const WeatherView& history, int smoothingHalfWidth)
+{
+    // Collect the sums of each day of the year in one pass over the history.
+    std::vector<climateSums> daySums(DAYS_IN_CLIMATE_YEAR);
+
+    for (int i = 0; i < history.getWeatherSize(); ++i)
+    {
+        const CWather::weatherData& wData = history.at(i);
+        int dayIndex = getDayOfYearIndex(wData.m_month, wData.m_day);
+
+        if (dayIndex < 0) {
+            continue;
+        }
+
+        climateSums& sums = daySums[dayIndex];
+        sums.m_count += 1;
+        sums.m_t += wData.m_temperature;
+        sums.m_tSq += static_cast<double>(wData.m_temperature) * wData.m_temperature;
+        sums.m_p += wData.m_pressure;
+        sums.m_pSq += static_cast<double>(wData.m_pressure) * wData.m_pressure;
+        sums.m_h += wData.m_humidity;
+        sums.m_hSq += static_cast<double>(wData.m_humidity) * wData.m_humidity;
+
+        if (wData.m_windDirection != Undefined) {
+            sums.m_wind[static_cast<int>(wData.m_windDirection) - 1] += 1;
+        }
+    }
+
+    // Describe each day by the days within ±smoothingHalfWidth days of it (the calendar is circular).
+    std::vector<dayClimate> dayClimates(DAYS_IN_CLIMATE_YEAR);
+    std::vector<int> observedDays;
+
+    for (int day = 0; day < DAYS_IN_CLIMATE_YEAR; ++day)
+    {
+        climateSums window;
+        for (int shift = -smoothingHalfWidth; shift <= smoothingHalfWidth; ++shift) {
+            window.add(daySums[((day + shift) % DAYS_IN_CLIMATE_YEAR + DAYS_IN_CLIMATE_YEAR) % DAYS_IN_CLIMATE_YEAR]);
+        }
+
+        if (window.m_count == 0) {
+            continue;
+        }
+
+        dayClimate& dClimate = dayClimates[day];
+        dClimate.m_count = static_cast<int>(window.m_count);
+        dClimate.m_temperatureMean = window.m_t / window.m_count;
+        dClimate.m_temperatureVariance = getVariance(window.m_t, window.m_tSq, window.m_count);
+        dClimate.m_pressureMean = window.m_p / window.m_count;
+        dClimate.m_pressureVariance = getVariance(window.m_p, window.m_pSq, window.m_count);
+        dClimate.m_humidityMean = window.m_h / window.m_count;
+        dClimate.m_humidityVariance = getVariance(window.m_h, window.m_hSq, window.m_count);
+
+        // Cumulative wind frequencies (uniform if no wind direction was observed).
+        double windCount = 0;
+        for (int i = 0; i < WIND_DIRECTION_CNT; ++i) {
+            windCount += window.m_wind[i];
+        }
+
+        double cumulative = 0;
+        for (int i = 0; i < WIND_DIRECTION_CNT; ++i) {
+            cumulative += windCount > 0 ? window.m_wind[i] / windCount : 1.0 / WIND_DIRECTION_CNT;
+            dClimate.m_windCumulative[i] = cumulative;
+        }
+
+        observedDays.push_back(day);
+    }
+
+    if (observedDays.empty()) {
+        return;
+    }
+
+    // Fill the days without observations by interpolating between the nearest observed days.
+    for (int i = 0; i < observedDays.size(); ++i)
+    {
+        int from = observedDays[i];
+        int to = observedDays[(i + 1) % observedDays.size()];
+        int gap = (to - from + DAYS_IN_CLIMATE_YEAR) % DAYS_IN_CLIMATE_YEAR;
+
+        // A single observed day describes the whole year.
+        if (gap == 0) {
+            gap = DAYS_IN_CLIMATE_YEAR;
+        }
+
+        for (int shift = 1; shift < gap; ++shift) {
+            dayClimates[(from + shift) % DAYS_IN_CLIMATE_YEAR] =
+                interpolateClimate(dayClimates[from], dayClimates[to], static_cast<double>(shift) / gap);
+        }
+    }
+
+    climate = std::move(dayClimates);
+}
+
+
+// Determine if there is a climatology to forecast from.
+bool CForecastEngine::isEmpty() const
+{
+    return climate.empty();
+}
+
+
+// Used to get the climate of a certain day of the year.
+const CForecastEngine::dayClimate& CForecastEngine::getDayClimate(Month month, unsigned day) const
+{
+    int dayIndex = getDayOfYearIndex(month, day);
+    return climate[dayIndex < 0 ? 0 : dayIndex];
+}
+
+
+// Forecasts the weather for a number of days.
+std::vector<CWather::weatherData> CForecastEngine::forecast(QDate startDate, int dayCount, CRandomStream& random) const
+{
+    std::vector<CWather::weatherData> forecastArr;
+
+    if (isEmpty() || !startDate.isValid() || dayCount <= 0) {
+        return forecastArr;
+    }
+
+    forecastArr.reserve(dayCount);
+
+    QDate date = startDate;
+    for (int i = 0; i < dayCount; ++i, date = date.addDays(1)) {
+        forecastArr.push_back(drawWeather(getDayClimate(static_cast<Month>(date.month()), date.day()), date, random));
+    }
+
+    return forecastArr;
+}
+
+
+// Runs an ensemble (Monte Carlo) forecast.
+CForecastEngine::ensembleForecast CForecastEngine::forecastEnsemble(QDate startDate, int dayCount, int memberCount, quint64 seed) const
+{
+    ensembleForecast ensemble;
+    ensemble.m_startDate = startDate;
+
+    if (isEmpty() || !startDate.isValid() || dayCount <= 0 || memberCount <= 0) {
+        return ensemble;
+    }
+
+    ensemble.m_memberCount = memberCount;
+
+    // Dates and climates of the forecasted days are the same for all members, so they are found once.
+    std::vector<QDate> dates(dayCount);
+    std::vector<const dayClimate*> dayClimates(dayCount);
+    for (int day = 0; day < dayCount; ++day) {
+        dates[day] = startDate.addDays(day);
+        dayClimates[day] = &getDayClimate(static_cast<Month>(dates[day].month()), dates[day].day());
+    }
+
+    for (percentileBand* band : {&ensemble.m_temperature, &ensemble.m_pressure, &ensemble.m_humidity}) {
+        band->m_p10.resize(dayCount);
+        band->m_p50.resize(dayCount);
+        band->m_p90.resize(dayCount);
+    }
+
+    // Every member keeps its own random stream from block to block.
+    std::vector<CRandomStream> randoms;
+    randoms.reserve(memberCount);
+    for (int member = 0; member < memberCount; ++member) {
+        randoms.emplace_back(seed, member);
+    }
+
+    // Values of a block of days: the value of member m on day i of the block is at [m * blockDayCount + i], so every member
+    // writes its own contiguous range.
+    int blockDayCount = std::max(1, std::min(dayCount, ENSEMBLE_BLOCK_SIZE / memberCount));
+    std::size_t valueCount = static_cast<std::size_t>(blockDayCount) * memberCount;
+    std::vector<int> temperatures(valueCount), pressures(valueCount), humidities(valueCount);
+
+    std::vector<int> members(memberCount);
+    std::iota(members.begin(), members.end(), 0);
+
+    for (int firstDay = 0; firstDay < dayCount; firstDay += blockDayCount)
+    {
+        int blockDays = std::min(blockDayCount, dayCount - firstDay);
+
+        // Run the members over the block in parallel.
+        QtConcurrent::blockingMap(members, [&](int member) {
+            CRandomStream& random = randoms[member];
+            std::size_t memberOffset = static_cast<std::size_t>(member) * blockDayCount;
+
+            for (int i = 0; i < blockDays; ++i) {
+                int day = firstDay + i;
+                CWather::weatherData wData = drawWeather(*dayClimates[day], dates[day], random);
+                temperatures[memberOffset + i] = wData.m_temperature;
+                pressures[memberOffset + i] = static_cast<int>(wData.m_pressure);
+                humidities[memberOffset + i] = wData.m_humidity;
+            }
+        });
+
+        // Reduce the members of each day of the block into percentile bands (days are reduced in parallel).
+        std::vector<int> days(blockDays);
+        std::iota(days.begin(), days.end(), 0);
+
+        QtConcurrent::blockingMap(days, [&](int i) {
+            std::vector<int> dayValues(memberCount);
+            int day = firstDay + i;
+
+            auto reduceDay = [&](const std::vector<int>& values, percentileBand& band) {
+                for (int member = 0; member < memberCount; ++member) {
+                    dayValues[member] = values[static_cast<std::size_t>(member) * blockDayCount + i];
+                }
+                std::sort(dayValues.begin(), dayValues.end());
+
+                band.m_p10[day] = getPercentile(dayValues.begin(), memberCount, 10);
+                band.m_p50[day] = getPercentile(dayValues.begin(), memberCount, 50);
+                band.m_p90[day] = getPercentile(dayValues.begin(), memberCount, 90);
+            };
+
+            reduceDay(temperatures, ensemble.m_temperature);
+            reduceDay(pressures, ensemble.m_pressure);
+            reduceDay(humidities, ensemble.m_humidity);
+        });
+    }
+
+    return ensemble;
+}
+
+
+// Draws the median of a weather parameter as a line and its p10 - p90 range as a band.
+void CForecastEngine::buildEnsembleGraph(const percentileBand& band, QDate startDate, const QString& graphTitle)
+{
+    // Check if there is enough data to build the graph.
+    if(band.m_p50.size() < 3){
+        QMessageBox::information(nullptr, "Not enough data.", "Data is required to build the graph."
+                                " Please add 3 or more rows to the table and save it.", QMessageBox::Ok);
+        return;
+    }
+
+    // Create the series of the percentiles.
+    QLineSeries* p10Series = new QLineSeries();
+    QLineSeries* p50Series = new QLineSeries();
+    QLineSeries* p90Series = new QLineSeries();
+
+    for(int i = 0; i < band.m_p50.size(); ++i){
+        p10Series->append(i, band.m_p10[i]);
+        p50Series->append(i, band.m_p50[i]);
+        p90Series->append(i, band.m_p90[i]);
+    }
+
+    // The p10 - p90 range is drawn as a band between the p10 and p90 lines.
+    QAreaSeries* rangeSeries = new QAreaSeries(p90Series, p10Series);
+    rangeSeries->setName("p10 - p90");
+    rangeSeries->setColor(QColor(100, 150, 230, 90));
+    rangeSeries->setPen(QPen(QColor(100, 150, 230)));
+
+    p50Series->setName("Median");
+
+    // Create a new chart and add the series to it.
+    QChart* chart = new QChart();
+    chart->addSeries(rangeSeries);
+    chart->addSeries(p50Series);
+    chart->setTitle(graphTitle);
+
+    // Create axis x for the dates (a label at the first day of each month).
+    QCategoryAxis *axisX = new QCategoryAxis();
+    axisX->setLabelsPosition(QCategoryAxis::AxisLabelsPositionOnValue);
+
+    for(int i = 0; i < band.m_p50.size(); ++i){
+        QDate date = startDate.addDays(i);
+        if(i == 0 || date.day() == 1){
+            axisX->append(QString::asprintf("%02d.%02d", date.month(), date.year()), i);
+        }
+    }
+
+    QValueAxis *axisY = new QValueAxis();
+
+    chart->addAxis(axisX, Qt::AlignBottom);
+    chart->addAxis(axisY, Qt::AlignLeft);
+    for (QAbstractSeries* series : {static_cast<QAbstractSeries*>(rangeSeries), static_cast<QAbstractSeries*>(p50Series)}) {
+        series->attachAxis(axisX);
+        series->attachAxis(axisY);
+    }
+
+    // Create a chart view and set rendering options.
+    QChartView *chartView = new QChartView(chart);
+    chartView->setRenderHint(QPainter::Antialiasing);
+
+    // Create a dialog to display the chart.
+    QDialog *dialog = new QDialog;
+    dialog->setMinimumSize(800, 500);
+
+    // Create a layout for the dialog and add the chart view to it.
+    QVBoxLayout *layout = new QVBoxLayout;
+    dialog->setLayout(layout);
+    layout->addWidget(chartView);
+
+    // Show the dialog.
+    dialog->exec();
+}
+
+
+// Returns the index of a day in the climatology calendar.
+int CForecastEngine::getDayOfYearIndex(Month month, unsigned day)
+{
+    // Number of days before each month in a leap year.
+    static const int daysBeforeMonth[12] = {0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335};
+
+    int intMonth = static_cast<int>(month);
+    if (intMonth < 1 || intMonth > 12 || day < 1 || static_cast<int>(day) > getNumDaysInMonth(month, 2000)) {
+        return -1;
+    }
+
+    return daysBeforeMonth[intMonth - 1] + static_cast<int>(day) - 1;
+}
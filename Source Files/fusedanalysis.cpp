@@ -0,0 +1,271 @@
+#include "../Header Files/fusedanalysis.h"
+#include <climits>
+#include <cmath>
+
+
+// Adds a day to a range (an empty range starts with the day).
+static void extendRange(CFusedAnalysis::dayRange& range, int dayNumber, const CWather::weatherData& wData)
+{
+    if (range.m_dayCount == 0) {
+        range.m_firstDay = dayNumber;
+        range.m_first = wData;
+    }
+
+    range.m_last = wData;
+    range.m_dayCount++;
+}
+
+
+// Constructor with parameters.
+CFusedAnalysis::CFusedAnalysis(int analyses, double tRangePct, double psreRangePct)
+    : analyses(analyses), tRangePct(tRangePct), psreRangePct(psreRangePct), dayCount(0), tSum(0), psreSum(0), maxHumidity(0),
+      firstDateKey(LLONG_MAX), lastDateKey(LLONG_MIN), periodTSum(0), periodPsreSum(0)
+{}
+
+
+// Registers an analysis.
+void CFusedAnalysis::addAnalysis(analysisKind analysis)
+{
+    analyses |= analysis;
+}
+
+
+// Determine if an analysis is registered.
+bool CFusedAnalysis::hasAnalysis(analysisKind analysis) const
+{
+    return (analyses & analysis) != 0;
+}
+
+
+// Runs the registered analyses over the days in one pass.
+void CFusedAnalysis::run(const WeatherView& weather)
+{
+    // Start from an empty analysis with the same analyses and ranges.
+    *this = CFusedAnalysis(analyses, tRangePct, psreRangePct);
+    this->weather = weather;
+
+    // Every day is loaded once for all the analyses.
+    int size = weather.getWeatherSize();
+    for (int i = 0; i < size; ++i) {
+        addDay(weather.at(i));
+    }
+
+    endSeries();
+
+    // The numbers of the added days are the indexes of the view.
+    for (const dayRange& range : windRunRanges) {
+        std::vector<unsigned> indexArr(range.m_dayCount);
+        for (int j = 0; j < indexArr.size(); ++j) {
+            indexArr[j] = range.m_firstDay + j;
+        }
+        windRuns.push_back(std::move(indexArr));
+    }
+
+    for (const dayRange& range : stablePeriodRanges) {
+        stablePeriods.push_back(weather.getSubView(range.m_firstDay, range.m_dayCount));
+    }
+}
+
+
+// Adds the next day to the registered analyses.
+void CFusedAnalysis::addDay(const CWather::weatherData& wData)
+{
+    int dayNumber = dayCount++;
+
+    if (hasAnalysis(AveragesAnalysis)) {
+        tSum += wData.m_temperature;
+        psreSum += wData.m_pressure;
+    }
+
+    if (hasAnalysis(HumidityAnalysis)) {
+        if (dayNumber == 0 || wData.m_humidity > maxHumidity) {
+            maxHumidity = wData.m_humidity;
+            maxHumidityIndexes.clear();
+        }
+        if (wData.m_humidity == maxHumidity) {
+            maxHumidityIndexes.push_back(dayNumber);
+        }
+    }
+
+    // Dates are compared as packed (year, month, day) numbers; a QDate is made only for a new first or last date.
+    if (hasAnalysis(DateRangeAnalysis) && wData.m_month >= 1 && wData.m_month <= 12 && wData.m_day >= 1 && wData.m_day <= 31) {
+        long long dateKey = wData.m_year * 512LL + wData.m_month * 32 + wData.m_day;
+
+        if ((dateKey < firstDateKey || dateKey > lastDateKey) && QDate(wData.m_year, wData.m_month, wData.m_day).isValid()) {
+            if (dateKey < firstDateKey) {
+                firstDateKey = dateKey;
+                firstDate = QDate(wData.m_year, wData.m_month, wData.m_day);
+            }
+            if (dateKey > lastDateKey) {
+                lastDateKey = dateKey;
+                lastDate = QDate(wData.m_year, wData.m_month, wData.m_day);
+            }
+        }
+    }
+
+    if (hasAnalysis(WindRunsAnalysis))
+    {
+        // A change of the wind direction ends the run in progress.
+        if (windRun.m_dayCount != 0 && wData.m_windDirection != windRun.m_last.m_windDirection) {
+            if (windRun.m_dayCount >= 2) {
+                windRunRanges.push_back(windRun);
+            }
+            windRun.m_dayCount = 0;
+        }
+
+        extendRange(windRun, dayNumber, wData);
+    }
+
+    if (hasAnalysis(StablePeriodsAnalysis))
+    {
+        if (stablePeriod.m_dayCount != 0)
+        {
+            double avgPressure = roundToHundredths(periodPsreSum / stablePeriod.m_dayCount);
+            double avgTemperature = roundToHundredths(periodTSum / stablePeriod.m_dayCount);
+
+            // Start a new period if the day does not fit within the percentage change criteria.
+            if (!(fabs(avgPressure - static_cast<double>(wData.m_pressure)) <= getPercentageOf(avgPressure) * psreRangePct
+                  && fabs(avgTemperature - static_cast<double>(wData.m_temperature)) <= getPercentageOf(avgTemperature) * tRangePct))
+            {
+                if (stablePeriod.m_dayCount >= 3) {
+                    stablePeriodRanges.push_back(stablePeriod);
+                }
+                stablePeriod.m_dayCount = 0;
+            }
+        }
+
+        if (stablePeriod.m_dayCount == 0) {
+            periodTSum = 0;
+            periodPsreSum = 0;
+        }
+
+        extendRange(stablePeriod, dayNumber, wData);
+        periodTSum += wData.m_temperature;
+        periodPsreSum += wData.m_pressure;
+    }
+}
+
+
+// Ends the wind run and the stable period in progress.
+void CFusedAnalysis::endSeries()
+{
+    if (windRun.m_dayCount >= 2) {
+        windRunRanges.push_back(windRun);
+    }
+    windRun.m_dayCount = 0;
+
+    if (stablePeriod.m_dayCount >= 3) {
+        stablePeriodRanges.push_back(stablePeriod);
+    }
+    stablePeriod.m_dayCount = 0;
+}
+
+
+// Used to get the number of analysed days.
+int CFusedAnalysis::getDayCount() const
+{
+    return dayCount;
+}
+
+
+// Used to get the exact sum of temperature.
+long long CFusedAnalysis::getTemperatureSum() const
+{
+    return tSum;
+}
+
+
+// Used to get the exact sum of pressure.
+long long CFusedAnalysis::getPressureSum() const
+{
+    return psreSum;
+}
+
+
+// Used to get the average temperature.
+double CFusedAnalysis::getAvgTemperature() const
+{
+    return dayCount == 0 ? 0 : roundToHundredths(static_cast<double>(tSum) / dayCount);
+}
+
+
+// Used to get the average pressure.
+double CFusedAnalysis::getAvgPressure() const
+{
+    return dayCount == 0 ? 0 : roundToHundredths(static_cast<double>(psreSum) / dayCount);
+}
+
+
+// Used to get the highest humidity.
+int CFusedAnalysis::getMaxHumidity() const
+{
+    return maxHumidity;
+}
+
+
+// Used to get the number of days the highest humidity was observed.
+int CFusedAnalysis::getMaxHumidityDayCount() const
+{
+    return maxHumidityIndexes.size();
+}
+
+
+// Used to get the dates of the days with the highest humidity.
+std::vector<QDate> CFusedAnalysis::getHighestHumidityDays() const
+{
+    std::vector<QDate> highestHumDaysArr;
+
+    // WeatherView looks for the highest humidity from 0, so it finds no days when all the humidities are negative.
+    if (maxHumidity < 0) {
+        return highestHumDaysArr;
+    }
+
+    highestHumDaysArr.reserve(maxHumidityIndexes.size());
+    for (int index : maxHumidityIndexes) {
+        highestHumDaysArr.push_back(weather.getDate(index));
+    }
+
+    return highestHumDaysArr;
+}
+
+
+// Used to get the first valid date.
+QDate CFusedAnalysis::getFirstDate() const
+{
+    return firstDate;
+}
+
+
+// Used to get the last valid date.
+QDate CFusedAnalysis::getLastDate() const
+{
+    return lastDate;
+}
+
+
+// Used to get the runs of days when the wind direction did not change.
+const std::vector<std::vector<unsigned>>& CFusedAnalysis::getWindRuns() const
+{
+    return windRuns;
+}
+
+
+// Used to get the stable periods.
+const std::vector<WeatherView>& CFusedAnalysis::getStablePeriods() const
+{
+    return stablePeriods;
+}
+
+
+// Used to get the ended wind runs.
+const std::vector<CFusedAnalysis::dayRange>& CFusedAnalysis::getWindRunRanges() const
+{
+    return windRunRanges;
+}
+
+
+// Used to get the ended stable periods.
+const std::vector<CFusedAnalysis::dayRange>& CFusedAnalysis::getStablePeriodRanges() const
+{
+    return stablePeriodRanges;
+}
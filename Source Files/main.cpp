@@ -1,9 +1,34 @@
 #include "../Header Files/mainwindow.h"
+#include "../Header Files/externalsort.h"
+#include "../Header Files/weatherserver.h"
+#include "../Header Files/forecastbacktest.h"
 
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
+    // Sorting and merging files from the command line does not open the window.
+    if (argc > 1 && QString(argv[1]) == "--sort") {
+        QCoreApplication a(argc, argv);
+        return CWeatherExternalSort::runCommandLine(a.arguments());
+    }
+
+    // The query server and its load generator run without the window too.
+    if (argc > 1 && QString(argv[1]) == "--serve") {
+        QCoreApplication a(argc, argv);
+        return CWeatherServer::runCommandLine(a.arguments());
+    }
+    if (argc > 1 && QString(argv[1]) == "--load-test") {
+        QCoreApplication a(argc, argv);
+        return CWeatherLoadGenerator::runCommandLine(a.arguments());
+    }
+
+    // So does the backtest of the monthly forecast.
+    if (argc > 1 && QString(argv[1]) == "--backtest") {
+        QCoreApplication a(argc, argv);
+        return CForecastBacktest::runCommandLine(a.arguments());
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
@@ -1,5 +1,18 @@
 #include "../Header Files/mainwindow.h"
 #include "./ui_mainwindow.h"
+#include "../Header Files/forecastengine.h"
+#include "../Header Files/rollingstatistics.h"
+#include "../Header Files/rollups.h"
+#include "../Header Files/weatherjoin.h"
+#include "../Header Files/weathergaps.h"
+#include "../Header Files/windstatistics.h"
+#include "../Header Files/weatherstream.h"
+#include "../Header Files/externalsort.h"
+#include "../Header Files/derivedcolumns.h"
+#include "../Header Files/forecastbacktest.h"
+#include "../Header Files/analogindex.h"
+#include "../Header Files/eventdetector.h"
+#include <QTemporaryDir>
 
 
 // Constructor.
@@ -19,16 +32,53 @@ MainWindow::MainWindow(QWidget *parent)
 
     // Connect the customContextMenuRequested signal to the createTableContextMenu slot.
     connect(ui->weatherTable, &QTableWidget::customContextMenuRequested, this, &MainWindow::createTableContextMenu);
+
+    // Replace the file with the compacted one when the background compaction of the journal is finished.
+    connect(&compactionWatcher, &QFutureWatcher<CWeatherJournal::compactionResult>::finished, this, &MainWindow::finishJournalCompaction);
+
+    // The progress of the background save is shown at the right of the status bar (the status message is left as it is).
+    saveProgressBar = new QProgressBar(this);
+    saveProgressBar->setRange(0, 100);
+    saveProgressBar->setFormat("Saving %p%");
+    saveProgressBar->setMaximumWidth(200);
+    saveProgressBar->hide();
+    statusBar()->addPermanentWidget(saveProgressBar);
+
+    connect(&saveWatcher, &QFutureWatcher<QString>::progressValueChanged, saveProgressBar, &QProgressBar::setValue);
+    connect(&saveWatcher, &QFutureWatcher<QString>::finished, this, &MainWindow::finishBackgroundSave);
+
+    // Read the days appended to the followed file as soon as it changes.
+    connect(&fileWatcher, &QFileSystemWatcher::fileChanged, this, &MainWindow::readFollowedFile);
 }
 
 
 // Default destructor
 MainWindow::~MainWindow()
 {
+    // The results were reported when the window was closed; here the background writes are only waited for.
+    saveWatcher.waitForFinished();
+    compactionWatcher.waitForFinished();
+    cacheWrite.waitForFinished();
     delete ui;
 }
 
 
+// Closes the window only when the background save has finished (its errors are reported while the window is still alive).
+void MainWindow::closeEvent(QCloseEvent* event)
+{
+    if(isSaveRunning)
+    {
+        isCloseRequested = true;
+        statusBar()->showMessage("The window will be closed when the file is saved...");
+        event->ignore();
+        return;
+    }
+
+    finishJournalCompaction();
+    event->accept();
+}
+
+
 // Display a warning message to the user.
 bool MainWindow::showWarningMessage(const QString& warningMessage)
 {
@@ -97,6 +147,8 @@ void MainWindow::createTableContextMenu(const QPoint& pos)
     QAction* setHumidity = tableContextMenu->addAction("Set humidity");
     QAction* setWindDirection = tableContextMenu->addAction("Set wind direction");
     QAction* removeRow = tableContextMenu->addAction("Delete row");
+    tableContextMenu->addSeparator();
+    QAction* findSimilarDays = tableContextMenu->addAction("Find similar days");
 
     // Connect each action to its corresponding slot function.
     connect(setDate, &QAction::triggered, this, [this, rowIndex](){
@@ -123,6 +175,10 @@ void MainWindow::createTableContextMenu(const QPoint& pos)
         deleteRow(rowIndex);
     });
 
+    connect(findSimilarDays, &QAction::triggered, this, [this, rowIndex](){
+        findAnalogDays(rowIndex);
+    });
+
     // Display the context menu at the given position.
     tableContextMenu->exec(ui->weatherTable->viewport()->mapToGlobal(pos));
 }
@@ -348,11 +404,86 @@ void MainWindow::deleteRow(int rowIndex)
 }
 
 
+// Shows the days of the weather history most similar to the day of a row (its analog days).
+void MainWindow::findAnalogDays(int rowIndex)
+{
+    // The index is built from the saved weather data, so the rows must match it.
+    if(statusBar()->currentMessage() == "Not all changes are saved )=")
+    {
+        showErrorMessage("Save the changes before searching for similar days.");
+        return;
+    }
+
+    if(rowIndex < 0 || rowIndex >= mainWeather.getWeatherSize())
+    {
+        showErrorMessage("Error. Click on the row of the day to find similar days for.");
+        return;
+    }
+
+    // Create a dialog for choosing the number of days and whether only the same season is searched.
+    QDialog* dialog = createDialog("Similar days", 260, 150);
+    QSpinBox* countSpinBox = new QSpinBox(dialog);
+    countSpinBox->setRange(1, 1000);
+    countSpinBox->setValue(10);
+    countSpinBox->setSuffix(" days");
+    QCheckBox* sameSeasonCheckBox = new QCheckBox("Only days of the same season", dialog);
+    QPushButton* findButton = new QPushButton("Find", dialog);
+
+    // Set up the layout of the dialog.
+    QVBoxLayout* layout = new QVBoxLayout(dialog);
+    layout->addWidget(countSpinBox);
+    layout->addWidget(sameSeasonCheckBox);
+    layout->addWidget(findButton);
+
+    connect(findButton, &QPushButton::clicked, dialog, &QDialog::accept);
+
+    if(dialog->exec() != QDialog::Accepted){
+        return;
+    }
+
+    int count = countSpinBox->value();
+    bool isSameSeason = sameSeasonCheckBox->isChecked();
+
+    // Search the index (built on the first search and kept until the weather data changes).
+    std::vector<CAnalogIndex::analogDay> analogDays = mainWeather.getAnalogIndex()->findNearest(
+        mainWeather.getView().at(rowIndex), count, isSameSeason, rowIndex);
+
+    if(analogDays.empty())
+    {
+        showOutputDataMessage("No similar days were found.");
+        return;
+    }
+
+    // Show the days, the most similar first, with their distance from the chosen day.
+    std::vector<int> indexes;
+    for(const CAnalogIndex::analogDay& analogDay : analogDays){
+        indexes.push_back(analogDay.m_index);
+    }
+
+    QDialog resultDialog;
+    resultDialog.setWindowTitle("Days most similar to row " + QString::number(rowIndex + 1));
+    resultDialog.setFixedSize(860, 400);
+
+    QTableWidget* analogTable = createWeatherTable(WeatherView(mainWeather, indexes));
+    analogTable->setColumnCount(8);
+    analogTable->setHorizontalHeaderItem(7, new QTableWidgetItem("Distance"));
+
+    for(int i = 0; i < analogDays.size(); ++i){
+        analogTable->setItem(i, 7, new QTableWidgetItem(QString::number(analogDays[i].m_distance, 'f', 3)));
+    }
+
+    QVBoxLayout resultLayout(&resultDialog);
+    resultLayout.addWidget(analogTable);
+
+    resultDialog.exec();
+}
+
+
 // From the available weather information, it determines the weather for a certain period selected by the user.
-CWather MainWindow::getWeatherPeriod(bool& isSuccess)
+WeatherView MainWindow::getWeatherPeriod(bool& isSuccess)
 {
-    // Initialize the CWather object to store the chosen weather period.
-    CWather choosedPeriod;
+    // Initialize the view of the chosen weather period.
+    WeatherView choosedPeriod;
 
     // Create a dialog for choosing the date period.
     QDialog* dialog = createDialog("Choose date", 250, 200);
@@ -394,7 +525,7 @@ CWather MainWindow::getWeatherPeriod(bool& isSuccess)
         }
 
         // Get the weather data for the chosen period.
-        choosedPeriod = mainWeather.getWeatherByPeriod(selectedStartDate, selectedEndDate);
+        choosedPeriod = mainWeather.getViewByPeriod(selectedStartDate, selectedEndDate);
 
         // Check if there is no information available for the chosen period and handle the error.
         try {
@@ -432,6 +563,7 @@ void MainWindow::on_actionSort_by_pressure_within_seasons_triggered()
     mainWeather.sortPressureBySeason();
     mainWeather.completeTable(ui->weatherTable);
     statusBar()->showMessage("All changes have been saved (=");
+    applyTableFilter();
 }
 
 
@@ -463,10 +595,11 @@ void MainWindow::on_actionSave_changes_triggered()
             return;
         }
 
-        // Update the main weather object with the new data.
-        mainWeather = newWeather;
+        // Update the main weather object with the new data (the data is moved, not copied).
+        mainWeather = std::move(newWeather);
 
         statusBar()->showMessage("All changes have been saved (=");
+        applyTableFilter();
     }
 }
 
@@ -482,19 +615,92 @@ void MainWindow::on_actionOpen_triggered()
     // Prompt the user to select a text file.
     QString fileName = QFileDialog::getOpenFileName(this, "Select a file", "/Users/artomrevus/Desktop", "Text file (*.txt)");
 
+    openDatasetFile(fileName);
+}
+
+
+// Reads the dataset from a text file and shows its first station in the main weather table.
+void MainWindow::openDatasetFile(const QString& fileName, bool isTemporaryFile)
+{
+    finishBackgroundSave();
+    finishJournalCompaction();
+    stopFollowingFile();
+    openedFileName.clear();
+
+    // A file with a journal is read together with the changes saved to the journal.
+    if(CWeatherJournal::hasJournal(fileName))
+    {
+        CWeatherJournal fileJournal(fileName);
+
+        try {
+            dataset = fileJournal.open();
+        } catch (const QString& exception) {
+            showErrorMessage(exception);
+            return;
+        }
+
+        journal = fileJournal;
+        updateStationComboBox();
+        showStation(0);
+        return;
+    }
+
+    journal = CWeatherJournal();
+
+    // A file with the same content as one opened before is read from the cache (with the data derived from it).
+    // A temporary file is neither cached nor followed, as it is deleted after it is read.
+    CWeatherCache cache;
+    if (!isTemporaryFile)
+    {
+        try {
+            cache = CWeatherCache(fileName);
+        } catch (const QString& exception) {
+            showErrorMessage(exception);
+            return;
+        }
+
+        if (cache.load(dataset))
+        {
+            openedFileName = fileName;
+            openedFileSize = cache.getFileSize();
+            openedFileStation = dataset.getStation(dataset.getStationCount() - 1).m_id;
+
+            updateStationComboBox();
+            showStation(0);
+            return;
+        }
+    }
+
     QFile file(fileName);
     if (file.open(QIODevice::ReadOnly | QIODevice::Text))
     {
         // Read the file using QTextStream.
         QTextStream in(&file);
 
-        ui->weatherTable->setRowCount(0);
+        // Read the weather data of all stations from the file into the dataset.
+        try {
+            in >> dataset;
+        } catch (const QString& exception) {
+            showErrorMessage(exception);
+            file.close();
+            return;
+        }
+
+        // The file can be followed from the end of the read part.
+        if (!isTemporaryFile)
+        {
+            openedFileName = fileName;
+            openedFileSize = file.pos();
+            openedFileStation = dataset.getStation(dataset.getStationCount() - 1).m_id;
 
-        // Read weather data from the file into the mainWeather object.
-        in >> mainWeather;
-        mainWeather.completeTable(ui->weatherTable);
+            // The cache is written only if the file did not change between hashing and reading it.
+            if (openedFileSize == cache.getFileSize()) {
+                cacheWrite = cache.saveInBackground(dataset);
+            }
+        }
 
-        statusBar()->showMessage("All changes have been saved (=");
+        updateStationComboBox();
+        showStation(0);
         file.close();
     }
     else
@@ -517,17 +723,55 @@ void MainWindow::on_actionSave_triggered()
     // Prompt the user to select a file for saving.
     QString fileName = QFileDialog::getOpenFileName(this, "Select a file", "/Users/artomrevus/Desktop", "Text file (*.txt)");
 
-    QFile file(fileName);
-    if (file.open(QIODevice::WriteOnly | QIODevice::Text))
-    {
-        // Write weather data to the file using QTextStream.
-        QTextStream out(&file);
-        out << mainWeather;
-        file.close();
+    // The whole file is rewritten, so its journal no longer applies (it is ignored the next time the file is opened).
+    if(journal.isActive() && fileName == journal.getFileName()){
+        finishJournalCompaction();
+        journal = CWeatherJournal();
     }
-    else
-    {
-        showErrorMessage("The data has not been recorded!");
+
+    if(fileName.isEmpty()){
+        return;
+    }
+
+    // The followed file is replaced by a new one, which cannot be continued from the read part of the old one.
+    if(fileName == openedFileName){
+        stopFollowingFile();
+        openedFileName.clear();
+    }
+
+    // Only one save runs at a time.
+    finishBackgroundSave();
+
+    // Write the weather data of all stations in the background; the table can be edited in the meantime.
+    storeCurrentStation();
+
+    saveProgressBar->setValue(0);
+    saveProgressBar->show();
+    isSaveRunning = true;
+    saveWatcher.setFuture(dataset.writeFileInBackground(fileName));
+}
+
+
+// Waits for the background save (if one is running) and reports its error.
+void MainWindow::finishBackgroundSave()
+{
+    if(!isSaveRunning){
+        return;
+    }
+
+    saveWatcher.waitForFinished();
+    isSaveRunning = false;
+    saveProgressBar->hide();
+
+    QString error = saveWatcher.result();
+    if(!error.isEmpty()){
+        showErrorMessage(error);
+        isCloseRequested = false;
+    }
+
+    // A window closed during the save is closed now (unless the save failed, so the data can be saved elsewhere).
+    if(isCloseRequested){
+        QTimer::singleShot(0, this, &MainWindow::close);
     }
 }
 
@@ -571,7 +815,7 @@ void MainWindow::on_actionBuild_graph_of_t_2_triggered()
 
     mainWeather.buildWeatherGraph([this](int i){
         return mainWeather.getTemperature(i);
-    }, "Temperature graph");
+    }, "Temperature graph", getGraphOverlays(TemperatureColumn));
 }
 
 
@@ -585,7 +829,7 @@ void MainWindow::on_actionBuild_graph_of_pressure_2_triggered()
 
     mainWeather.buildWeatherGraph([this](int i){
         return mainWeather.getPressure(i);
-    }, "Pressure graph");
+    }, "Pressure graph", getGraphOverlays(PressureColumn));
 }
 
 
@@ -599,7 +843,7 @@ void MainWindow::on_actionBuild_graph_of_humidity_2_triggered()
 
     mainWeather.buildWeatherGraph([this](int i){
         return mainWeather.getHumidity(i);
-    }, "Humidity graph");
+    }, "Humidity graph", getGraphOverlays(HumidityColumn));
 }
 
 
@@ -618,7 +862,7 @@ void MainWindow::on_actionFind_days_while_triggered()
     }
 
     // Find days when the wind direction did not change.
-    std::vector<std::vector<unsigned>> windNotChangeArr = mainWeather.findDaysWindNotChange();
+    std::vector<std::vector<unsigned>> windNotChangeArr = mainWeather.findDaysWindNotChange(analysisContinuity);
 
     // Highlight the corresponding rows in the weather table with random background colors.
     for (int i = 0; i < windNotChangeArr.size(); ++i) {
@@ -646,7 +890,7 @@ void MainWindow::on_actionDetermine_the_avg_temperature_triggered()
 
     // Get weather data for a specified period.
     bool isSuccess;
-    CWather findAvgTArr = getWeatherPeriod(isSuccess);
+    WeatherView findAvgTArr = getWeatherPeriod(isSuccess);
 
     if(isSuccess)
     {
@@ -668,7 +912,7 @@ void MainWindow::on_actionDetermine_highest_humidity_days_triggered()
 
     // Get weather data for a specified period.
     bool isSuccess;
-    CWather findHighestHumArr = getWeatherPeriod(isSuccess);
+    WeatherView findHighestHumArr = getWeatherPeriod(isSuccess);
 
     if(isSuccess)
     {
@@ -686,44 +930,45 @@ void MainWindow::on_actionDetermine_highest_humidity_days_triggered()
 }
 
 
-// For each period (passed as a method parameter), it creates a weather table and displays its data.
-void MainWindow::displayWeatherPeriods(std::vector<CWather> periodsArr)
+// Displays the periods (passed as a method parameter) in a dialog with a tab for each period.
+void MainWindow::displayWeatherPeriods(const std::vector<WeatherView>& periodsArr)
 {
     // Create a dialog to display the weather data.
     QDialog dialog;
     dialog.setWindowTitle("Periods (3 and more days) when the pressure varied within ±2.5% and t ±3.6%.");
     dialog.setFixedSize(760, 400);
 
-    QScrollArea scrollArea;
-
-    // Create a tab widget to hold tables for each period.
-    QTabWidget tabWidget;
-    tabWidget.setMinimumWidth(720);
-    tabWidget.setFixedHeight(350);
+    // Create a tab bar with a tab for each period (tabs are not widgets, so each one is a small object).
+    QTabBar tabBar;
+    tabBar.setElideMode(Qt::ElideNone);
+    tabBar.setUsesScrollButtons(true);
+    tabBar.setExpanding(false);
 
-    // Iterate through each period and create a table for each one.
     for (int i = 0; i < periodsArr.size(); ++i) {
-        QTableWidget* periodtable = createWeatherTable(periodsArr[i]);
-        tabWidget.addTab(periodtable, "Period " + QString::number(i + 1));
+        tabBar.addTab("Period " + QString::number(i + 1));
     }
 
-    // Set the tab bar properties.
-    QTabBar* tabBar = tabWidget.findChild<QTabBar*>();
-    tabBar->setElideMode(Qt::ElideNone);
-    tabBar->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Maximum);
+    // Create one table shared by all tabs, filled with the first period.
+    QTableWidget* periodTable = createWeatherTable(periodsArr.empty() ? WeatherView() : periodsArr.front());
 
-    scrollArea.setWidget(&tabWidget);
+    // Fill the table with the period of a tab only when this tab is shown.
+    connect(&tabBar, &QTabBar::currentChanged, &dialog, [&periodsArr, periodTable](int index){
+        if (index >= 0 && index < periodsArr.size()) {
+            periodsArr[index].completeTable(periodTable);
+        }
+    });
 
     // Set up the layout for the dialog.
     QVBoxLayout layout(&dialog);
-    layout.addWidget(&scrollArea);
+    layout.addWidget(&tabBar);
+    layout.addWidget(periodTable);
 
     dialog.exec();
 }
 
 
 // This method is used to create and configure a QTableWidget (table).
-QTableWidget* MainWindow::createWeatherTable(CWather weather)
+QTableWidget* MainWindow::createWeatherTable(const WeatherView& weather)
 {
     QTableWidget* weatherTable = new QTableWidget();
     weatherTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
@@ -741,6 +986,78 @@ QTableWidget* MainWindow::createWeatherTable(CWather weather)
 }
 
 
+// Builds the overlays drawn over a weather graph (moving averages, if they are switched on in the Graphs menu).
+std::vector<graphOverlay> MainWindow::getGraphOverlays(WeatherColumn column) const
+{
+    if(!ui->actionShow_moving_averages->isChecked()){
+        return {};
+    }
+
+    return CRollingStatistics(mainWeather, column, {7, 30, 365}).getMovingAverageOverlays();
+}
+
+
+// Writes the main weather object back into the dataset as the data of the station shown in the table.
+void MainWindow::storeCurrentStation()
+{
+    dataset.setStationWeather(currentStation, mainWeather);
+}
+
+
+// Shows a station of the dataset in the main weather table.
+void MainWindow::showStation(int stationIndex)
+{
+    currentStation = stationIndex;
+    mainWeather = dataset.getStation(stationIndex).m_weather;
+
+    ui->weatherTable->setRowCount(0);
+    mainWeather.completeTable(ui->weatherTable);
+
+    statusBar()->showMessage("All changes have been saved (=");
+    applyTableFilter();
+}
+
+
+// Fills the station selector with the stations of the dataset (it is shown only when there are several stations).
+void MainWindow::updateStationComboBox()
+{
+    // Changing the items must not switch stations.
+    QSignalBlocker blocker(ui->stationComboBox);
+
+    ui->stationComboBox->clear();
+    for(int i = 0; i < dataset.getStationCount(); ++i){
+        QString stationId = dataset.getStation(i).m_id;
+        ui->stationComboBox->addItem(stationId.isEmpty() ? "(unnamed station)" : stationId);
+    }
+
+    ui->stationComboBox->setCurrentIndex(currentStation < dataset.getStationCount() ? currentStation : 0);
+    ui->stationComboBox->setVisible(dataset.getStationCount() > 1);
+}
+
+
+// Hides the rows of the main weather table that do not match the active filter (shows all rows if there is no filter).
+void MainWindow::applyTableFilter()
+{
+    int rowCount = ui->weatherTable->rowCount();
+
+    if(!tableFilter){
+        for(int i = 0; i < rowCount; ++i){
+            ui->weatherTable->setRowHidden(i, false);
+        }
+        return;
+    }
+
+    // The filter runs over the main weather object, whose days are the rows of the saved table.
+    CSelectionBitmap selection = tableFilter->evaluate(mainWeather);
+
+    for(int i = 0; i < rowCount; ++i){
+        ui->weatherTable->setRowHidden(i, i >= selection.getSize() || !selection.isSelected(i));
+    }
+
+    statusBar()->showMessage(QString("Filter: %1 of %2 days").arg(selection.getSelectedCount()).arg(selection.getSize()));
+}
+
+
 // Find the periods in which the pressure varied within ±2.5% and t - 3.6% and display them in the form of tables.
 void MainWindow::on_actionFind_days_while_pressure_2_5_triggered()
 {
@@ -752,7 +1069,8 @@ void MainWindow::on_actionFind_days_while_pressure_2_5_triggered()
     }
 
     // Find periods when pressure and temperature vary within specified ranges.
-    std::vector<CWather> periodsArr = mainWeather.findPeriodTemperatureAndPressureChangeWithinRange(3.6, 2.5);
+    std::vector<WeatherView> periodsArr = mainWeather.findPeriodTemperatureAndPressureChangeWithinRange(
+        CWather::STABLE_T_RANGE_PCT, CWather::STABLE_PSRE_RANGE_PCT, analysisContinuity);
 
     // Display a message if no periods are found.
     if(periodsArr.size() == 0){
@@ -777,4 +1095,1183 @@ void MainWindow::on_actionForecast_weathe_for_next_month_triggered()
 
     showOutputDataMessage("The weather for the next month has been successfully predicted and added to the table.");
     statusBar()->showMessage("All changes have been saved (=");
+    applyTableFilter();
+}
+
+
+// Run an ensemble forecast for a number of days chosen by the user and plot its p10/p50/p90 bands.
+void MainWindow::on_actionForecast_ensemble_triggered()
+{
+    QString warningMessage = "You did not save all the changes you made. Do you want to continue forecasting weather?";
+    if(statusBar()->currentMessage() == "Not all changes are saved )=" && !showWarningMessage(warningMessage)){
+        return;
+    }
+
+    if(mainWeather.getWeatherSize() == 0){
+        showErrorMessage("We have no weather data to forecast from. Try adding data and refreshing the table.");
+        return;
+    }
+
+    // Create a dialog for choosing the ensemble parameters.
+    QDialog* ensembleDialog = createDialog("Ensemble forecast", 260, 200);
+
+    QSpinBox* daysSpinBox = new QSpinBox(ensembleDialog);
+    daysSpinBox->setRange(3, 3660);
+    daysSpinBox->setValue(365);
+    daysSpinBox->setSuffix(" days");
+
+    QSpinBox* membersSpinBox = new QSpinBox(ensembleDialog);
+    membersSpinBox->setRange(1, 100000);
+    membersSpinBox->setValue(1000);
+    membersSpinBox->setSuffix(" members");
+
+    QComboBox* parameterComboBox = new QComboBox(ensembleDialog);
+    parameterComboBox->addItem("Temperature");
+    parameterComboBox->addItem("Pressure");
+    parameterComboBox->addItem("Humidity");
+
+    QPushButton* forecastButton = new QPushButton("Forecast", ensembleDialog);
+
+    // Set up the layout of the dialog.
+    QVBoxLayout* layout = new QVBoxLayout(ensembleDialog);
+    layout->addWidget(daysSpinBox);
+    layout->addWidget(membersSpinBox);
+    layout->addWidget(parameterComboBox);
+    layout->addWidget(forecastButton);
+
+    connect(forecastButton, &QPushButton::clicked, ensembleDialog, &QDialog::accept);
+
+    if(ensembleDialog->exec() != QDialog::Accepted){
+        return;
+    }
+
+    if(static_cast<long long>(daysSpinBox->value()) * membersSpinBox->value() > CForecastEngine::MAX_ENSEMBLE_SIZE){
+        showErrorMessage("The ensemble is too large: the number of days times the number of members cannot exceed "
+                         + QString::number(CForecastEngine::MAX_ENSEMBLE_SIZE) + ".");
+        return;
+    }
+
+    // Forecast from the day after the last day of the table.
+    QDate startDate = mainWeather.getDate(mainWeather.getWeatherSize() - 1).addDays(1);
+    CForecastEngine::ensembleForecast ensemble = mainWeather.getForecastEngine()->forecastEnsemble(
+        startDate, daysSpinBox->value(), membersSpinBox->value(), QRandomGenerator::global()->generate64());
+
+    // Plot the bands of the chosen weather parameter.
+    QString graphTitle = QString("%1 ensemble forecast (%2 members, p10 - p90)").arg(parameterComboBox->currentText()).arg(ensemble.m_memberCount);
+
+    switch (parameterComboBox->currentIndex()) {
+    case 0:
+        CForecastEngine::buildEnsembleGraph(ensemble.m_temperature, ensemble.m_startDate, graphTitle);
+        break;
+    case 1:
+        CForecastEngine::buildEnsembleGraph(ensemble.m_pressure, ensemble.m_startDate, graphTitle);
+        break;
+    default:
+        CForecastEngine::buildEnsembleGraph(ensemble.m_humidity, ensemble.m_startDate, graphTitle);
+        break;
+    }
+}
+
+
+// Compute the 7/30/365-day rolling statistics of a weather parameter chosen by the user and show the latest values.
+void MainWindow::on_actionRolling_statistics_triggered()
+{
+    QString warningMessage = "You did not save all the changes you made. Do you want to continue computing rolling statistics?";
+    if(statusBar()->currentMessage() == "Not all changes are saved )=" && !showWarningMessage(warningMessage)){
+        return;
+    }
+
+    // Ask the user for the weather parameter.
+    QStringList parameters;
+    parameters << "Temperature" << "Pressure" << "Humidity";
+
+    bool isOk;
+    QString parameter = QInputDialog::getItem(this, "Rolling statistics", "Weather parameter:", parameters, 0, false, &isOk);
+    if(!isOk){
+        return;
+    }
+
+    WeatherColumn column = static_cast<WeatherColumn>(parameters.indexOf(parameter) + 1);
+
+    // Compute all windows in one pass and report the window that ends on the last day of the table.
+    CRollingStatistics statistics(mainWeather, column, {7, 30, 365});
+    QString output = parameter + " (windows ending on the last day of the table):";
+
+    for(int i = 0; i < statistics.getWindowCount(); ++i)
+    {
+        const CRollingStatistics::rollingWindow& window = statistics.getWindow(i);
+        output += "\n" + QString::number(window.m_windowSize) + " days: ";
+
+        if(window.m_mean.empty()){
+            output += "not enough data";
+            continue;
+        }
+
+        output += QString("avg = %1, std dev = %2, min = %3, max = %4")
+                      .arg(window.m_mean.back(), 0, 'f', 2)
+                      .arg(window.m_stdDev.back(), 0, 'f', 2)
+                      .arg(window.m_min.back())
+                      .arg(window.m_max.back());
+    }
+
+    showOutputDataMessage(output);
+}
+
+
+// Show the weekly, monthly, seasonal or yearly summary (days, mean, min, max) of a weather parameter chosen by the user.
+void MainWindow::on_actionRollup_summary_triggered()
+{
+    QString warningMessage = "You did not save all the changes you made. Do you want to continue building the summary?";
+    if(statusBar()->currentMessage() == "Not all changes are saved )=" && !showWarningMessage(warningMessage)){
+        return;
+    }
+
+    // The summary is read from the rollups, so its size depends on the number of periods, not days.
+    std::shared_ptr<const CWeatherRollups> rollups = mainWeather.getRollups();
+
+    QDialog dialog;
+    dialog.setWindowTitle("Weather summary");
+    dialog.setMinimumSize(760, 400);
+
+    QComboBox* periodComboBox = new QComboBox(&dialog);
+    periodComboBox->addItem("Weeks");
+    periodComboBox->addItem("Months");
+    periodComboBox->addItem("Seasons");
+    periodComboBox->addItem("Years");
+    periodComboBox->setCurrentIndex(MonthRollup);
+
+    QComboBox* parameterComboBox = new QComboBox(&dialog);
+    parameterComboBox->addItem("Temperature");
+    parameterComboBox->addItem("Pressure");
+    parameterComboBox->addItem("Humidity");
+
+    QTableWidget* summaryTable = new QTableWidget(&dialog);
+    summaryTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    summaryTable->setColumnCount(8);
+    QStringList columnNames;
+    columnNames << "Period" << "Days" << "Avg" << "Min" << "Max" << "p5" << "Median" << "p95";
+    summaryTable->setHorizontalHeaderLabels(columnNames);
+
+    // Refill the table with the buckets of the chosen period and parameter.
+    auto fillSummaryTable = [rollups, periodComboBox, parameterComboBox, summaryTable](){
+        RollupPeriod period = static_cast<RollupPeriod>(periodComboBox->currentIndex());
+        WeatherColumn column = static_cast<WeatherColumn>(parameterComboBox->currentIndex() + 1);
+        const std::vector<CWeatherRollups::rollupBucket>& buckets = rollups->getBuckets(period);
+
+        summaryTable->setRowCount(buckets.size());
+
+        for(int i = 0; i < buckets.size(); ++i){
+            const CWeatherRollups::rollupBucket& bucket = buckets[i];
+            summaryTable->setItem(i, 0, new QTableWidgetItem(CWeatherRollups::getBucketLabel(period, bucket)));
+            summaryTable->setItem(i, 1, new QTableWidgetItem(QString::number(bucket.m_count)));
+            summaryTable->setItem(i, 2, new QTableWidgetItem(QString::number(bucket.getMean(column), 'f', 2)));
+            summaryTable->setItem(i, 3, new QTableWidgetItem(QString::number(bucket.getColumn(column).m_min)));
+            summaryTable->setItem(i, 4, new QTableWidgetItem(QString::number(bucket.getColumn(column).m_max)));
+
+            // Percentiles come from the monthly histograms, so they are not available for weeks.
+            CValueHistogram histogram = rollups->getBucketHistogram(period, bucket, column);
+            summaryTable->setItem(i, 5, new QTableWidgetItem(histogram.getCount() == 0 ? "-" : QString::number(histogram.getPercentile(5))));
+            summaryTable->setItem(i, 6, new QTableWidgetItem(histogram.getCount() == 0 ? "-" : QString::number(histogram.getPercentile(50))));
+            summaryTable->setItem(i, 7, new QTableWidgetItem(histogram.getCount() == 0 ? "-" : QString::number(histogram.getPercentile(95))));
+        }
+    };
+
+    connect(periodComboBox, &QComboBox::currentIndexChanged, &dialog, fillSummaryTable);
+    connect(parameterComboBox, &QComboBox::currentIndexChanged, &dialog, fillSummaryTable);
+    fillSummaryTable();
+
+    // Set up the layout of the dialog.
+    QHBoxLayout* choiceLayout = new QHBoxLayout;
+    choiceLayout->addWidget(periodComboBox);
+    choiceLayout->addWidget(parameterComboBox);
+
+    QVBoxLayout layout(&dialog);
+    layout.addLayout(choiceLayout);
+    layout.addWidget(summaryTable);
+
+    dialog.exec();
+}
+
+
+// Compiles the expression from the filter bar and shows only the days of the main weather table that match it.
+void MainWindow::on_applyFilterButton_clicked()
+{
+    QString expression = ui->filterLineEdit->text().trimmed();
+
+    try {
+        // Check if all changes are saved.
+        if(statusBar()->currentMessage() == "Not all changes are saved )=")
+        {
+            throw QString("Save your table before filtering it.");
+        }
+
+        tableFilter = expression.isEmpty() ? nullptr : std::make_shared<const CWeatherQuery>(expression);
+    } catch (const QString& exception) {
+        showErrorMessage(exception);
+        return;
+    }
+
+    applyTableFilter();
+}
+
+
+// Same as the Filter button (Enter pressed in the filter bar).
+void MainWindow::on_filterLineEdit_returnPressed()
+{
+    on_applyFilterButton_clicked();
+}
+
+
+// Removes the filter and shows all days of the main weather table.
+void MainWindow::on_clearFilterButton_clicked()
+{
+    ui->filterLineEdit->clear();
+    tableFilter = nullptr;
+    applyTableFilter();
+}
+
+
+// Shows the station chosen in the station selector in the main weather table.
+void MainWindow::on_stationComboBox_currentIndexChanged(int index)
+{
+    if(index < 0 || index == currentStation){
+        return;
+    }
+
+    QString warningMessage = "You did not save all the changes you made. They will be lost if you switch to another station. "
+                             "Do you want to continue?";
+    if(statusBar()->currentMessage() == "Not all changes are saved )=" && !showWarningMessage(warningMessage)){
+        QSignalBlocker blocker(ui->stationComboBox);
+        ui->stationComboBox->setCurrentIndex(currentStation);
+        return;
+    }
+
+    storeCurrentStation();
+    showStation(index);
+}
+
+
+// Adds a new station without data to the dataset and shows it in the main weather table.
+void MainWindow::on_actionAdd_station_triggered()
+{
+    QString warningMessage = "You did not save all the changes you made. They will be lost if you switch to another station. "
+                             "Do you want to continue?";
+    if(statusBar()->currentMessage() == "Not all changes are saved )=" && !showWarningMessage(warningMessage)){
+        return;
+    }
+
+    bool isOk;
+    QString stationId = QInputDialog::getText(this, "Add station", "Station identifier:", QLineEdit::Normal, QString(), &isOk);
+    if(!isOk){
+        return;
+    }
+
+    int stationIndex;
+    try {
+        stationIndex = dataset.addStation(stationId);
+    } catch (const QString& exception) {
+        showErrorMessage(exception);
+        return;
+    }
+
+    storeCurrentStation();
+    currentStation = stationIndex;
+    updateStationComboBox();
+    showStation(stationIndex);
+}
+
+
+// Run the analyses of every station in parallel and show the per-station and network summaries.
+void MainWindow::on_actionNetwork_summary_triggered()
+{
+    QString warningMessage = "You did not save all the changes you made. Do you want to continue building the network summary?";
+    if(statusBar()->currentMessage() == "Not all changes are saved )=" && !showWarningMessage(warningMessage)){
+        return;
+    }
+
+    // Run the per-station analyses in parallel and merge them into the network summary.
+    storeCurrentStation();
+    std::vector<CWeatherDataset::stationSummary> summaries = dataset.getStationSummaries();
+    summaries.push_back(CWeatherDataset::mergeSummaries(summaries, "All stations"));
+
+    // Create a table with a row for each station and the network row at the end.
+    QDialog dialog;
+    dialog.setWindowTitle("Network summary");
+    dialog.setMinimumSize(900, 300);
+
+    QTableWidget* summaryTable = new QTableWidget(&dialog);
+    summaryTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    summaryTable->setColumnCount(9);
+    QStringList columnNames;
+    columnNames << "Station" << "Days" << "From" << "To" << "Avg t" << "Avg pressure" << "Max humidity"
+                << "Wind did not change" << "Stable periods";
+    summaryTable->setHorizontalHeaderLabels(columnNames);
+    summaryTable->setRowCount(summaries.size());
+
+    for(int i = 0; i < summaries.size(); ++i){
+        const CWeatherDataset::stationSummary& summary = summaries[i];
+        summaryTable->setItem(i, 0, new QTableWidgetItem(summary.m_stationId.isEmpty() ? "(unnamed station)" : summary.m_stationId));
+        summaryTable->setItem(i, 1, new QTableWidgetItem(QString::number(summary.m_dayCount)));
+        summaryTable->setItem(i, 2, new QTableWidgetItem(summary.m_firstDate.toString("dd.MM.yyyy")));
+        summaryTable->setItem(i, 3, new QTableWidgetItem(summary.m_lastDate.toString("dd.MM.yyyy")));
+        summaryTable->setItem(i, 4, new QTableWidgetItem(QString::number(summary.getAvgTemperature())));
+        summaryTable->setItem(i, 5, new QTableWidgetItem(QString::number(summary.getAvgPressure())));
+        summaryTable->setItem(i, 6, new QTableWidgetItem(QString("%1% (%2 days)").arg(summary.m_maxHumidity).arg(summary.m_maxHumidityDayCount)));
+        summaryTable->setItem(i, 7, new QTableWidgetItem(QString::number(summary.m_windNotChangePeriodCount)));
+        summaryTable->setItem(i, 8, new QTableWidgetItem(QString::number(summary.m_stablePeriodCount)));
+    }
+
+    QVBoxLayout layout(&dialog);
+    layout.addWidget(summaryTable);
+
+    dialog.exec();
+}
+
+
+// Plot a weather parameter of several stations aligned by date (every station, their mean or a difference of two).
+void MainWindow::on_actionCompare_stations_triggered()
+{
+    QString warningMessage = "You did not save all the changes you made. Do you want to continue comparing stations?";
+    if(statusBar()->currentMessage() == "Not all changes are saved )=" && !showWarningMessage(warningMessage)){
+        return;
+    }
+
+    if(dataset.getStationCount() < 2){
+        QMessageBox::information(this, "Compare stations", "Add at least two stations to compare them.", QMessageBox::Ok);
+        return;
+    }
+
+    storeCurrentStation();
+
+    QStringList stationNames;
+    for(int i = 0; i < dataset.getStationCount(); ++i){
+        QString stationId = dataset.getStation(i).m_id;
+        stationNames << (stationId.isEmpty() ? "(unnamed station)" : stationId);
+    }
+
+    // Ask the user for the weather parameter, the kind of comparison and what to do with missing days.
+    QStringList parameters;
+    parameters << "Temperature" << "Pressure" << "Humidity";
+
+    QStringList comparisons;
+    comparisons << "All stations and their mean" << "Difference between two stations";
+
+    QStringList policies;
+    policies << "Only days all the stations have" << "Leave gaps on missing days" << "Repeat the previous day on missing days";
+
+    bool isOk;
+    QString parameter = QInputDialog::getItem(this, "Compare stations", "Weather parameter:", parameters, 0, false, &isOk);
+    if(!isOk){
+        return;
+    }
+
+    QString comparison = QInputDialog::getItem(this, "Compare stations", "Comparison:", comparisons, 0, false, &isOk);
+    if(!isOk){
+        return;
+    }
+
+    QString policy = QInputDialog::getItem(this, "Compare stations", "Missing days:", policies, 0, false, &isOk);
+    if(!isOk){
+        return;
+    }
+
+    WeatherColumn column = static_cast<WeatherColumn>(parameters.indexOf(parameter) + 1);
+    CWeatherJoin::missingDayPolicy missingDays = static_cast<CWeatherJoin::missingDayPolicy>(policies.indexOf(policy));
+
+    // The difference is taken between two stations chosen by the user.
+    std::vector<int> stationIndexes;
+    if(comparisons.indexOf(comparison) == 1){
+        QString first = QInputDialog::getItem(this, "Compare stations", "Station:", stationNames, 0, false, &isOk);
+        if(!isOk){
+            return;
+        }
+
+        QString second = QInputDialog::getItem(this, "Compare stations", "Subtract station:", stationNames, 1, false, &isOk);
+        if(!isOk){
+            return;
+        }
+
+        stationIndexes = {static_cast<int>(stationNames.indexOf(first)), static_cast<int>(stationNames.indexOf(second))};
+    }
+    else{
+        for(int i = 0; i < dataset.getStationCount(); ++i){
+            stationIndexes.push_back(i);
+        }
+    }
+
+    // Join the stations by date (no weather data is copied).
+    std::vector<WeatherView> series;
+    for(int stationIndex : stationIndexes){
+        series.push_back(dataset.getStation(stationIndex).m_weather);
+    }
+
+    CWeatherJoin join(std::move(series), missingDays);
+
+    std::vector<graphOverlay> lines;
+    if(comparisons.indexOf(comparison) == 1){
+        lines.push_back(join.getDifferenceLine(0, 1, column, stationNames[stationIndexes[0]] + " - " + stationNames[stationIndexes[1]]));
+    }
+    else{
+        for(int i = 0; i < join.getSeriesCount(); ++i){
+            lines.push_back(join.getSeriesLine(i, column, stationNames[stationIndexes[i]]));
+        }
+        lines.push_back(join.getMeanLine(column, "Mean of the stations"));
+    }
+
+    WeatherView::buildWeatherGraph(join.getDates(), lines, parameter + " of the stations");
+}
+
+
+// Report missing days, duplicate dates and days out of date order, and fill the missing days if the user wants to.
+void MainWindow::on_actionCheck_dates_triggered()
+{
+    QString warningMessage = "You did not save all the changes you made. Do you want to continue checking the dates?";
+    if(statusBar()->currentMessage() == "Not all changes are saved )=" && !showWarningMessage(warningMessage)){
+        return;
+    }
+
+    CWeatherGaps gaps(mainWeather);
+
+    if(gaps.isContinuous()){
+        showOutputDataMessage("The days of the table follow each other without missing or repeated days.");
+        return;
+    }
+
+    // Describe the first few gaps and count the rest.
+    WeatherView view = mainWeather.getView();
+    QString output = QString("Missing days: %1 (in %2 gaps).\nRows with a repeated date: %3.\nRows out of date order: %4.")
+                         .arg(gaps.getMissingDayCount()).arg(gaps.getGaps().size())
+                         .arg(gaps.getDuplicateIndexes().size()).arg(gaps.getOutOfOrderIndexes().size());
+
+    const int shownGapCount = 10;
+    for(int i = 0; i < gaps.getGaps().size() && i < shownGapCount; ++i){
+        const CWeatherGaps::dateGap& gap = gaps.getGaps()[i];
+        output += QString("\n%1 - %2 (%3 days)").arg(view.getDate(gap.m_index - 1).addDays(1).toString("dd.MM.yyyy"))
+                      .arg(view.getDate(gap.m_index).addDays(-1).toString("dd.MM.yyyy")).arg(gap.m_missingDayCount);
+    }
+    if(gaps.getGaps().size() > shownGapCount){
+        output += QString("\n... and %1 more gaps").arg(gaps.getGaps().size() - shownGapCount);
+    }
+
+    showOutputDataMessage(output);
+
+    // Ask the user how to fill the missing days (filling also puts the days in date order and removes repeated dates).
+    QStringList strategies;
+    strategies << "Do not fill" << "Linear interpolation" << "Previous day" << "Climatology of the table";
+
+    bool isOk;
+    QString strategy = QInputDialog::getItem(this, "Check dates", "Fill missing days:", strategies, 0, false, &isOk);
+    if(!isOk || strategies.indexOf(strategy) == 0){
+        return;
+    }
+
+    mainWeather = CWeatherGaps::fillGaps(mainWeather, static_cast<CWeatherGaps::fillStrategy>(strategies.indexOf(strategy) - 1)).m_weather;
+    mainWeather.completeTable(ui->weatherTable);
+    statusBar()->showMessage("All changes have been saved (=");
+    applyTableFilter();
+}
+
+
+// Let the user choose how analyses of consecutive days treat missing days.
+void MainWindow::on_actionMissing_days_in_analyses_triggered()
+{
+    QStringList options;
+    options << "Treat neighbouring rows as neighbouring days" << "End periods at missing days" << "Fill missing days (linearly) first";
+
+    bool isOk;
+    QString option = QInputDialog::getItem(this, "Missing days in analyses", "Missing days:", options,
+                                           static_cast<int>(analysisContinuity), false, &isOk);
+    if(isOk){
+        analysisContinuity = static_cast<DayContinuity>(options.indexOf(option));
+    }
+}
+
+
+// Show the p5, median and p95 of temperature, pressure and humidity over a range of months of one or all stations.
+void MainWindow::on_actionPercentiles_triggered()
+{
+    QString warningMessage = "You did not save all the changes you made. Do you want to continue computing percentiles?";
+    if(statusBar()->currentMessage() == "Not all changes are saved )=" && !showWarningMessage(warningMessage)){
+        return;
+    }
+
+    storeCurrentStation();
+
+    // Create a dialog for choosing the months and the station.
+    QDialog dialog;
+    dialog.setWindowTitle("Percentiles");
+
+    QDateEdit* firstMonthEdit = new QDateEdit(&dialog);
+    firstMonthEdit->setDisplayFormat("MM.yyyy");
+    QDateEdit* lastMonthEdit = new QDateEdit(&dialog);
+    lastMonthEdit->setDisplayFormat("MM.yyyy");
+
+    QComboBox* stationComboBox = new QComboBox(&dialog);
+    stationComboBox->addItem("All stations");
+    for(int i = 0; i < dataset.getStationCount(); ++i){
+        QString stationId = dataset.getStation(i).m_id;
+        stationComboBox->addItem(stationId.isEmpty() ? "(unnamed station)" : stationId);
+    }
+    stationComboBox->setCurrentIndex(dataset.getStationCount() > 1 ? 0 : 1);
+
+    QPushButton* computeButton = new QPushButton("Compute", &dialog);
+    connect(computeButton, &QPushButton::clicked, &dialog, &QDialog::accept);
+
+    QVBoxLayout layout(&dialog);
+    layout.addWidget(new QLabel("From month:", &dialog));
+    layout.addWidget(firstMonthEdit);
+    layout.addWidget(new QLabel("To month:", &dialog));
+    layout.addWidget(lastMonthEdit);
+    layout.addWidget(stationComboBox);
+    layout.addWidget(computeButton);
+
+    if(dialog.exec() != QDialog::Accepted){
+        return;
+    }
+
+    try {
+        if(firstMonthEdit->date() > lastMonthEdit->date()){
+            throw QString("The start date cannot be greater than the end date!");
+        }
+    } catch (const QString& exception) {
+        showErrorMessage(exception);
+        return;
+    }
+
+    // The percentiles are read from the merged monthly histograms, without going through the days.
+    int stationIndex = stationComboBox->currentIndex() - 1;
+    QStringList parameters;
+    parameters << "Temperature" << "Pressure" << "Humidity";
+    QString output;
+
+    for(int i = 0; i < parameters.size(); ++i){
+        CValueHistogram histogram = dataset.getHistogram(stationIndex, static_cast<WeatherColumn>(i + 1),
+                                                         firstMonthEdit->date(), lastMonthEdit->date());
+        if(histogram.getCount() == 0){
+            showOutputDataMessage("We have no information about this period. Try adding data for this period and refreshing the table.");
+            return;
+        }
+
+        output += QString("%1 (%2 days): p5 = %3, median = %4, p95 = %5\n").arg(parameters[i]).arg(histogram.getCount())
+                      .arg(histogram.getPercentile(5)).arg(histogram.getPercentile(50)).arg(histogram.getPercentile(95));
+    }
+
+    showOutputDataMessage(output.trimmed());
+}
+
+
+// Plot the wind rose (direction frequencies) of every season and of the whole year.
+void MainWindow::on_actionWind_rose_triggered()
+{
+    QString warningMessage = "You did not save all the changes you made. Do you really want to continue build the wind rose?";
+    if(statusBar()->currentMessage() == "Not all changes are saved )=" && !showWarningMessage(warningMessage)){
+        return;
+    }
+
+    CWindStatistics(mainWeather).buildWindRoseGraph("Wind rose");
+}
+
+
+// Show how long each wind direction lasted and how often it changed to every other direction on the next day.
+void MainWindow::on_actionWind_persistence_triggered()
+{
+    QString warningMessage = "You did not save all the changes you made. Do you want to continue analysing the wind?";
+    if(statusBar()->currentMessage() == "Not all changes are saved )=" && !showWarningMessage(warningMessage)){
+        return;
+    }
+
+    CWindStatistics statistics(mainWeather);
+    CWindStatistics::windRose totalRose = statistics.getTotalRose();
+
+    // Create a table with a row for each direction: its days, runs and the probabilities of the next day's direction.
+    QDialog dialog;
+    dialog.setWindowTitle("Wind persistence and transitions");
+    dialog.setMinimumSize(1000, 340);
+
+    QTableWidget* windTable = new QTableWidget(&dialog);
+    windTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    windTable->setColumnCount(3 + CWindStatistics::WIND_DIRECTION_CNT);
+    windTable->setRowCount(CWindStatistics::WIND_DIRECTION_CNT);
+
+    QStringList columnNames, rowNames;
+    columnNames << "Days" << "Avg run (days)" << "Longest run";
+    for(int d = 1; d <= CWindStatistics::WIND_DIRECTION_CNT; ++d){
+        QString directionText = convertWindDirToText(static_cast<WindDirection>(d));
+        columnNames << "Next day " + directionText;
+        rowNames << directionText;
+    }
+    windTable->setHorizontalHeaderLabels(columnNames);
+    windTable->setVerticalHeaderLabels(rowNames);
+
+    for(int d = 1; d <= CWindStatistics::WIND_DIRECTION_CNT; ++d){
+        WindDirection direction = static_cast<WindDirection>(d);
+        const std::vector<int>& runs = statistics.getPersistenceHistogram(direction);
+
+        windTable->setItem(d - 1, 0, new QTableWidgetItem(QString::number(totalRose[d - 1])));
+        windTable->setItem(d - 1, 1, new QTableWidgetItem(QString::number(statistics.getMeanPersistence(direction), 'f', 2)));
+        windTable->setItem(d - 1, 2, new QTableWidgetItem(QString::number(runs.empty() ? 0 : runs.size() - 1)));
+
+        for(int next = 1; next <= CWindStatistics::WIND_DIRECTION_CNT; ++next){
+            double probability = statistics.getTransitionProbability(direction, static_cast<WindDirection>(next));
+            windTable->setItem(d - 1, 2 + next, new QTableWidgetItem(QString::number(probability * 100, 'f', 1) + "%"));
+        }
+    }
+
+    QVBoxLayout layout(&dialog);
+    layout.addWidget(windTable);
+
+    dialog.exec();
+}
+
+
+// Write the main weather to a file in the compact binary format.
+void MainWindow::on_actionSave_as_binary_triggered()
+{
+    QString warningMessage = "You did not save all the changes you made. Do you really want to save the last changes "
+                             "you made to a file?";
+    if(statusBar()->currentMessage() == "Not all changes are saved )=" && !showWarningMessage(warningMessage)){
+        return;
+    }
+
+    // Prompt the user to select a file for saving.
+    QString fileName = QFileDialog::getSaveFileName(this, "Select a file", "/Users/artomrevus/Desktop", "Binary weather file (*.wbin)");
+    if(fileName.isEmpty()){
+        return;
+    }
+
+    try {
+        CWeatherFileReader::writeBinary(fileName, mainWeather);
+    } catch (const QString& exception) {
+        showErrorMessage(exception);
+        return;
+    }
+
+    showOutputDataMessage(QString("%1 days have been written to the binary file.").arg(mainWeather.getWeatherSize()));
+}
+
+
+// Run the main analyses over a text or binary file in one streaming pass, without loading it into the table.
+void MainWindow::on_actionAnalyse_file_triggered()
+{
+    // Prompt the user to select a weather file.
+    QString fileName = QFileDialog::getOpenFileName(this, "Select a file", "/Users/artomrevus/Desktop",
+                                                    "Weather file (*.txt *.wbin)");
+    if(fileName.isEmpty()){
+        return;
+    }
+
+    // Create a dialog for choosing the analysed dates.
+    QDialog* dialog = createDialog("Choose date", 250, 200);
+
+    QDateEdit* startDateEdit = new QDateEdit(QDate(1900, 1, 1), dialog);
+    startDateEdit->setCalendarPopup(true);
+    QDateEdit* endDateEdit = new QDateEdit(QDate::currentDate(), dialog);
+    endDateEdit->setCalendarPopup(true);
+
+    QPushButton* analyseButton = new QPushButton("Analyse", dialog);
+    connect(analyseButton, &QPushButton::clicked, dialog, &QDialog::accept);
+
+    QVBoxLayout* layout = new QVBoxLayout(dialog);
+    layout->addWidget(startDateEdit);
+    layout->addWidget(endDateEdit);
+    layout->addWidget(analyseButton);
+
+    if(dialog->exec() != QDialog::Accepted){
+        return;
+    }
+
+    // The days are read in blocks and only the results are kept, so the file can be larger than the memory.
+    CWeatherStreamAnalysis analysis(startDateEdit->date(), endDateEdit->date());
+
+    try {
+        if(startDateEdit->date() > endDateEdit->date()){
+            throw QString("The start date cannot be greater than the end date!");
+        }
+
+        analysis = CWeatherStreamAnalysis::analyseFile(fileName, startDateEdit->date(), endDateEdit->date());
+    } catch (const QString& exception) {
+        showErrorMessage(exception);
+        return;
+    }
+
+    if(analysis.getDayCount() == 0){
+        showOutputDataMessage("We have no information about this period in the file.");
+        return;
+    }
+
+    // Summarise the results.
+    QString output = QString("Days: %1\nAverage temperature: %2\nAverage pressure: %3\n").arg(analysis.getDayCount())
+                         .arg(analysis.getAvgTemperature()).arg(analysis.getAvgPressure());
+
+    output += QString("Highest humidity (%1%) days: %2").arg(analysis.getMaxHumidity()).arg(analysis.getHighestHumidityDays().size());
+    if(!analysis.getHighestHumidityDays().empty()){
+        output += ", the first on " + analysis.getHighestHumidityDays().front().toString("dd.MM.yyyy");
+    }
+
+    // Only the longest wind period is shown; the count covers all of them.
+    const std::vector<CWeatherStreamAnalysis::dayPeriod>& windPeriods = analysis.getWindPeriods();
+    output += QString("\nPeriods when the wind direction did not change: %1").arg(windPeriods.size());
+    if(!windPeriods.empty()){
+        const CWeatherStreamAnalysis::dayPeriod* longest = &windPeriods.front();
+        for(const CWeatherStreamAnalysis::dayPeriod& period : windPeriods){
+            if(period.m_dayCount > longest->m_dayCount){
+                longest = &period;
+            }
+        }
+        output += QString(", the longest: %1 days of %2 wind (%3 - %4)").arg(longest->m_dayCount)
+                      .arg(convertWindDirToText(longest->m_windDirection))
+                      .arg(longest->m_firstDate.toString("dd.MM.yyyy"), longest->m_lastDate.toString("dd.MM.yyyy"));
+    }
+
+    output += QString("\nPeriods (3 and more days) when the pressure varied within ±2.5% and t ±3.6%: %1")
+                  .arg(analysis.getStablePeriods().size());
+
+    showOutputDataMessage(output);
+}
+
+
+// Sort several files by date in bounded memory, merge them into one series and open it.
+void MainWindow::on_actionOpen_and_merge_triggered()
+{
+    QString warningMessage = "When you click the OK button, all previous data will be erased and the table will be filled from the merged files.";
+    if(!showWarningMessage(warningMessage)){
+        return;
+    }
+
+    // Prompt the user to select the files.
+    QStringList fileNames = QFileDialog::getOpenFileNames(this, "Select files", "/Users/artomrevus/Desktop",
+                                                          "Weather file (*.txt *.wbin)");
+    if(fileNames.isEmpty()){
+        return;
+    }
+
+    QMessageBox::StandardButton answer = QMessageBox::question(this, "Repeated dates",
+                                                               "Keep only the first day of every repeated date?");
+    CWeatherExternalSort sorter(CWeatherExternalSort::DEFAULT_MEMORY_BUDGET, answer == QMessageBox::Yes
+                                                                                 ? CWeatherExternalSort::DropDuplicates
+                                                                                 : CWeatherExternalSort::KeepDuplicates);
+
+    // The files are merged into a temporary text file, which is then opened the usual way.
+    QTemporaryDir mergeDir;
+    QString mergedFileName = mergeDir.filePath("merged.txt");
+    CWeatherExternalSort::sortSummary summary;
+
+    try {
+        if(!mergeDir.isValid()){
+            throw QString("A temporary folder for sorting could not be created.");
+        }
+
+        summary = sorter.sortFiles(fileNames, mergedFileName, false);
+    } catch (const QString& exception) {
+        showErrorMessage(exception);
+        return;
+    }
+
+    openDatasetFile(mergedFileName, true);
+
+    // Report what was merged.
+    QString output = QString("%1 days have been merged from %2 files.").arg(summary.m_writtenDayCount).arg(fileNames.size());
+    if(summary.m_invalidDayCount != 0){
+        output += QString("\n%1 days with invalid dates have been skipped.").arg(summary.m_invalidDayCount);
+    }
+    if(!summary.m_duplicateDates.empty()){
+        output += QString("\n%1 dates were repeated (%2), the first on %3.").arg(summary.m_duplicateDates.size())
+                      .arg(answer == QMessageBox::Yes ? "only their first days were kept" : "all their days were kept")
+                      .arg(summary.m_duplicateDates.front().toString("dd.MM.yyyy"));
+    }
+
+    showOutputDataMessage(output);
+}
+
+
+// Waits for the background compaction of the journal (if one is running) and replaces the file with its result.
+void MainWindow::finishJournalCompaction()
+{
+    if(!isCompactionRunning){
+        return;
+    }
+
+    compactionWatcher.waitForFinished();
+    isCompactionRunning = false;
+
+    try {
+        journal.finishCompaction(compactionWatcher.result());
+    } catch (const QString& exception) {
+        showErrorMessage(exception);
+    }
+}
+
+
+// Save only the changes since the last save to the journal of the file (the first save writes the whole file).
+void MainWindow::on_actionJournaled_save_triggered()
+{
+    QString warningMessage = "You did not save all the changes you made. Do you really want to save the last changes "
+                             "you made to a file?";
+    if(statusBar()->currentMessage() == "Not all changes are saved )=" && !showWarningMessage(warningMessage)){
+        return;
+    }
+
+    // A background save still running could commit its older snapshot over the file after the base file is written.
+    finishBackgroundSave();
+
+    // The first journaled save chooses the file.
+    if(!journal.isActive())
+    {
+        QString fileName = QFileDialog::getSaveFileName(this, "Select a file", "/Users/artomrevus/Desktop", "Text file (*.txt)");
+        if(fileName.isEmpty()){
+            return;
+        }
+
+        finishJournalCompaction();
+        journal = CWeatherJournal(fileName);
+
+        if(fileName == openedFileName){
+            stopFollowingFile();
+            openedFileName.clear();
+        }
+    }
+
+    storeCurrentStation();
+    CWeatherJournal::saveResult result;
+
+    try {
+        result = journal.save(dataset);
+    } catch (const QString& exception) {
+        showErrorMessage(exception);
+        return;
+    }
+
+    // Compact the journal in the background when it has grown large.
+    if(journal.isCompactionNeeded()){
+        isCompactionRunning = true;
+        compactionWatcher.setFuture(journal.startCompaction());
+    }
+
+    if(result.m_isFullWrite){
+        showOutputDataMessage("The whole file has been written; the next saves will record only the changes.");
+    }
+    else{
+        showOutputDataMessage(QString("%1 changes have been recorded (%2 bytes).").arg(result.m_changeCount).arg(result.m_writtenBytes));
+    }
+}
+
+
+// Turn on or off following the opened file: days appended to it by other programs are added to the table.
+void MainWindow::on_actionFollow_file_triggered()
+{
+    if(!ui->actionFollow_file->isChecked()){
+        stopFollowingFile();
+        return;
+    }
+
+    if(openedFileName.isEmpty()){
+        stopFollowingFile();
+        showErrorMessage("Open a text file to follow it (files with a journal and files saved over cannot be followed).");
+        return;
+    }
+
+    // Only the part appended after the read part is read (days appended in the meantime are read at once).
+    fileFollower = std::make_unique<CWeatherFileFollower>(openedFileName, openedFileSize, openedFileStation);
+    fileWatcher.addPath(openedFileName);
+    readFollowedFile();
+}
+
+
+// Adds the days appended to the followed file to the dataset and to the end of the main weather table.
+void MainWindow::readFollowedFile()
+{
+    if(!fileFollower){
+        return;
+    }
+
+    // A file that has been deleted and written again is no longer watched.
+    if(!fileWatcher.files().contains(openedFileName)){
+        fileWatcher.addPath(openedFileName);
+    }
+
+    std::vector<CWeatherFileFollower::appendedDays> appended;
+    int stationCount = dataset.getStationCount();
+
+    try {
+        appended = fileFollower->readAppendedDays();
+
+        for(const CWeatherFileFollower::appendedDays& stationDays : appended)
+        {
+            // Days before the first station line belong to the first station.
+            int index = stationDays.m_stationId.isEmpty() ? 0 : dataset.findStation(stationDays.m_stationId);
+            if(index == -1){
+                index = dataset.addStation(stationDays.m_stationId);
+            }
+
+            if(index != currentStation){
+                dataset.appendStationDays(index, stationDays.m_days);
+                continue;
+            }
+
+            // The shown station is released by the dataset first, so adding days to it does not copy its data.
+            int firstIndex = mainWeather.getWeatherSize();
+            int firstRow = ui->weatherTable->rowCount();
+
+            dataset.setStationWeather(currentStation, CWather());
+            mainWeather.appendDays(stationDays.m_days);
+            storeCurrentStation();
+
+            // The new rows are the content of the file, not changes of the user.
+            QSignalBlocker blocker(ui->weatherTable);
+            mainWeather.appendToTable(ui->weatherTable, firstIndex);
+
+            if(tableFilter){
+                CSelectionBitmap selection = tableFilter->evaluate(mainWeather);
+                for(int i = firstIndex; i < mainWeather.getWeatherSize(); ++i){
+                    ui->weatherTable->setRowHidden(firstRow + i - firstIndex, !selection.isSelected(i));
+                }
+            }
+        }
+    } catch (const QString& exception) {
+        stopFollowingFile();
+        openedFileName.clear();
+        showErrorMessage(exception);
+    }
+
+    if(dataset.getStationCount() != stationCount){
+        updateStationComboBox();
+    }
+}
+
+
+// Stops following the opened file.
+void MainWindow::stopFollowingFile()
+{
+    // Following can be turned on again from where it stopped.
+    if(fileFollower){
+        openedFileSize = fileFollower->getPosition();
+        openedFileStation = fileFollower->getStationId();
+        fileFollower.reset();
+    }
+
+    if(!fileWatcher.files().isEmpty()){
+        fileWatcher.removePaths(fileWatcher.files());
+    }
+
+    ui->actionFollow_file->setChecked(false);
+}
+
+
+// Plots a graph of a derived column chosen by the user.
+void MainWindow::on_actionBuild_graph_of_derived_column_triggered()
+{
+    QString warningMessage = "You did not save all the changes you made. Do you really want to continue build the graph?";
+    if(statusBar()->currentMessage() == "Not all changes are saved )=" && !showWarningMessage(warningMessage)){
+        return;
+    }
+
+    // Ask the user for the derived column.
+    QStringList titles;
+    for(int i = 1; i <= CDerivedColumns::COLUMN_CNT; ++i){
+        titles << CDerivedColumns::getTitle(static_cast<DerivedColumn>(i));
+    }
+
+    bool isOk;
+    QString title = QInputDialog::getItem(this, "Derived column graph", "Derived column:", titles, 0, false, &isOk);
+    if(!isOk){
+        return;
+    }
+
+    DerivedColumn column = static_cast<DerivedColumn>(titles.indexOf(title) + 1);
+
+    mainWeather.buildWeatherGraph([this, column](int i){
+        return mainWeather.getDerivedValue(column, i);
+    }, title);
+}
+
+
+// Within a season (3 months), sort the records by a derived column chosen by the user and update the main weather table.
+void MainWindow::on_actionSort_by_derived_column_within_seasons_triggered()
+{
+    // Display a warning if there are unsaved changes.
+    QString warningMessage = "You did not save all the changes you made. Do you want to continue?";
+    if(statusBar()->currentMessage() == "Not all changes are saved )=" && !showWarningMessage(warningMessage)){
+        return;
+    }
+
+    // Ask the user for the derived column.
+    QStringList titles;
+    for(int i = 1; i <= CDerivedColumns::COLUMN_CNT; ++i){
+        titles << CDerivedColumns::getTitle(static_cast<DerivedColumn>(i));
+    }
+
+    bool isOk;
+    QString title = QInputDialog::getItem(this, "Sort by a derived column", "Derived column:", titles, 0, false, &isOk);
+    if(!isOk){
+        return;
+    }
+
+    // Display a warning about the potential impact on the table.
+    warningMessage = "This function can «ruin» a table because it changes the order of its elements. Do you really want to continue?";
+    if (!showWarningMessage(warningMessage)){
+        return;
+    }
+
+    mainWeather.sortBySeason(static_cast<DerivedColumn>(titles.indexOf(title) + 1));
+    mainWeather.completeTable(ui->weatherTable);
+    statusBar()->showMessage("All changes have been saved (=");
+    applyTableFilter();
+}
+
+
+// Replay the history of the table: forecast every month from the days before it and show how far off the forecasts were.
+void MainWindow::on_actionBacktest_forecasts_triggered()
+{
+    QString warningMessage = "You did not save all the changes you made. Do you want to continue backtesting forecasts?";
+    if(statusBar()->currentMessage() == "Not all changes are saved )=" && !showWarningMessage(warningMessage)){
+        return;
+    }
+
+    // The same seed every time, so the scores of the same table can be compared.
+    CForecastBacktest::backtestResult result = CForecastBacktest::run(mainWeather, 1);
+
+    if(result.m_months.empty()){
+        showErrorMessage("There are no months to backtest: a month needs at least "
+                         + QString::number(CForecastBacktest::DEFAULT_MIN_HISTORY_DAYS) + " days of history before it.");
+        return;
+    }
+
+    showOutputDataMessage("Monthly forecasts compared with the observed days:\n" + CForecastBacktest::toText(result));
+}
+
+
+// Find heat waves, cold spells and pressure falls by the limits chosen by the user (in every station) and list them.
+void MainWindow::on_actionFind_extreme_events_triggered()
+{
+    QString warningMessage = "You did not save all the changes you made. Do you want to continue searching for extreme events?";
+    if(statusBar()->currentMessage() == "Not all changes are saved )=" && !showWarningMessage(warningMessage)){
+        return;
+    }
+
+    // Ask the user for the limits of the default rules.
+    std::vector<CEventDetector::eventRule> rules = CEventDetector::getDefaultRules();
+    CEventDetector::eventRule& heatWave = rules[0];
+    CEventDetector::eventRule& coldSpell = rules[1];
+    CEventDetector::eventRule& pressureFall = rules[2];
+
+    QDialog dialog;
+    dialog.setWindowTitle("Extreme events");
+
+    QSpinBox* heatPercentileSpinBox = new QSpinBox(&dialog);
+    heatPercentileSpinBox->setRange(50, 99);
+    heatPercentileSpinBox->setValue(static_cast<int>(heatWave.m_percentile));
+    QSpinBox* coldPercentileSpinBox = new QSpinBox(&dialog);
+    coldPercentileSpinBox->setRange(1, 50);
+    coldPercentileSpinBox->setValue(static_cast<int>(coldSpell.m_percentile));
+    QSpinBox* minDaysSpinBox = new QSpinBox(&dialog);
+    minDaysSpinBox->setRange(1, 30);
+    minDaysSpinBox->setValue(heatWave.m_minDayCount);
+    minDaysSpinBox->setSuffix(" days");
+    QCheckBox* monthlyCheckBox = new QCheckBox("Percentiles of the calendar month", &dialog);
+    monthlyCheckBox->setChecked(heatWave.m_isMonthlyPercentile);
+    QSpinBox* pressureFallSpinBox = new QSpinBox(&dialog);
+    pressureFallSpinBox->setRange(1, 100);
+    pressureFallSpinBox->setValue(pressureFall.m_minChange);
+    pressureFallSpinBox->setSuffix(" mmHg");
+    QSpinBox* windowSpinBox = new QSpinBox(&dialog);
+    windowSpinBox->setRange(1, 7);
+    windowSpinBox->setValue(pressureFall.m_windowDays);
+    windowSpinBox->setSuffix(" days");
+    QCheckBox* allStationsCheckBox = new QCheckBox("All stations", &dialog);
+    allStationsCheckBox->setChecked(dataset.getStationCount() > 1);
+
+    QPushButton* findButton = new QPushButton("Find", &dialog);
+    connect(findButton, &QPushButton::clicked, &dialog, &QDialog::accept);
+
+    QVBoxLayout layout(&dialog);
+    layout.addWidget(new QLabel("Heat wave: t above the percentile", &dialog));
+    layout.addWidget(heatPercentileSpinBox);
+    layout.addWidget(new QLabel("Cold spell: t below the percentile", &dialog));
+    layout.addWidget(coldPercentileSpinBox);
+    layout.addWidget(new QLabel("Shortest heat wave or cold spell:", &dialog));
+    layout.addWidget(minDaysSpinBox);
+    layout.addWidget(monthlyCheckBox);
+    layout.addWidget(new QLabel("Pressure fall of at least:", &dialog));
+    layout.addWidget(pressureFallSpinBox);
+    layout.addWidget(new QLabel("Within:", &dialog));
+    layout.addWidget(windowSpinBox);
+    layout.addWidget(allStationsCheckBox);
+    layout.addWidget(findButton);
+
+    if(dialog.exec() != QDialog::Accepted){
+        return;
+    }
+
+    heatWave.m_percentile = heatPercentileSpinBox->value();
+    coldSpell.m_percentile = coldPercentileSpinBox->value();
+    heatWave.m_minDayCount = minDaysSpinBox->value();
+    coldSpell.m_minDayCount = minDaysSpinBox->value();
+    heatWave.m_isMonthlyPercentile = monthlyCheckBox->isChecked();
+    coldSpell.m_isMonthlyPercentile = monthlyCheckBox->isChecked();
+    pressureFall.m_minChange = pressureFallSpinBox->value();
+    pressureFall.m_windowDays = windowSpinBox->value();
+
+    // Search the stations in parallel (or only the station shown in the table).
+    CEventDetector detector(rules);
+    std::vector<int> stationIndexes;
+    std::vector<std::vector<CEventDetector::extremeEvent>> stationEvents;
+
+    storeCurrentStation();
+    if(allStationsCheckBox->isChecked()){
+        stationEvents = detector.detectStations(dataset, analysisContinuity);
+        for(int i = 0; i < dataset.getStationCount(); ++i){
+            stationIndexes.push_back(i);
+        }
+    }
+    else{
+        stationEvents.push_back(detector.detect(mainWeather, analysisContinuity));
+        stationIndexes.push_back(currentStation);
+    }
+
+    int eventCount = 0;
+    for(const std::vector<CEventDetector::extremeEvent>& events : stationEvents){
+        eventCount += events.size();
+    }
+
+    if(eventCount == 0){
+        showOutputDataMessage("No extreme events were found with these limits.");
+        return;
+    }
+
+    // Create a table with a row for each event.
+    QDialog resultDialog;
+    resultDialog.setWindowTitle("Extreme events: " + QString::number(eventCount));
+    resultDialog.setMinimumSize(700, 400);
+
+    QTableWidget* eventTable = new QTableWidget(&resultDialog);
+    eventTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    eventTable->setColumnCount(6);
+    QStringList columnNames;
+    columnNames << "Station" << "Event" << "From" << "To" << "Days" << "Peak";
+    eventTable->setHorizontalHeaderLabels(columnNames);
+    eventTable->setRowCount(eventCount);
+
+    int row = 0;
+    for(int s = 0; s < stationEvents.size(); ++s){
+        const CWeatherDataset::station& stationData = dataset.getStation(stationIndexes[s]);
+
+        for(const CEventDetector::extremeEvent& event : stationEvents[s]){
+            const CEventDetector::eventRule& rule = rules[event.m_ruleIndex];
+            QString peak = rule.m_type == CEventDetector::FallWithinWindow ? "-" + QString::number(event.m_extremeValue) + " mmHg"
+                                                                           : QString::number(event.m_extremeValue) + "°C";
+
+            eventTable->setItem(row, 0, new QTableWidgetItem(stationData.m_id.isEmpty() ? "(unnamed station)" : stationData.m_id));
+            eventTable->setItem(row, 1, new QTableWidgetItem(rule.m_name));
+            eventTable->setItem(row, 2, new QTableWidgetItem(event.m_firstDate.toString("dd.MM.yyyy")));
+            eventTable->setItem(row, 3, new QTableWidgetItem(event.m_lastDate.toString("dd.MM.yyyy")));
+            eventTable->setItem(row, 4, new QTableWidgetItem(QString::number(event.m_dayCount)));
+            eventTable->setItem(row, 5, new QTableWidgetItem(peak));
+            row++;
+        }
+    }
+
+    QVBoxLayout resultLayout(&resultDialog);
+    resultLayout.addWidget(eventTable);
+
+    resultDialog.exec();
 }
@@ -0,0 +1,135 @@
+#include "../Header Files/rollingstatistics.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+
+
+// State of one window size while the column is scanned.
+struct windowState
+{
+    // Exact sums of the values and of their squares in the window (the values are integers, so no precision is lost).
+    long long m_sum = 0;
+    long long m_sumSq = 0;
+    // Indexes of the candidates for the window minimum (values increase) and maximum (values decrease).
+    std::deque<int> m_minCandidates;
+    std::deque<int> m_maxCandidates;
+};
+
+
+// Computes the statistics of all window sizes in one pass over the column.
+CRollingStatistics::CRollingStatistics(const WeatherView& weather, WeatherColumn column, const std::vector<int>& windowSizes)
+{
+    std::vector<int> values = weather.getColumn(column);
+    int dayCount = static_cast<int>(values.size());
+
+    // Prepare the result of each window size (windows that do not fit into the data stay empty).
+    windows.resize(windowSizes.size());
+    std::vector<windowState> states(windowSizes.size());
+
+    for (int w = 0; w < windowSizes.size(); ++w)
+    {
+        windows[w].m_windowSize = windowSizes[w];
+
+        if (windowSizes[w] >= 1 && windowSizes[w] <= dayCount) {
+            int resultCount = dayCount - windowSizes[w] + 1;
+            windows[w].m_mean.resize(resultCount);
+            windows[w].m_stdDev.resize(resultCount);
+            windows[w].m_min.resize(resultCount);
+            windows[w].m_max.resize(resultCount);
+        }
+    }
+
+    // Scan the column once, moving all windows forward by one day at a time.
+    for (int i = 0; i < dayCount; ++i)
+    {
+        long long value = values[i];
+
+        for (int w = 0; w < windows.size(); ++w)
+        {
+            int windowSize = windows[w].m_windowSize;
+            if (windows[w].m_mean.empty()) {
+                continue;
+            }
+
+            windowState& state = states[w];
+
+            // Add the new day to the window.
+            state.m_sum += value;
+            state.m_sumSq += value * value;
+
+            while (!state.m_minCandidates.empty() && values[state.m_minCandidates.back()] >= value) {
+                state.m_minCandidates.pop_back();
+            }
+            state.m_minCandidates.push_back(i);
+
+            while (!state.m_maxCandidates.empty() && values[state.m_maxCandidates.back()] <= value) {
+                state.m_maxCandidates.pop_back();
+            }
+            state.m_maxCandidates.push_back(i);
+
+            // Remove the day that left the window.
+            int firstDay = i - windowSize + 1;
+            if (firstDay > 0) {
+                long long oldValue = values[firstDay - 1];
+                state.m_sum -= oldValue;
+                state.m_sumSq -= oldValue * oldValue;
+            }
+
+            if (state.m_minCandidates.front() < firstDay) {
+                state.m_minCandidates.pop_front();
+            }
+            if (state.m_maxCandidates.front() < firstDay) {
+                state.m_maxCandidates.pop_front();
+            }
+
+            // Record the statistics once the window is full.
+            if (firstDay >= 0)
+            {
+                double mean = static_cast<double>(state.m_sum) / windowSize;
+                double variance = static_cast<double>(state.m_sumSq * windowSize - state.m_sum * state.m_sum)
+                                  / (static_cast<double>(windowSize) * windowSize);
+
+                windows[w].m_mean[firstDay] = mean;
+                windows[w].m_stdDev[firstDay] = std::sqrt(std::max(0.0, variance));
+                windows[w].m_min[firstDay] = values[state.m_minCandidates.front()];
+                windows[w].m_max[firstDay] = values[state.m_maxCandidates.front()];
+            }
+        }
+    }
+}
+
+
+// Used to get the number of window sizes.
+int CRollingStatistics::getWindowCount() const
+{
+    return static_cast<int>(windows.size());
+}
+
+
+// Used to get the statistics of a certain window size.
+const CRollingStatistics::rollingWindow& CRollingStatistics::getWindow(int index) const
+{
+    return windows[index];
+}
+
+
+// Builds graph overlays with the moving averages of all window sizes.
+std::vector<graphOverlay> CRollingStatistics::getMovingAverageOverlays() const
+{
+    std::vector<graphOverlay> overlays;
+
+    for (const rollingWindow& window : windows)
+    {
+        if (window.m_mean.empty()) {
+            continue;
+        }
+
+        graphOverlay overlay;
+        overlay.m_name = QString("%1-day moving average").arg(window.m_windowSize);
+        overlay.m_firstIndex = window.m_windowSize - 1;
+        overlay.m_values = window.m_mean;
+        overlays.push_back(std::move(overlay));
+    }
+
+    return overlays;
+}
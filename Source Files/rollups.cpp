@@ -0,0 +1,219 @@
+#include "../Header Files/rollups.h"
+#include <algorithm>
+
+
+// Used to get the aggregates of a column within the bucket.
+const CWeatherRollups::columnAggregate& CWeatherRollups::rollupBucket::getColumn(WeatherColumn column) const
+{
+    return m_columns[static_cast<int>(column) - 1];
+}
+
+
+// Used to get the mean of a column within the bucket.
+double CWeatherRollups::rollupBucket::getMean(WeatherColumn column) const
+{
+    return m_count == 0 ? 0 : static_cast<double>(getColumn(column).m_sum) / m_count;
+}
+
+
+// Default constructor (no buckets).
+CWeatherRollups::CWeatherRollups()
+{}
+
+
+// Builds the buckets of all periods in one pass over the days.
+CWeatherRollups::CWeatherRollups(const WeatherView& weather)
+{
+    for (int i = 0; i < weather.getWeatherSize(); ++i) {
+        addDay(weather.at(i));
+    }
+}
+
+
+// Adds one day to the buckets of all periods.
+void CWeatherRollups::addDay(const CWather::weatherData& wData)
+{
+    QDate date(wData.m_year, wData.m_month, wData.m_day);
+    if (!date.isValid()) {
+        return;
+    }
+
+    const std::array<int, COLUMN_CNT> values = {
+        wData.m_temperature, static_cast<int>(wData.m_pressure), wData.m_humidity
+    };
+
+    for (int period = 0; period < ROLLUP_PERIOD_CNT; ++period)
+    {
+        std::vector<rollupBucket>& periodBuckets = buckets[period];
+        std::pair<int, int> key = getBucketKey(static_cast<RollupPeriod>(period), date);
+
+        // Days usually come in date order, so the last bucket is checked before searching.
+        auto bucketIt = periodBuckets.end();
+        if (!periodBuckets.empty() && !(std::make_pair(periodBuckets.back().m_year, periodBuckets.back().m_number) < key)) {
+            bucketIt = std::lower_bound(periodBuckets.begin(), periodBuckets.end(), key,
+                [](const rollupBucket& bucket, const std::pair<int, int>& key) {
+                    return std::make_pair(bucket.m_year, bucket.m_number) < key;
+                });
+        }
+
+        // Create a bucket for a period that had no days yet.
+        if (bucketIt == periodBuckets.end() || bucketIt->m_year != key.first || bucketIt->m_number != key.second) {
+            rollupBucket newBucket;
+            newBucket.m_year = key.first;
+            newBucket.m_number = key.second;
+            bucketIt = periodBuckets.insert(bucketIt, newBucket);
+
+            if (period == MonthRollup) {
+                monthHistograms.insert(monthHistograms.begin() + (bucketIt - periodBuckets.begin()),
+                                       std::array<CValueHistogram, COLUMN_CNT>());
+            }
+        }
+
+        if (period == MonthRollup) {
+            std::array<CValueHistogram, COLUMN_CNT>& histograms = monthHistograms[bucketIt - periodBuckets.begin()];
+            for (int column = 0; column < COLUMN_CNT; ++column) {
+                histograms[column].add(values[column]);
+            }
+        }
+
+        // Add the day to the aggregates of every column.
+        for (int column = 0; column < COLUMN_CNT; ++column)
+        {
+            columnAggregate& aggregate = bucketIt->m_columns[column];
+
+            if (bucketIt->m_count == 0) {
+                aggregate.m_min = values[column];
+                aggregate.m_max = values[column];
+            } else {
+                aggregate.m_min = std::min(aggregate.m_min, values[column]);
+                aggregate.m_max = std::max(aggregate.m_max, values[column]);
+            }
+
+            aggregate.m_sum += values[column];
+        }
+
+        bucketIt->m_count++;
+    }
+}
+
+
+// Used to get the buckets of a period.
+const std::vector<CWeatherRollups::rollupBucket>& CWeatherRollups::getBuckets(RollupPeriod period) const
+{
+    return buckets[period];
+}
+
+
+// Used to find the bucket a certain date belongs to.
+const CWeatherRollups::rollupBucket* CWeatherRollups::findBucket(RollupPeriod period, QDate date) const
+{
+    if (!date.isValid()) {
+        return nullptr;
+    }
+
+    const std::vector<rollupBucket>& periodBuckets = buckets[period];
+    std::pair<int, int> key = getBucketKey(period, date);
+
+    auto bucketIt = std::lower_bound(periodBuckets.begin(), periodBuckets.end(), key,
+        [](const rollupBucket& bucket, const std::pair<int, int>& key) {
+            return std::make_pair(bucket.m_year, bucket.m_number) < key;
+        });
+
+    if (bucketIt == periodBuckets.end() || bucketIt->m_year != key.first || bucketIt->m_number != key.second) {
+        return nullptr;
+    }
+
+    return &*bucketIt;
+}
+
+
+// Returns a text label of a bucket.
+QString CWeatherRollups::getBucketLabel(RollupPeriod period, const rollupBucket& bucket)
+{
+    switch (period) {
+    case WeekRollup:
+        return QString::asprintf("%d-W%02d", bucket.m_year, bucket.m_number);
+    case MonthRollup:
+        return QString::asprintf("%02d.%d", bucket.m_number, bucket.m_year);
+    case SeasonRollup:
+        switch (static_cast<Season>(bucket.m_number)) {
+        case Winter:
+            return QString::asprintf("Winter %d/%02d", bucket.m_year - 1, bucket.m_year % 100);
+        case Spring:
+            return QString::asprintf("Spring %d", bucket.m_year);
+        case Summer:
+            return QString::asprintf("Summer %d", bucket.m_year);
+        default:
+            return QString::asprintf("Autumn %d", bucket.m_year);
+        }
+    default:
+        return QString::number(bucket.m_year);
+    }
+}
+
+
+// Used to get the histogram of a column over a range of months.
+CValueHistogram CWeatherRollups::getHistogram(WeatherColumn column, QDate firstMonth, QDate lastMonth) const
+{
+    CValueHistogram histogram;
+
+    if (!firstMonth.isValid() || !lastMonth.isValid()) {
+        return histogram;
+    }
+
+    const std::vector<rollupBucket>& months = buckets[MonthRollup];
+    std::pair<int, int> firstKey = getBucketKey(MonthRollup, firstMonth);
+    std::pair<int, int> lastKey = getBucketKey(MonthRollup, lastMonth);
+
+    // Merge the histograms of the months from the first one up to the last one.
+    auto monthIt = std::lower_bound(months.begin(), months.end(), firstKey,
+        [](const rollupBucket& bucket, const std::pair<int, int>& key) {
+            return std::make_pair(bucket.m_year, bucket.m_number) < key;
+        });
+
+    for (; monthIt != months.end() && !(lastKey < std::make_pair(monthIt->m_year, monthIt->m_number)); ++monthIt) {
+        histogram += monthHistograms[monthIt - months.begin()][static_cast<int>(column) - 1];
+    }
+
+    return histogram;
+}
+
+
+// Used to get the histogram of a column within a month, season or year bucket.
+CValueHistogram CWeatherRollups::getBucketHistogram(RollupPeriod period, const rollupBucket& bucket, WeatherColumn column) const
+{
+    switch (period) {
+    case MonthRollup:
+        return getHistogram(column, QDate(bucket.m_year, bucket.m_number, 1), QDate(bucket.m_year, bucket.m_number, 1));
+    case SeasonRollup: {
+        // A season is three months; the winter starts in December of the previous year.
+        QDate firstMonth = bucket.m_number == Winter ? QDate(bucket.m_year - 1, 12, 1) : QDate(bucket.m_year, bucket.m_number * 3 - 3, 1);
+        QDate lastMonth = QDate(bucket.m_year, bucket.m_number * 3 - 1, 1);
+        return getHistogram(column, firstMonth, lastMonth);
+    }
+    case YearRollup:
+        return getHistogram(column, QDate(bucket.m_year, 1, 1), QDate(bucket.m_year, 12, 1));
+    default:
+        return CValueHistogram();
+    }
+}
+
+
+// Used to get the year and number of the period a date belongs to.
+std::pair<int, int> CWeatherRollups::getBucketKey(RollupPeriod period, QDate date)
+{
+    switch (period) {
+    case WeekRollup: {
+        int weekYear;
+        int week = date.weekNumber(&weekYear);
+        return {weekYear, week};
+    }
+    case MonthRollup:
+        return {date.year(), date.month()};
+    case SeasonRollup:
+        // December opens the winter that continues in January and February of the next year.
+        return {date.month() == 12 ? date.year() + 1 : date.year(), static_cast<int>(getSeason(date.month()))};
+    default:
+        return {date.year(), 0};
+    }
+}
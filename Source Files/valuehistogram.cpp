@@ -0,0 +1,142 @@
+#include "../Header Files/valuehistogram.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+
+// Default constructor (empty histogram).
+CValueHistogram::CValueHistogram() : firstValue(0), totalCount(0)
+{}
+
+
+// Adds values to the histogram.
+void CValueHistogram::add(int value, int count)
+{
+    if (counts.empty()) {
+        firstValue = value;
+        counts.assign(1, 0);
+    }
+
+    // The range the counters would cover with the value (in 64 bits, so distant values do not overflow).
+    long long lastValue = static_cast<long long>(firstValue) + static_cast<long long>(counts.size()) - 1;
+    long long rangeFirst = std::min<long long>(firstValue, value), rangeLast = std::max<long long>(lastValue, value);
+
+    if (rangeLast - rangeFirst + 1 > MAX_DENSE_RANGE)
+    {
+        // The value is counted on its own.
+        auto outlier = std::lower_bound(outliers.begin(), outliers.end(), std::make_pair(value, INT_MIN));
+        if (outlier == outliers.end() || outlier->first != value) {
+            outlier = outliers.insert(outlier, {value, 0});
+        }
+
+        outlier->second += count;
+        totalCount += count;
+        return;
+    }
+
+    // Extend the counters to cover the value.
+    if (value < firstValue) {
+        counts.insert(counts.begin(), firstValue - value, 0);
+        firstValue = value;
+    }
+    else if (value > lastValue) {
+        counts.resize(static_cast<size_t>(value - firstValue) + 1, 0);
+    }
+
+    counts[value - firstValue] += count;
+    totalCount += count;
+}
+
+
+// Adds the counters of another histogram to this one.
+CValueHistogram& CValueHistogram::operator+=(const CValueHistogram& other)
+{
+    if (!other.counts.empty())
+    {
+        // The range the counters would cover with the other histogram (in 64 bits, as in add).
+        long long otherLast = static_cast<long long>(other.firstValue) + static_cast<long long>(other.counts.size()) - 1;
+        long long rangeFirst = other.firstValue, rangeLast = otherLast;
+        if (!counts.empty()) {
+            rangeFirst = std::min(firstValue, other.firstValue);
+            rangeLast = std::max(static_cast<long long>(firstValue) + static_cast<long long>(counts.size()) - 1, otherLast);
+        }
+
+        if (rangeLast - rangeFirst + 1 <= MAX_DENSE_RANGE)
+        {
+            // Make room for the whole range of the other histogram first, so its counters are added in one pass.
+            add(other.firstValue, 0);
+            add(static_cast<int>(otherLast), 0);
+
+            int shift = other.firstValue - firstValue;
+            for (int i = 0; i < static_cast<int>(other.counts.size()); ++i) {
+                counts[shift + i] += other.counts[i];
+                totalCount += other.counts[i];
+            }
+        }
+        else
+        {
+            // The ranges are too far apart to be covered by one array of counters.
+            for (int i = 0; i < static_cast<int>(other.counts.size()); ++i) {
+                if (other.counts[i] != 0) {
+                    add(other.firstValue + i, other.counts[i]);
+                }
+            }
+        }
+    }
+
+    for (const std::pair<int, int>& outlier : other.outliers) {
+        add(outlier.first, outlier.second);
+    }
+
+    return *this;
+}
+
+
+// Used to get the number of added values.
+int CValueHistogram::getCount() const
+{
+    return totalCount;
+}
+
+
+// Used to get a percentile of the added values.
+int CValueHistogram::getPercentile(double percent) const
+{
+    if (totalCount == 0) {
+        return 0;
+    }
+
+    // The rank of the percentile among the sorted values (1 - totalCount).
+    long long rank = static_cast<long long>(std::ceil(percent * totalCount / 100.0));
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    // The outliers lie below or above the range of the counters, so the values are visited in order.
+    long long cumulative = 0;
+    auto outlier = outliers.begin();
+
+    for (; outlier != outliers.end() && outlier->first < firstValue; ++outlier) {
+        cumulative += outlier->second;
+        if (cumulative >= rank) {
+            return outlier->first;
+        }
+    }
+
+    for (int i = 0; i < static_cast<int>(counts.size()); ++i) {
+        cumulative += counts[i];
+        if (cumulative >= rank) {
+            return firstValue + i;
+        }
+    }
+
+    for (; outlier != outliers.end(); ++outlier) {
+        cumulative += outlier->second;
+        if (cumulative >= rank) {
+            return outlier->first;
+        }
+    }
+
+    return outliers.empty() || outliers.back().first < firstValue ? firstValue + static_cast<int>(counts.size()) - 1
+                                                                  : outliers.back().first;
+}
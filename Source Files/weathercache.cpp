@@ -0,0 +1,445 @@
+#include "../Header Files/weathercache.h"
+#include "../Header Files/forecastengine.h"
+#include <QDir>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtEndian>
+#include <cstring>
+#include <type_traits>
+
+
+// The first bytes of a cache file.
+static const char CACHE_SIGNATURE[] = "WTHRCCH2";
+static const int CACHE_SIGNATURE_SIZE = 8;
+
+// Sizes of the stored structs (a cache written by a build with another memory layout is ignored).
+static const quint64 CACHE_LAYOUT = sizeof(CWather::weatherData) | sizeof(CWeatherRollups::rollupBucket) << 16
+                                    | static_cast<quint64>(sizeof(CForecastEngine::dayClimate)) << 32;
+
+// Primes of XXH64.
+static const quint64 PRIME64_1 = 0x9E3779B185EBCA87ull;
+static const quint64 PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+static const quint64 PRIME64_3 = 0x165667B19E3779F9ull;
+static const quint64 PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+static const quint64 PRIME64_5 = 0x27D4EB2F165667C5ull;
+
+
+// Rotates the bits of a value to the left.
+static quint64 rotateLeft(quint64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+
+// Mixes 8 bytes of input into an accumulator of XXH64.
+static quint64 hashRound(quint64 accumulator, quint64 input)
+{
+    accumulator += input * PRIME64_2;
+    return rotateLeft(accumulator, 31) * PRIME64_1;
+}
+
+
+// Merges an accumulator of XXH64 into the hash.
+static quint64 mergeRound(quint64 hash, quint64 accumulator)
+{
+    hash ^= hashRound(0, accumulator);
+    return hash * PRIME64_1 + PRIME64_4;
+}
+
+
+// Appends values to the content of a cache file.
+template <typename T>
+static void appendValues(QByteArray& data, const T* values, qint64 count)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Only plain values are stored in the cache.");
+    data.append(reinterpret_cast<const char*>(values), count * sizeof(T));
+}
+
+
+// Appends the size and the values of a vector to the content of a cache file.
+template <typename T>
+static void appendVector(QByteArray& data, const std::vector<T>& values)
+{
+    qint64 count = values.size();
+    appendValues(data, &count, 1);
+    appendValues(data, values.data(), count);
+}
+
+
+// Copies values out of the mapped cache file and moves the position after them.
+template <typename T>
+static void readValues(const uchar*& position, const uchar* end, T* values, qint64 count)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Only plain values are stored in the cache.");
+
+    if (count < 0 || count > (end - position) / static_cast<qint64>(sizeof(T))) {
+        throw QString("The cache file is damaged.");
+    }
+
+    if (count > 0) {
+        memcpy(values, position, count * sizeof(T));
+        position += count * sizeof(T);
+    }
+}
+
+
+// Reads a value from the mapped cache file.
+template <typename T>
+static T readValue(const uchar*& position, const uchar* end)
+{
+    T value;
+    readValues(position, end, &value, 1);
+    return value;
+}
+
+
+// Reads a vector written by appendVector() from the mapped cache file.
+template <typename T>
+static void readVector(const uchar*& position, const uchar* end, std::vector<T>& values)
+{
+    qint64 count = readValue<qint64>(position, end);
+
+    // The size is checked before the vector is allocated.
+    if (count < 0 || count > (end - position) / static_cast<qint64>(sizeof(T))) {
+        throw QString("The cache file is damaged.");
+    }
+
+    values.resize(count);
+    readValues(position, end, values.data(), count);
+}
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// Default constructor
+CWeatherCache::CWeatherCache() : contentHash(0), fileSize(-1)
+{}
+
+
+// Constructor with parameters.
+CWeatherCache::CWeatherCache(const QString& fileName) : contentHash(0), fileSize(-1)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw QString("File could not be opened.");
+    }
+
+    // The file is hashed where it is mapped (an empty file cannot be mapped; a file that cannot be mapped is read).
+    qint64 size = file.size();
+    const uchar* data = size > 0 ? file.map(0, size) : nullptr;
+
+    if (data != nullptr || size == 0) {
+        contentHash = hash(data, size);
+    }
+    else {
+        QByteArray content = file.readAll();
+        if (content.size() != size) {
+            throw QString("File could not be read.");
+        }
+        contentHash = hash(reinterpret_cast<const uchar*>(content.constData()), size);
+    }
+
+    fileSize = size;
+}
+
+
+// Reads the dataset of the file from the cache.
+bool CWeatherCache::load(CWeatherDataset& dataset) const
+{
+    if (fileSize < 0) {
+        return false;
+    }
+
+    QFile file(getCacheFileName());
+    if (!file.open(QIODevice::ReadOnly) || file.size() < CACHE_SIGNATURE_SIZE) {
+        return false;
+    }
+
+    // The values are copied straight out of the mapped file (it is unmapped when the file is closed).
+    const uchar* data = file.map(0, file.size());
+    if (data == nullptr) {
+        return false;
+    }
+
+    const uchar* position = data + CACHE_SIGNATURE_SIZE;
+    const uchar* end = data + file.size();
+
+    try {
+        if (memcmp(data, CACHE_SIGNATURE, CACHE_SIGNATURE_SIZE) != 0 || readValue<quint64>(position, end) != CACHE_LAYOUT
+            || readValue<quint64>(position, end) != contentHash || readValue<qint64>(position, end) != fileSize) {
+            return false;
+        }
+
+        qint64 stationCount = readValue<qint64>(position, end);
+        if (stationCount < 1 || stationCount > end - position) {
+            return false;
+        }
+
+        std::vector<CWeatherDataset::station> stations(stationCount);
+
+        for (CWeatherDataset::station& stationData : stations)
+        {
+            std::vector<char> id;
+            readVector(position, end, id);
+
+            stationData.m_id = QString::fromUtf8(id.data(), id.size());
+            stationData.m_weather = readWeather(position, end);
+        }
+
+        if (position != end) {
+            return false;
+        }
+
+        dataset = CWeatherDataset(std::move(stations));
+    } catch (const QString&) {
+        return false;
+    }
+
+    return true;
+}
+
+
+// Writes the dataset of the file to the cache.
+void CWeatherCache::save(const CWeatherDataset& dataset) const
+{
+    if (fileSize < 0) {
+        return;
+    }
+
+    // The stations are written in parallel (building their derived data is most of the work).
+    std::vector<QByteArray> stationData = dataset.mapStations([](const CWather& weather) {
+        QByteArray data;
+        appendWeather(weather, data);
+        return data;
+    });
+
+    QByteArray data(CACHE_SIGNATURE, CACHE_SIGNATURE_SIZE);
+    qint64 stationCount = dataset.getStationCount();
+
+    appendValues(data, &CACHE_LAYOUT, 1);
+    appendValues(data, &contentHash, 1);
+    appendValues(data, &fileSize, 1);
+    appendValues(data, &stationCount, 1);
+
+    for (int i = 0; i < stationCount; ++i)
+    {
+        QByteArray id = dataset.getStation(i).m_id.toUtf8();
+        qint64 idSize = id.size();
+
+        appendValues(data, &idSize, 1);
+        data.append(id);
+        data.append(stationData[i]);
+    }
+
+    // A cache file is never left half written (a reader would only miss it, but it would take the place of a good one).
+    QDir().mkpath(getCacheDirectory());
+    QSaveFile file(getCacheFileName());
+
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        throw QString("The cache file could not be written: %1").arg(file.errorString());
+    }
+
+    removeOldFiles();
+}
+
+
+// Writes the dataset of the file to the cache in a background thread.
+QFuture<void> CWeatherCache::saveInBackground(const CWeatherDataset& dataset) const
+{
+    return QtConcurrent::run([cache = *this, snapshot = dataset]() {
+        try {
+            cache.save(snapshot);
+        } catch (const QString&) {
+            // The file is read again the next time it is opened.
+        }
+    });
+}
+
+
+// Used to get the size of the file when its hash was computed.
+qint64 CWeatherCache::getFileSize() const
+{
+    return fileSize;
+}
+
+
+// Used to get the directory of the cache files.
+QString CWeatherCache::getCacheDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/datasets";
+}
+
+
+// Computes the 64-bit xxHash (XXH64) of data.
+quint64 CWeatherCache::hash(const uchar* data, qint64 size, quint64 seed)
+{
+    const uchar* position = data;
+    const uchar* end = data + size;
+    quint64 result;
+
+    if (size >= 32)
+    {
+        // Four independent lanes of 8 bytes each.
+        quint64 lane1 = seed + PRIME64_1 + PRIME64_2, lane2 = seed + PRIME64_2, lane3 = seed, lane4 = seed - PRIME64_1;
+
+        do {
+            lane1 = hashRound(lane1, qFromLittleEndian<quint64>(position));
+            lane2 = hashRound(lane2, qFromLittleEndian<quint64>(position + 8));
+            lane3 = hashRound(lane3, qFromLittleEndian<quint64>(position + 16));
+            lane4 = hashRound(lane4, qFromLittleEndian<quint64>(position + 24));
+            position += 32;
+        } while (end - position >= 32);
+
+        result = rotateLeft(lane1, 1) + rotateLeft(lane2, 7) + rotateLeft(lane3, 12) + rotateLeft(lane4, 18);
+        result = mergeRound(result, lane1);
+        result = mergeRound(result, lane2);
+        result = mergeRound(result, lane3);
+        result = mergeRound(result, lane4);
+    }
+    else {
+        result = seed + PRIME64_5;
+    }
+
+    result += static_cast<quint64>(size);
+
+    // The last bytes (fewer than 32).
+    for (; end - position >= 8; position += 8) {
+        result ^= hashRound(0, qFromLittleEndian<quint64>(position));
+        result = rotateLeft(result, 27) * PRIME64_1 + PRIME64_4;
+    }
+
+    if (end - position >= 4) {
+        result ^= static_cast<quint64>(qFromLittleEndian<quint32>(position)) * PRIME64_1;
+        result = rotateLeft(result, 23) * PRIME64_2 + PRIME64_3;
+        position += 4;
+    }
+
+    for (; position != end; ++position) {
+        result ^= *position * PRIME64_5;
+        result = rotateLeft(result, 11) * PRIME64_1;
+    }
+
+    // Final mix of the bits.
+    result ^= result >> 33;
+    result *= PRIME64_2;
+    result ^= result >> 29;
+    result *= PRIME64_3;
+    result ^= result >> 32;
+
+    return result;
+}
+
+
+// Used to get the name of the cache file of the content.
+QString CWeatherCache::getCacheFileName() const
+{
+    return getCacheDirectory() + QString("/%1.wcache").arg(contentHash, 16, 16, QChar('0'));
+}
+
+
+// Writes the days of a station and the data derived from them.
+void CWeatherCache::appendWeather(const CWather& weather, QByteArray& data)
+{
+    // Build the derived data that is not cached yet.
+    std::shared_ptr<const CWeatherRollups> rollups = weather.getRollups();
+    std::shared_ptr<const CForecastEngine> forecastEngine = weather.getForecastEngine();
+    std::shared_ptr<const std::vector<CWather::dayRun>> windRuns = weather.getWindRuns();
+    std::shared_ptr<const std::vector<CWather::dayRun>> stablePeriods = weather.getStablePeriods();
+
+    appendVector(data, weather.d->weatherArr);
+
+    for (const std::vector<CWeatherRollups::rollupBucket>& buckets : rollups->buckets) {
+        appendVector(data, buckets);
+    }
+
+    for (const std::array<CValueHistogram, CWeatherRollups::COLUMN_CNT>& monthHistograms : rollups->monthHistograms) {
+        for (const CValueHistogram& histogram : monthHistograms) {
+            appendValues(data, &histogram.firstValue, 1);
+            appendValues(data, &histogram.totalCount, 1);
+            appendVector(data, histogram.counts);
+
+            // The outliers are stored as pairs of ints (a value and its count).
+            std::vector<int> outliers;
+            for (const std::pair<int, int>& outlier : histogram.outliers) {
+                outliers.push_back(outlier.first);
+                outliers.push_back(outlier.second);
+            }
+            appendVector(data, outliers);
+        }
+    }
+
+    appendVector(data, forecastEngine->climate);
+    appendVector(data, *windRuns);
+    appendVector(data, *stablePeriods);
+}
+
+
+// Reads the days of a station and the data derived from them.
+CWather CWeatherCache::readWeather(const uchar*& position, const uchar* end)
+{
+    CWather weather;
+    CWather::WeatherStorage& storage = *weather.d;
+    readVector(position, end, storage.weatherArr);
+
+    auto rollups = std::make_shared<CWeatherRollups>();
+    for (std::vector<CWeatherRollups::rollupBucket>& buckets : rollups->buckets) {
+        readVector(position, end, buckets);
+    }
+
+    // Every month bucket has its histograms.
+    rollups->monthHistograms.resize(rollups->buckets[MonthRollup].size());
+    for (std::array<CValueHistogram, CWeatherRollups::COLUMN_CNT>& monthHistograms : rollups->monthHistograms) {
+        for (CValueHistogram& histogram : monthHistograms) {
+            histogram.firstValue = readValue<int>(position, end);
+            histogram.totalCount = readValue<int>(position, end);
+            readVector(position, end, histogram.counts);
+
+            std::vector<int> outliers;
+            readVector(position, end, outliers);
+            if (outliers.size() % 2 != 0) {
+                throw QString("The cache file is damaged.");
+            }
+
+            histogram.outliers.clear();
+            for (size_t i = 0; i < outliers.size(); i += 2) {
+                histogram.outliers.emplace_back(outliers[i], outliers[i + 1]);
+            }
+        }
+    }
+
+    auto forecastEngine = std::make_shared<CForecastEngine>();
+    readVector(position, end, forecastEngine->climate);
+
+    auto windRuns = std::make_shared<std::vector<CWather::dayRun>>();
+    auto stablePeriods = std::make_shared<std::vector<CWather::dayRun>>();
+    readVector(position, end, *windRuns);
+    readVector(position, end, *stablePeriods);
+
+    // The runs are turned into views of the days, so they must lie within them.
+    for (const std::vector<CWather::dayRun>* runs : {windRuns.get(), stablePeriods.get()}) {
+        for (const CWather::dayRun& run : *runs) {
+            if (run.m_firstIndex < 0 || run.m_dayCount < 1 || run.m_dayCount > static_cast<qint64>(storage.weatherArr.size()) - run.m_firstIndex) {
+                throw QString("The cache file is damaged.");
+            }
+        }
+    }
+
+    storage.rollups = rollups;
+    storage.forecastEngine = forecastEngine;
+    storage.windRuns = windRuns;
+    storage.stablePeriods = stablePeriods;
+
+    return weather;
+}
+
+
+// Removes the least recently written cache files above MAX_FILE_COUNT.
+void CWeatherCache::removeOldFiles()
+{
+    QFileInfoList files = QDir(getCacheDirectory()).entryInfoList({"*.wcache"}, QDir::Files, QDir::Time);
+
+    for (int i = MAX_FILE_COUNT; i < files.size(); ++i) {
+        QFile::remove(files[i].filePath());
+    }
+}
@@ -0,0 +1,370 @@
+#include "../Header Files/weatherdataset.h"
+#include "../Header Files/fusedanalysis.h"
+#include "../Header Files/forecastengine.h"
+#include "../Header Files/weatherstream.h"
+
+
+// Used to get the average temperature (rounded to two decimal places).
+double CWeatherDataset::stationSummary::getAvgTemperature() const
+{
+    return m_dayCount == 0 ? 0 : roundToHundredths(static_cast<double>(m_temperatureSum) / m_dayCount);
+}
+
+
+// Used to get the average pressure (rounded to two decimal places).
+double CWeatherDataset::stationSummary::getAvgPressure() const
+{
+    return m_dayCount == 0 ? 0 : roundToHundredths(static_cast<double>(m_pressureSum) / m_dayCount);
+}
+
+
+// Default constructor (one unnamed station without data).
+CWeatherDataset::CWeatherDataset() : stations(1)
+{}
+
+
+// Constructor that takes over already read stations.
+CWeatherDataset::CWeatherDataset(std::vector<station> stations) : stations(std::move(stations))
+{
+    if (this->stations.empty()) {
+        this->stations.emplace_back();
+    }
+}
+
+
+// Used to get the number of stations.
+int CWeatherDataset::getStationCount() const
+{
+    return stations.size();
+}
+
+
+// Used to get a station.
+const CWeatherDataset::station& CWeatherDataset::getStation(int index) const
+{
+    return stations[index];
+}
+
+
+// Used to find a station by its identifier.
+int CWeatherDataset::findStation(const QString& stationId) const
+{
+    for (int i = 0; i < stations.size(); ++i) {
+        if (stations[i].m_id == stationId) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+
+// Adds a station without data to the end of the dataset.
+int CWeatherDataset::addStation(const QString& stationId)
+{
+    if (stationId.trimmed().isEmpty()) {
+        throw QString("The station identifier cannot be empty.");
+    }
+
+    if (stationId.contains("\n") || stationId.contains("\r")) {
+        throw QString("The station identifier must be one line of text.");
+    }
+
+    if (findStation(stationId.trimmed()) != -1) {
+        throw QString("There is already a station \"%1\".").arg(stationId.trimmed());
+    }
+
+    station newStation;
+    newStation.m_id = stationId.trimmed();
+    stations.push_back(newStation);
+
+    return stations.size() - 1;
+}
+
+
+// Replaces the weather data of a station (constant time, the data is shared).
+void CWeatherDataset::setStationWeather(int index, const CWather& weather)
+{
+    stations[index].m_weather = weather;
+}
+
+
+// Adds days to the end of the weather data of a station.
+void CWeatherDataset::appendStationDays(int index, const std::vector<CWather::weatherData>& days)
+{
+    stations[index].m_weather.appendDays(days);
+}
+
+
+// Runs the analyses of one station.
+CWeatherDataset::stationSummary CWeatherDataset::summarizeStation(const CWather& weather)
+{
+    // Sums, extremes, the date range and the period analyses of the main window in one pass.
+    CFusedAnalysis analysis(CFusedAnalysis::AllAnalyses);
+    analysis.run(weather.getView());
+
+    stationSummary summary;
+    summary.m_dayCount = analysis.getDayCount();
+    summary.m_stationCount = 1;
+    summary.m_temperatureSum = analysis.getTemperatureSum();
+    summary.m_pressureSum = analysis.getPressureSum();
+    summary.m_maxHumidity = analysis.getMaxHumidity();
+    summary.m_maxHumidityDayCount = analysis.getMaxHumidityDayCount();
+    summary.m_firstDate = analysis.getFirstDate();
+    summary.m_lastDate = analysis.getLastDate();
+    summary.m_windNotChangePeriodCount = analysis.getWindRuns().size();
+    summary.m_stablePeriodCount = analysis.getStablePeriods().size();
+
+    return summary;
+}
+
+
+// Runs the analyses of every station in parallel.
+std::vector<CWeatherDataset::stationSummary> CWeatherDataset::getStationSummaries() const
+{
+    std::vector<stationSummary> summaries = mapStations(&CWeatherDataset::summarizeStation);
+
+    for (int i = 0; i < summaries.size(); ++i) {
+        summaries[i].m_stationId = stations[i].m_id;
+    }
+
+    return summaries;
+}
+
+
+// Merges summaries of several stations into a network summary.
+CWeatherDataset::stationSummary CWeatherDataset::mergeSummaries(const std::vector<stationSummary>& summaries, const QString& networkId)
+{
+    stationSummary network;
+    network.m_stationId = networkId;
+
+    for (const stationSummary& summary : summaries)
+    {
+        if (summary.m_dayCount == 0) {
+            continue;
+        }
+
+        // The highest humidity of the network and the number of days it was observed at any station.
+        if (network.m_dayCount == 0 || summary.m_maxHumidity > network.m_maxHumidity) {
+            network.m_maxHumidity = summary.m_maxHumidity;
+            network.m_maxHumidityDayCount = 0;
+        }
+        if (summary.m_maxHumidity == network.m_maxHumidity) {
+            network.m_maxHumidityDayCount += summary.m_maxHumidityDayCount;
+        }
+
+        if (summary.m_firstDate.isValid() && (!network.m_firstDate.isValid() || summary.m_firstDate < network.m_firstDate)) {
+            network.m_firstDate = summary.m_firstDate;
+        }
+        if (summary.m_lastDate.isValid() && (!network.m_lastDate.isValid() || summary.m_lastDate > network.m_lastDate)) {
+            network.m_lastDate = summary.m_lastDate;
+        }
+
+        network.m_dayCount += summary.m_dayCount;
+        network.m_stationCount += summary.m_stationCount;
+        network.m_temperatureSum += summary.m_temperatureSum;
+        network.m_pressureSum += summary.m_pressureSum;
+        network.m_windNotChangePeriodCount += summary.m_windNotChangePeriodCount;
+        network.m_stablePeriodCount += summary.m_stablePeriodCount;
+    }
+
+    return network;
+}
+
+
+// Used to get the histogram of a column over a range of months.
+CValueHistogram CWeatherDataset::getHistogram(int stationIndex, WeatherColumn column, QDate firstMonth, QDate lastMonth) const
+{
+    CValueHistogram histogram;
+
+    for (int i = 0; i < stations.size(); ++i) {
+        if (stationIndex == -1 || stationIndex == i) {
+            histogram += stations[i].m_weather.getRollups()->getHistogram(column, firstMonth, lastMonth);
+        }
+    }
+
+    return histogram;
+}
+
+
+// Within a season (3 months), sort the records of every station by Pressure (stations are sorted in parallel).
+void CWeatherDataset::sortPressureBySeason()
+{
+    QtConcurrent::blockingMap(stations, [](station& stationData) {
+        stationData.m_weather.sortPressureBySeason();
+    });
+}
+
+
+// Forecasts the weather for the next month of every station and adds it to its data (stations are forecasted in parallel).
+void CWeatherDataset::forecastWeatherForNextMonth(quint64 seed)
+{
+    std::vector<int> indexes(stations.size());
+    std::iota(indexes.begin(), indexes.end(), 0);
+
+    QtConcurrent::blockingMap(indexes, [this, seed](int index) {
+        stations[index].m_weather.forecastWeatherForNextMonth(CRandomStream(seed, index).next());
+    });
+}
+
+
+// Writes the dataset to a file in a background thread.
+QFuture<QString> CWeatherDataset::writeFileInBackground(const QString& fileName) const
+{
+    return QtConcurrent::run([snapshot = *this, fileName](QPromise<QString>& promise) {
+        // The progress is reported after every block of days.
+        const int progressStep = 1 << 16;
+
+        qint64 totalDayCount = 0;
+        for (const station& stationData : snapshot.stations) {
+            totalDayCount += stationData.m_weather.getWeatherSize();
+        }
+
+        promise.setProgressRange(0, 100);
+        promise.setProgressValue(0);
+
+        try {
+            CWeatherFileWriter writer(fileName, false);
+
+            // Station lines are written as the << operator writes them.
+            bool isStationFormat = snapshot.stations.size() > 1 || !snapshot.stations.front().m_id.isEmpty();
+
+            for (const station& stationData : snapshot.stations)
+            {
+                if (isStationFormat) {
+                    writer.writeStation(stationData.m_id);
+                }
+
+                WeatherView view = stationData.m_weather.getView();
+
+                for (int i = 0; i < view.getWeatherSize(); ++i)
+                {
+                    writer.writeDay(view.at(i));
+
+                    if (writer.getDayCount() % progressStep == 0) {
+                        promise.setProgressValue(static_cast<int>(writer.getDayCount() * 100 / totalDayCount));
+                    }
+                }
+            }
+
+            writer.close();
+        } catch (const QString& exception) {
+            promise.addResult(exception);
+            return;
+        }
+
+        promise.setProgressValue(100);
+        promise.addResult(QString());
+    });
+}
+
+
+// Reads a dataset from a file (with or without station lines).
+QTextStream& operator>>(QTextStream& inFile, CWeatherDataset& dataset)
+{
+    std::vector<CWeatherDataset::station> stations;
+    std::vector<std::vector<CWather::weatherData>> stationDays;
+    int lineNumber = 0;
+
+    // Reading data line by line until the end of the file is reached.
+    while (!inFile.atEnd())
+    {
+        QString line = inFile.readLine().trimmed();
+        lineNumber++;
+
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        // A station line starts a new station.
+        if (line.startsWith("station ") || line == "station") {
+            CWeatherDataset::station newStation;
+            newStation.m_id = line.mid(7).trimmed();
+
+            // The identifiers are checked as in addStation (only the first station can be the unnamed one).
+            if (newStation.m_id.isEmpty() && !stations.empty()) {
+                throw QString("Line %1: the station identifier cannot be empty.").arg(lineNumber);
+            }
+
+            for (const CWeatherDataset::station& other : stations) {
+                if (other.m_id == newStation.m_id) {
+                    throw QString("Line %1: there is already a station \"%2\".").arg(lineNumber).arg(newStation.m_id);
+                }
+            }
+
+            stations.push_back(newStation);
+            stationDays.emplace_back();
+            continue;
+        }
+
+        // Days before the first station line belong to an unnamed station.
+        if (stations.empty()) {
+            stations.emplace_back();
+            stationDays.emplace_back();
+        }
+
+        QStringList values = line.simplified().split(' ');
+        if (values.size() != 7) {
+            throw QString("Line %1: expected 7 values (year month day t pressure humidity wind direction), found %2.")
+                .arg(lineNumber).arg(values.size());
+        }
+
+        // Converting the read values to a weatherData object (every number must be read, as the other readers require).
+        bool isOk[6];
+        CWather::weatherData wData(values[0].toInt(&isOk[0]), static_cast<Month>(values[1].toInt(&isOk[1])),
+                                   values[2].toUInt(&isOk[2]), values[3].toInt(&isOk[3]), values[4].toUInt(&isOk[4]),
+                                   values[5].toInt(&isOk[5]), convertTextToWindDir(values[6]));
+
+        if (!(isOk[0] && isOk[1] && isOk[2] && isOk[3] && isOk[4] && isOk[5])) {
+            throw QString("Line %1: expected 7 values (year month day t pressure humidity wind direction).").arg(lineNumber);
+        }
+
+        stationDays.back().push_back(wData);
+    }
+
+    if (stations.empty()) {
+        stations.emplace_back();
+        stationDays.emplace_back();
+    }
+
+    // Build the weather series of the stations in parallel (with their rollups).
+    std::vector<int> indexes(stations.size());
+    std::iota(indexes.begin(), indexes.end(), 0);
+
+    QtConcurrent::blockingMap(indexes, [&stations, &stationDays](int index) {
+        stations[index].m_weather = CWather(std::move(stationDays[index]));
+    });
+
+    dataset.stations = std::move(stations);
+
+    return inFile;
+}
+
+
+// Writes a dataset to a file.
+QTextStream& operator<<(QTextStream& out, const CWeatherDataset& dataset)
+{
+    // One unnamed station is written in the single-station format.
+    bool isStationFormat = dataset.stations.size() > 1 || !dataset.stations.front().m_id.isEmpty();
+
+    for (int i = 0; i < dataset.stations.size(); ++i)
+    {
+        const CWeatherDataset::station& stationData = dataset.stations[i];
+
+        if (i != 0) {
+            out << "\n";
+        }
+
+        if (isStationFormat) {
+            out << "station " << stationData.m_id;
+
+            if (stationData.m_weather.getWeatherSize() != 0) {
+                out << "\n";
+            }
+        }
+
+        out << stationData.m_weather;
+    }
+
+    return out;
+}
@@ -0,0 +1,238 @@
+#include "../Header Files/weathergaps.h"
+#include "../Header Files/forecastengine.h"
+#include <algorithm>
+
+
+// Finds the gaps, duplicate dates and out of order days of the weather data.
+CWeatherGaps::CWeatherGaps(const WeatherView& weather)
+{
+    int size = weather.getWeatherSize();
+    if (size == 0) {
+        return;
+    }
+
+    // The date column as ordinal numbers (-1 for an invalid date).
+    std::vector<qint64> ordinals(size);
+    for (int i = 0; i < size; ++i) {
+        QDate date = weather.getDate(i);
+        ordinals[i] = date.isValid() ? date.toJulianDay() : -1;
+    }
+
+    // Steps between neighbouring days (-1 for a step from or to an invalid date, which breaks the order).
+    std::vector<qint64> steps(size, 0);
+    for (int i = 1; i < size; ++i) {
+        steps[i] = (ordinals[i] < 0 || ordinals[i - 1] < 0) ? -1 : ordinals[i] - ordinals[i - 1];
+    }
+
+    if (ordinals[0] < 0) {
+        outOfOrderIndexes.push_back(0);
+    }
+
+    // Every step other than one day ends a segment.
+    daySegment segment;
+
+    for (int i = 1; i < size; ++i)
+    {
+        if (steps[i] == 1) {
+            continue;
+        }
+
+        if (steps[i] > 1) {
+            gaps.push_back({i, static_cast<int>(steps[i] - 1)});
+        }
+        else if (steps[i] == 0) {
+            duplicateIndexes.push_back(i);
+        }
+        else {
+            outOfOrderIndexes.push_back(i);
+        }
+
+        segment.m_dayCount = i - segment.m_firstIndex;
+        segments.push_back(segment);
+        segment.m_firstIndex = i;
+    }
+
+    segment.m_dayCount = size - segment.m_firstIndex;
+    segments.push_back(segment);
+}
+
+
+// Used to get the runs of missing days.
+const std::vector<CWeatherGaps::dateGap>& CWeatherGaps::getGaps() const
+{
+    return gaps;
+}
+
+
+// Used to get the indexes of the days with the same date as the previous day.
+const std::vector<int>& CWeatherGaps::getDuplicateIndexes() const
+{
+    return duplicateIndexes;
+}
+
+
+// Used to get the indexes of the days with an earlier date than the previous day (or with an invalid date).
+const std::vector<int>& CWeatherGaps::getOutOfOrderIndexes() const
+{
+    return outOfOrderIndexes;
+}
+
+
+// Used to get the runs of consecutive days.
+const std::vector<CWeatherGaps::daySegment>& CWeatherGaps::getSegments() const
+{
+    return segments;
+}
+
+
+// Used to get the total number of missing days.
+int CWeatherGaps::getMissingDayCount() const
+{
+    int missingDayCount = 0;
+
+    for (const dateGap& gap : gaps) {
+        missingDayCount += gap.m_missingDayCount;
+    }
+
+    return missingDayCount;
+}
+
+
+// Determine if the days follow each other without gaps, duplicates and order breaks.
+bool CWeatherGaps::isContinuous() const
+{
+    return segments.size() <= 1 && outOfOrderIndexes.empty();
+}
+
+
+// Fills the gaps of weather data.
+CWeatherGaps::filledWeather CWeatherGaps::fillGaps(const WeatherView& weather, fillStrategy strategy)
+{
+    filledWeather result;
+
+    // Ordinal dates of the valid days with their indexes, in date order.
+    std::vector<std::pair<qint64, int>> days;
+    days.reserve(weather.getWeatherSize());
+
+    for (int i = 0; i < weather.getWeatherSize(); ++i) {
+        QDate date = weather.getDate(i);
+        if (date.isValid()) {
+            days.emplace_back(date.toJulianDay(), i);
+        }
+    }
+
+    if (days.empty()) {
+        return result;
+    }
+
+    if (!std::is_sorted(days.begin(), days.end())) {
+        std::stable_sort(days.begin(), days.end(), [](const std::pair<qint64, int>& a, const std::pair<qint64, int>& b) {
+            return a.first < b.first;
+        });
+    }
+
+    // Day i of the result is the date firstDate + i; the first day with each date is its source.
+    qint64 firstDate = days.front().first;
+    int dayCount = days.back().first - firstDate + 1;
+    std::vector<int>& sources = result.m_sourceIndexes;
+    sources.assign(dayCount, -1);
+
+    for (int i = days.size() - 1; i >= 0; --i) {
+        sources[days[i].first - firstDate] = days[i].second;
+    }
+
+    // The climatology is built only when it is needed.
+    CForecastEngine climatology;
+    if (strategy == ClimatologyFill) {
+        climatology = CForecastEngine(weather);
+    }
+
+    std::vector<QDate> dates(dayCount);
+    for (int i = 0; i < dayCount; ++i) {
+        dates[i] = QDate::fromJulianDay(firstDate + i);
+    }
+
+    // Fill the numeric columns one by one.
+    const WeatherColumn columns[] = {TemperatureColumn, PressureColumn, HumidityColumn};
+    std::vector<int> values[3];
+
+    for (int c = 0; c < 3; ++c)
+    {
+        std::vector<int>& column = values[c];
+        column.resize(dayCount);
+
+        for (int i = 0; i < dayCount; ++i) {
+            column[i] = sources[i] == -1 ? 0 : weather.getColumnValue(columns[c], sources[i]);
+        }
+
+        int previousKnown = 0;
+
+        for (int i = 1; i < dayCount; ++i)
+        {
+            if (sources[i] == -1)
+            {
+                if (strategy == PreviousValueFill) {
+                    column[i] = column[i - 1];
+                }
+                else if (strategy == ClimatologyFill) {
+                    const CForecastEngine::dayClimate& climate = climatology.getDayClimate(static_cast<Month>(dates[i].month()), dates[i].day());
+                    double mean = columns[c] == TemperatureColumn ? climate.m_temperatureMean
+                                  : columns[c] == PressureColumn ? climate.m_pressureMean : climate.m_humidityMean;
+                    column[i] = qRound(mean);
+                }
+                continue;
+            }
+
+            // Linear fill: the gap between two known days is filled once the day after it is reached.
+            if (strategy == LinearFill && i - previousKnown > 1) {
+                double step = static_cast<double>(column[i] - column[previousKnown]) / (i - previousKnown);
+                for (int k = previousKnown + 1; k < i; ++k) {
+                    column[k] = qRound(column[previousKnown] + step * (k - previousKnown));
+                }
+            }
+
+            previousKnown = i;
+        }
+    }
+
+    // Wind directions repeat the previous day, or are the most frequent direction of the climatology.
+    std::vector<WindDirection> winds(dayCount);
+
+    for (int i = 0; i < dayCount; ++i)
+    {
+        if (sources[i] != -1) {
+            winds[i] = weather.getWindDirection(sources[i]);
+        }
+        else if (strategy == ClimatologyFill) {
+            const CForecastEngine::dayClimate& climate = climatology.getDayClimate(static_cast<Month>(dates[i].month()), dates[i].day());
+            int mostFrequent = 0;
+            double previousCumulative = 0, highestShare = -1;
+
+            for (int w = 0; w < CForecastEngine::WIND_DIRECTION_CNT; ++w) {
+                if (climate.m_windCumulative[w] - previousCumulative > highestShare) {
+                    highestShare = climate.m_windCumulative[w] - previousCumulative;
+                    mostFrequent = w;
+                }
+                previousCumulative = climate.m_windCumulative[w];
+            }
+
+            winds[i] = static_cast<WindDirection>(mostFrequent + 1);
+        }
+        else {
+            winds[i] = winds[i - 1];
+        }
+    }
+
+    // Assemble the days from the filled columns.
+    std::vector<CWather::weatherData> weatherArr;
+    weatherArr.reserve(dayCount);
+
+    for (int i = 0; i < dayCount; ++i) {
+        weatherArr.emplace_back(dates[i].year(), static_cast<Month>(dates[i].month()), dates[i].day(), values[0][i],
+                                static_cast<unsigned>(values[1][i]), values[2][i], winds[i]);
+    }
+
+    result.m_weather = CWather(std::move(weatherArr));
+
+    return result;
+}
@@ -0,0 +1,214 @@
+#include "../Header Files/weatherjoin.h"
+#include <algorithm>
+
+
+// Joins the series by date.
+CWeatherJoin::CWeatherJoin(std::vector<WeatherView> series, missingDayPolicy policy)
+    : series(std::move(series)), rowIndexes(this->series.size())
+{
+    int seriesCount = this->series.size();
+
+    // Ordinal dates of the days of each series with their indexes, sorted by date (the sort is skipped for sorted series).
+    std::vector<std::vector<std::pair<qint64, int>>> seriesDays(seriesCount);
+
+    for (int s = 0; s < seriesCount; ++s)
+    {
+        const WeatherView& view = this->series[s];
+        std::vector<std::pair<qint64, int>>& days = seriesDays[s];
+        days.reserve(view.getWeatherSize());
+
+        for (int i = 0; i < view.getWeatherSize(); ++i) {
+            QDate date = view.getDate(i);
+            if (date.isValid()) {
+                days.emplace_back(date.toJulianDay(), i);
+            }
+        }
+
+        if (!std::is_sorted(days.begin(), days.end())) {
+            std::stable_sort(days.begin(), days.end(), [](const std::pair<qint64, int>& a, const std::pair<qint64, int>& b) {
+                return a.first < b.first;
+            });
+        }
+    }
+
+    // Merge join: each step takes the earliest date at the heads of the series and advances the series that have it.
+    std::vector<int> heads(seriesCount, 0);
+    std::vector<int> lastRows(seriesCount, -1);
+    std::vector<int> dayRows(seriesCount);
+
+    while (true)
+    {
+        bool isAnyLeft = false;
+        qint64 date = 0;
+
+        for (int s = 0; s < seriesCount; ++s) {
+            if (heads[s] < seriesDays[s].size() && (!isAnyLeft || seriesDays[s][heads[s]].first < date)) {
+                date = seriesDays[s][heads[s]].first;
+                isAnyLeft = true;
+            }
+        }
+
+        if (!isAnyLeft) {
+            break;
+        }
+
+        bool isComplete = true;
+
+        for (int s = 0; s < seriesCount; ++s)
+        {
+            const std::vector<std::pair<qint64, int>>& days = seriesDays[s];
+
+            if (heads[s] < days.size() && days[heads[s]].first == date) {
+                dayRows[s] = lastRows[s] = days[heads[s]].second;
+
+                // Further days with the same date are duplicates.
+                while (heads[s] < days.size() && days[heads[s]].first == date) {
+                    heads[s]++;
+                }
+            }
+            else {
+                dayRows[s] = policy == FillMissingDays ? lastRows[s] : -1;
+                isComplete = false;
+            }
+        }
+
+        if (policy == SkipMissingDays && !isComplete) {
+            continue;
+        }
+
+        dates.push_back(date);
+        for (int s = 0; s < seriesCount; ++s) {
+            rowIndexes[s].push_back(dayRows[s]);
+        }
+    }
+}
+
+
+// Used to get the number of joined series.
+int CWeatherJoin::getSeriesCount() const
+{
+    return series.size();
+}
+
+
+// Used to get the number of days of the join.
+int CWeatherJoin::getDayCount() const
+{
+    return dates.size();
+}
+
+
+// Used to get the date of a certain day of the join.
+QDate CWeatherJoin::getDate(int day) const
+{
+    return QDate::fromJulianDay(dates[day]);
+}
+
+
+// Used to get the dates of all the days of the join.
+std::vector<QDate> CWeatherJoin::getDates() const
+{
+    std::vector<QDate> result(dates.size());
+
+    for (int i = 0; i < dates.size(); ++i) {
+        result[i] = QDate::fromJulianDay(dates[i]);
+    }
+
+    return result;
+}
+
+
+// Used to get the index of the day of a series that is aligned with a certain day of the join.
+int CWeatherJoin::getRowIndex(int seriesIndex, int day) const
+{
+    return rowIndexes[seriesIndex][day];
+}
+
+
+// Determine if a series has a value for a certain day of the join.
+bool CWeatherJoin::hasValue(int seriesIndex, int day) const
+{
+    return rowIndexes[seriesIndex][day] != -1;
+}
+
+
+// Used to get the value of a weather column of a series for a certain day of the join.
+int CWeatherJoin::getValue(int seriesIndex, WeatherColumn column, int day) const
+{
+    return series[seriesIndex].getColumnValue(column, rowIndexes[seriesIndex][day]);
+}
+
+
+// Used to get a series aligned with the join.
+WeatherView CWeatherJoin::getAlignedView(int seriesIndex) const
+{
+    const std::vector<int>& indexes = rowIndexes[seriesIndex];
+
+    if (std::find(indexes.begin(), indexes.end(), -1) != indexes.end()) {
+        throw QString("The series has no data for some days of the join.");
+    }
+
+    return series[seriesIndex].getSelection(indexes);
+}
+
+
+// Used to get a column of a series as a graph line.
+graphOverlay CWeatherJoin::getSeriesLine(int seriesIndex, WeatherColumn column, const QString& name) const
+{
+    graphOverlay line;
+    line.m_name = name;
+
+    for (int day = 0; day < dates.size(); ++day) {
+        if (hasValue(seriesIndex, day)) {
+            line.m_indexes.push_back(day);
+            line.m_values.push_back(getValue(seriesIndex, column, day));
+        }
+    }
+
+    return line;
+}
+
+
+// Used to get the day-by-day difference of a column between two series as a graph line.
+graphOverlay CWeatherJoin::getDifferenceLine(int firstSeries, int secondSeries, WeatherColumn column, const QString& name) const
+{
+    graphOverlay line;
+    line.m_name = name;
+
+    for (int day = 0; day < dates.size(); ++day) {
+        if (hasValue(firstSeries, day) && hasValue(secondSeries, day)) {
+            line.m_indexes.push_back(day);
+            line.m_values.push_back(getValue(firstSeries, column, day) - getValue(secondSeries, column, day));
+        }
+    }
+
+    return line;
+}
+
+
+// Used to get the day-by-day mean of a column over all the series as a graph line.
+graphOverlay CWeatherJoin::getMeanLine(WeatherColumn column, const QString& name) const
+{
+    graphOverlay line;
+    line.m_name = name;
+
+    for (int day = 0; day < dates.size(); ++day)
+    {
+        long long sum = 0;
+        int count = 0;
+
+        for (int s = 0; s < series.size(); ++s) {
+            if (hasValue(s, day)) {
+                sum += getValue(s, column, day);
+                count++;
+            }
+        }
+
+        if (count != 0) {
+            line.m_indexes.push_back(day);
+            line.m_values.push_back(static_cast<double>(sum) / count);
+        }
+    }
+
+    return line;
+}
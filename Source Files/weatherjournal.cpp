@@ -0,0 +1,613 @@
+#include "../Header Files/weatherjournal.h"
+#include <QCryptographicHash>
+#include <QSaveFile>
+#include <QTextStream>
+#include <filesystem>
+#include <map>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+
+// Used to get the hash of a file (the journal refers to its base file by it).
+static QByteArray getHash(const QByteArray& data)
+{
+    return QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex();
+}
+
+
+// Writes the buffered data of a file through to the disk.
+static bool syncFile(QFile& file)
+{
+    if (!file.flush()) {
+        return false;
+    }
+
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return fsync(file.handle()) == 0;
+#endif
+}
+
+
+// Determine if two days are the same.
+static bool isSameDay(const CWather::weatherData& a, const CWather::weatherData& b)
+{
+    return a.m_year == b.m_year && a.m_month == b.m_month && a.m_day == b.m_day && a.m_temperature == b.m_temperature
+           && a.m_pressure == b.m_pressure && a.m_humidity == b.m_humidity && a.m_windDirection == b.m_windDirection;
+}
+
+
+// Reads a day from the values of a journal line (7 values starting from the first).
+static bool parseDay(const QStringList& values, int first, CWather::weatherData& wData)
+{
+    if (values.size() != first + 7) {
+        return false;
+    }
+
+    bool isOk[6];
+    wData = CWather::weatherData(values[first].toInt(&isOk[0]), static_cast<Month>(values[first + 1].toInt(&isOk[1])),
+                                 values[first + 2].toUInt(&isOk[2]), values[first + 3].toInt(&isOk[3]),
+                                 values[first + 4].toUInt(&isOk[4]), values[first + 5].toInt(&isOk[5]),
+                                 convertTextToWindDir(values[first + 6]));
+
+    return isOk[0] && isOk[1] && isOk[2] && isOk[3] && isOk[4] && isOk[5];
+}
+
+
+// Replaces a file with another one in one step (the target is never missing, as it would be if it was removed first).
+static bool replaceFile(const QString& sourceFileName, const QString& targetFileName)
+{
+    std::error_code error;
+    std::filesystem::rename(std::filesystem::path(sourceFileName.toStdU16String()),
+                            std::filesystem::path(targetFileName.toStdU16String()), error);
+    return !error;
+}
+
+
+// Default constructor.
+CWeatherJournal::CWeatherJournal()
+    : baseSize(0), journalSize(0), fullWriteNumber(0), isCompacting(false)
+{}
+
+
+// Constructor with parameters.
+CWeatherJournal::CWeatherJournal(const QString& fileName)
+    : fileName(fileName), baseSize(0), journalSize(0), fullWriteNumber(0), isCompacting(false)
+{}
+
+
+// Determine if a file has a journal (or an unfinished compaction) next to it.
+bool CWeatherJournal::hasJournal(const QString& fileName)
+{
+    CWeatherJournal journal(fileName);
+    return QFile::exists(journal.getJournalFileName()) || QFile::exists(journal.getNewJournalFileName())
+           || QFile::exists(journal.getCompactFileName());
+}
+
+
+// Used to get the names of the files next to the base file.
+QString CWeatherJournal::getJournalFileName() const
+{
+    return fileName + ".journal";
+}
+
+
+QString CWeatherJournal::getNewJournalFileName() const
+{
+    return fileName + ".journal.new";
+}
+
+
+QString CWeatherJournal::getCompactFileName() const
+{
+    return fileName + ".compact";
+}
+
+
+// Opens the base file and applies the journal to it.
+CWeatherDataset CWeatherJournal::open()
+{
+    // A compaction interrupted after removing the old base file: the compacted file is complete and becomes the base file.
+    if (!QFile::exists(fileName) && QFile::exists(getCompactFileName())) {
+        QFile::rename(getCompactFileName(), fileName);
+    }
+    QFile::remove(getCompactFileName());
+
+    // Read the base file.
+    QFile baseFile(fileName);
+    if (!baseFile.open(QIODevice::ReadOnly)) {
+        throw QString("File could not be opened.");
+    }
+
+    QByteArray baseData = baseFile.readAll();
+    baseFile.close();
+
+    baseHash = getHash(baseData);
+    baseSize = baseData.size();
+
+    QTextStream in(baseData);
+    CWeatherDataset dataset;
+    in >> dataset;
+    savedDataset = dataset;
+
+    QByteArray header = "journal " + baseHash + "\n";
+
+    // A new journal is left by a compaction interrupted after it was written; it is valid if it belongs to this base file.
+    QFile newJournalFile(getNewJournalFileName());
+    if (newJournalFile.open(QIODevice::ReadOnly)) {
+        bool isCurrent = newJournalFile.readAll().startsWith(header);
+        newJournalFile.close();
+
+        if (isCurrent) {
+            replaceFile(getNewJournalFileName(), getJournalFileName());
+        }
+        else {
+            QFile::remove(getNewJournalFileName());
+        }
+    }
+
+    // Apply the journal of this base file (a journal of another base file is started again).
+    QFile journalFile(getJournalFileName());
+    QByteArray journalData;
+
+    if (journalFile.open(QIODevice::ReadOnly)) {
+        journalData = journalFile.readAll();
+        journalFile.close();
+    }
+
+    if (journalData.startsWith(header))
+    {
+        journalSize = replay(journalData);
+
+        // Drop an incomplete last transaction, so the next one is not appended after it.
+        if (journalSize != journalData.size() && !journalFile.resize(journalSize)) {
+            throw QString("The journal of the file could not be repaired.");
+        }
+    }
+    else
+    {
+        QSaveFile newJournal(getJournalFileName());
+        if (!newJournal.open(QIODevice::WriteOnly) || newJournal.write(header) != header.size() || !newJournal.commit()) {
+            throw QString("The journal of the file could not be written.");
+        }
+
+        journalSize = header.size();
+    }
+
+    return savedDataset;
+}
+
+
+// Applies the complete transactions of the journal to the saved dataset.
+qint64 CWeatherJournal::replay(const QByteArray& journalData)
+{
+    // Days of the changed stations (loaded when a station is changed for the first time).
+    std::map<int, std::vector<CWather::weatherData>> stationDays;
+
+    auto getDays = [this, &stationDays](int stationIndex) -> std::vector<CWather::weatherData>& {
+        auto found = stationDays.find(stationIndex);
+        if (found == stationDays.end()) {
+            WeatherView weather = savedDataset.getStation(stationIndex).m_weather;
+            std::vector<CWather::weatherData>& days = stationDays[stationIndex];
+            for (int i = 0; i < weather.getWeatherSize(); ++i) {
+                days.push_back(weather.at(i));
+            }
+            return days;
+        }
+        return found->second;
+    };
+
+    // Lines of the transaction that has not been committed yet.
+    std::vector<QStringList> transaction;
+    qint64 position = journalData.indexOf('\n') + 1;
+    qint64 validSize = position;
+
+    while (position < journalData.size())
+    {
+        qint64 lineEnd = journalData.indexOf('\n', position);
+        if (lineEnd == -1) {
+            break;
+        }
+
+        QStringList values = QString::fromUtf8(journalData.mid(position, lineEnd - position)).split(' ');
+        position = lineEnd + 1;
+
+        if (values.front() != "commit") {
+            transaction.push_back(values);
+            continue;
+        }
+
+        // Lines of a damaged transaction (and everything after it) are dropped.
+        bool isOk;
+        if (values.size() != 2 || values[1].toInt(&isOk) != static_cast<int>(transaction.size()) || !isOk) {
+            break;
+        }
+
+        // Check the whole transaction before applying it, so it is applied completely or not at all (a transaction that
+        // does not fit the dataset is dropped as a damaged one). Only the sizes of the changed stations are followed.
+        CWeatherDataset checkedDataset = savedDataset;
+        std::map<int, int> stationSizes;
+        bool isApplicable = true;
+
+        for (int i = 0; isApplicable && i < static_cast<int>(transaction.size()); ++i)
+        {
+            const QStringList& change = transaction[i];
+
+            // A new station.
+            if (change.front() == "station") {
+                try {
+                    checkedDataset.addStation(change.mid(1).join(" "));
+                } catch (const QString&) {
+                    isApplicable = false;
+                }
+                continue;
+            }
+
+            bool isIndexOk[2] = {false, false};
+            int stationIndex = change.size() > 2 ? change[1].toInt(&isIndexOk[0]) : -1;
+            int row = change.size() > 2 ? change[2].toInt(&isIndexOk[1]) : -1;
+
+            if (!isIndexOk[0] || !isIndexOk[1] || stationIndex < 0 || stationIndex >= checkedDataset.getStationCount() || row < 0) {
+                isApplicable = false;
+                continue;
+            }
+
+            if (stationSizes.find(stationIndex) == stationSizes.end()) {
+                auto days = stationDays.find(stationIndex);
+                stationSizes[stationIndex] = days != stationDays.end()
+                                                 ? static_cast<int>(days->second.size())
+                                                 : WeatherView(checkedDataset.getStation(stationIndex).m_weather).getWeatherSize();
+            }
+
+            int& size = stationSizes[stationIndex];
+            CWather::weatherData wData;
+
+            if (change.front() == "set") {
+                isApplicable = row < size && parseDay(change, 3, wData);
+            }
+            else if (change.front() == "insert") {
+                isApplicable = row <= size && parseDay(change, 3, wData);
+                size++;
+            }
+            else if (change.front() == "delete" && change.size() == 4) {
+                int count = change[3].toInt();
+                isApplicable = count > 0 && row <= size - count;
+                size -= count;
+            }
+            else {
+                isApplicable = false;
+            }
+        }
+
+        if (!isApplicable) {
+            break;
+        }
+
+        // Apply the checked transaction.
+        savedDataset = checkedDataset;
+
+        for (const QStringList& change : transaction)
+        {
+            if (change.front() == "station") {
+                continue;
+            }
+
+            std::vector<CWather::weatherData>& days = getDays(change[1].toInt());
+            int row = change[2].toInt();
+            CWather::weatherData wData;
+
+            if (change.front() == "set") {
+                parseDay(change, 3, wData);
+                days[row] = wData;
+            }
+            else if (change.front() == "insert") {
+                parseDay(change, 3, wData);
+                days.insert(days.begin() + row, wData);
+            }
+            else {
+                days.erase(days.begin() + row, days.begin() + row + change[3].toInt());
+            }
+        }
+
+        transaction.clear();
+        validSize = position;
+    }
+
+    // Build the changed stations.
+    for (std::pair<const int, std::vector<CWather::weatherData>>& days : stationDays) {
+        savedDataset.setStationWeather(days.first, CWather(std::move(days.second)));
+    }
+
+    return validSize;
+}
+
+
+// Saves a dataset.
+CWeatherJournal::saveResult CWeatherJournal::save(const CWeatherDataset& dataset)
+{
+    saveResult result;
+
+    // The journal can add stations, but cannot remove or rename them.
+    bool isJournalable = !baseHash.isEmpty() && dataset.getStationCount() >= savedDataset.getStationCount();
+    for (int i = 0; isJournalable && i < savedDataset.getStationCount(); ++i) {
+        isJournalable = dataset.getStation(i).m_id == savedDataset.getStation(i).m_id;
+    }
+
+    if (!isJournalable) {
+        writeBase(dataset);
+        result.m_isFullWrite = true;
+        result.m_writtenBytes = baseSize + journalSize;
+        return result;
+    }
+
+    // Lines of the transaction.
+    QByteArray lines;
+
+    for (int i = savedDataset.getStationCount(); i < dataset.getStationCount(); ++i) {
+        lines += "station " + dataset.getStation(i).m_id.toUtf8() + "\n";
+        result.m_changeCount++;
+    }
+
+    for (int i = 0; i < dataset.getStationCount(); ++i) {
+        CWather savedWeather = i < savedDataset.getStationCount() ? savedDataset.getStation(i).m_weather : CWather();
+        result.m_changeCount += formatStationChanges(i, savedWeather, dataset.getStation(i).m_weather, lines);
+    }
+
+    if (result.m_changeCount == 0) {
+        return result;
+    }
+
+    lines += "commit " + QByteArray::number(result.m_changeCount) + "\n";
+
+    // Append the transaction; a failed append is cut off, so the journal stays valid. The save is done only when the
+    // transaction is on the disk, as the base and compacted files are.
+    QFile journalFile(getJournalFileName());
+    if (!journalFile.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        throw QString("The data has not been recorded!");
+    }
+
+    if (journalFile.write(lines) != lines.size() || !syncFile(journalFile)) {
+        journalFile.close();
+        QFile(getJournalFileName()).resize(journalSize);
+        throw QString("The data has not been recorded!");
+    }
+
+    journalFile.close();
+
+    journalSize += lines.size();
+    savedDataset = dataset;
+    result.m_writtenBytes = lines.size();
+
+    return result;
+}
+
+
+// Writes the changes of a station.
+int CWeatherJournal::formatStationChanges(int stationIndex, const CWather& savedWeather, const CWather& weather, QByteArray& lines)
+{
+    WeatherView savedDays = savedWeather, days = weather;
+    int savedCount = savedDays.getWeatherSize(), count = days.getWeatherSize();
+    QByteArray station = QByteArray::number(stationIndex) + " ";
+    int lineCount = 0;
+
+    // Walk both versions in step; the row indexes are those of the journal being replayed (everything before the current
+    // row is already the same as in the new version).
+    int savedRow = 0, row = 0;
+
+    // Determine if the days from savedRow and row on are the same (two days must match, so a single equal day is not
+    // taken for the end of an insertion or a deletion).
+    auto isInStep = [&](int savedIndex, int index) {
+        return isSameDay(savedDays.at(savedIndex), days.at(index))
+               && (savedIndex + 1 >= savedCount || index + 1 >= count || isSameDay(savedDays.at(savedIndex + 1), days.at(index + 1)));
+    };
+
+    while (savedRow < savedCount && row < count)
+    {
+        if (isSameDay(savedDays.at(savedRow), days.at(row))) {
+            savedRow++;
+            row++;
+            continue;
+        }
+
+        // Look for a short insertion or deletion after which the versions are in step again.
+        int insertedCount = 0, deletedCount = 0;
+        for (int shift = 1; shift <= RESYNC_DISTANCE && insertedCount == 0 && deletedCount == 0; ++shift) {
+            if (row + shift < count && isInStep(savedRow, row + shift)) {
+                insertedCount = shift;
+            }
+            else if (savedRow + shift < savedCount && isInStep(savedRow + shift, row)) {
+                deletedCount = shift;
+            }
+        }
+
+        if (deletedCount != 0) {
+            lines += "delete " + station + QByteArray::number(row) + " " + QByteArray::number(deletedCount) + "\n";
+            savedRow += deletedCount;
+            lineCount++;
+            continue;
+        }
+
+        for (int k = 0; k < insertedCount; ++k, ++row) {
+            lines += "insert " + station + QByteArray::number(row) + " " + formatDay(days.at(row)) + "\n";
+            lineCount++;
+        }
+
+        // A changed day.
+        if (insertedCount == 0) {
+            lines += "set " + station + QByteArray::number(row) + " " + formatDay(days.at(row)) + "\n";
+            savedRow++;
+            row++;
+            lineCount++;
+        }
+    }
+
+    // Days removed from the end, or added to it.
+    if (savedRow < savedCount) {
+        lines += "delete " + station + QByteArray::number(row) + " " + QByteArray::number(savedCount - savedRow) + "\n";
+        lineCount++;
+    }
+
+    for (; row < count; ++row) {
+        lines += "insert " + station + QByteArray::number(row) + " " + formatDay(days.at(row)) + "\n";
+        lineCount++;
+    }
+
+    return lineCount;
+}
+
+
+// Writes a day as in the base file.
+QByteArray CWeatherJournal::formatDay(const CWather::weatherData& wData)
+{
+    return QString("%1 %2 %3 %4 %5 %6 %7").arg(wData.m_year).arg(static_cast<int>(wData.m_month)).arg(wData.m_day)
+        .arg(wData.m_temperature).arg(wData.m_pressure).arg(wData.m_humidity).arg(convertWindDirToText(wData.m_windDirection))
+        .toUtf8();
+}
+
+
+// Writes the dataset in the text format.
+QByteArray CWeatherJournal::formatDataset(const CWeatherDataset& dataset)
+{
+    QByteArray data;
+    QTextStream out(&data);
+    out << dataset;
+    out.flush();
+    return data;
+}
+
+
+// Writes the whole dataset to the base file and starts a new journal.
+void CWeatherJournal::writeBase(const CWeatherDataset& dataset)
+{
+    QByteArray data = formatDataset(dataset);
+
+    // The base file is replaced only when the new one is complete.
+    QSaveFile baseFile(fileName);
+    if (!baseFile.open(QIODevice::WriteOnly) || baseFile.write(data) != data.size() || !baseFile.commit()) {
+        throw QString("The data has not been recorded!");
+    }
+
+    // A journal of the old base file would be ignored anyway; the new one starts empty.
+    QByteArray hash = getHash(data);
+    QByteArray header = "journal " + hash + "\n";
+
+    QSaveFile journalFile(getJournalFileName());
+    if (!journalFile.open(QIODevice::WriteOnly) || journalFile.write(header) != header.size() || !journalFile.commit()) {
+        throw QString("The journal of the file could not be written.");
+    }
+
+    baseHash = hash;
+    baseSize = data.size();
+    journalSize = header.size();
+    savedDataset = dataset;
+    fullWriteNumber++;
+}
+
+
+// Determine if the journal has a base file.
+bool CWeatherJournal::isActive() const
+{
+    return !fileName.isEmpty();
+}
+
+
+// Used to get the name of the base file.
+QString CWeatherJournal::getFileName() const
+{
+    return fileName;
+}
+
+
+// Determine if the journal is large enough to be compacted.
+bool CWeatherJournal::isCompactionNeeded() const
+{
+    return !baseHash.isEmpty() && !isCompacting && journalSize > MIN_COMPACTION_SIZE && journalSize * COMPACTION_RATIO > baseSize;
+}
+
+
+// Starts writing a compacted base file in a background thread.
+QFuture<CWeatherJournal::compactionResult> CWeatherJournal::startCompaction()
+{
+    isCompacting = true;
+
+    compactionResult result;
+    result.m_fullWriteNumber = fullWriteNumber;
+    result.m_journalSize = journalSize;
+
+    // The saved dataset shares its data with the copy, so later saves do not change what is written.
+    CWeatherDataset dataset = savedDataset;
+    QString compactFileName = getCompactFileName();
+
+    return QtConcurrent::run([dataset, compactFileName, result]() {
+        compactionResult compacted = result;
+        QByteArray data = formatDataset(dataset);
+        compacted.m_hash = getHash(data);
+        compacted.m_size = data.size();
+
+        // The compacted file is on the disk (not only in the cache of the system) before it can replace the base file.
+        QSaveFile compactFile(compactFileName);
+        if (!compactFile.open(QIODevice::WriteOnly) || compactFile.write(data) != data.size() || !compactFile.commit()) {
+            compacted.m_error = "The compacted file could not be written.";
+        }
+
+        return compacted;
+    });
+}
+
+
+// Replaces the base file with the compacted file.
+void CWeatherJournal::finishCompaction(const compactionResult& result)
+{
+    isCompacting = false;
+
+    // The base file has been written as a whole since the compaction started.
+    if (result.m_fullWriteNumber != fullWriteNumber) {
+        QFile::remove(getCompactFileName());
+        return;
+    }
+
+    if (!result.m_error.isEmpty()) {
+        QFile::remove(getCompactFileName());
+        throw result.m_error;
+    }
+
+    // The new journal keeps the transactions saved while the compacted file was written.
+    QFile journalFile(getJournalFileName());
+    if (!journalFile.open(QIODevice::ReadOnly) || !journalFile.seek(result.m_journalSize)) {
+        QFile::remove(getCompactFileName());
+        throw QString("The journal of the file could not be read.");
+    }
+
+    QByteArray newJournal = "journal " + result.m_hash + "\n" + journalFile.readAll();
+    journalFile.close();
+
+    QSaveFile newJournalFile(getNewJournalFileName());
+    if (!newJournalFile.open(QIODevice::WriteOnly) || newJournalFile.write(newJournal) != newJournal.size()
+        || !newJournalFile.commit()) {
+        QFile::remove(getCompactFileName());
+        throw QString("The journal of the file could not be written.");
+    }
+
+    // Replace the base file, then the journal, each in one step: the base file is always either the old or the compacted
+    // one, and open() takes the new journal if the second step is interrupted.
+    if (!replaceFile(getCompactFileName(), fileName)) {
+        QFile::remove(getNewJournalFileName());
+        QFile::remove(getCompactFileName());
+        throw QString("The compacted file could not replace the file.");
+    }
+
+    // From here on open() can recover the files, and the next save writes the whole base file.
+    if (!replaceFile(getNewJournalFileName(), getJournalFileName())) {
+        baseHash.clear();
+        throw QString("The compacted file could not replace the file.");
+    }
+
+    baseHash = result.m_hash;
+    baseSize = result.m_size;
+    journalSize = newJournal.size();
+}
@@ -0,0 +1,655 @@
+#include "../Header Files/weatherquery.h"
+#include "../Header Files/derivedcolumns.h"
+#include <QtAlgorithms>
+#include <climits>
+#include <cmath>
+#include <functional>
+
+
+// Used to get the number of selected days.
+int CSelectionBitmap::getSelectedCount() const
+{
+    int count = 0;
+
+    for (quint64 word : words) {
+        count += qPopulationCount(word);
+    }
+
+    return count;
+}
+
+
+// Used to get the indexes of the selected days (in ascending order).
+std::vector<int> CSelectionBitmap::getSelectedIndexes() const
+{
+    std::vector<int> indexes;
+    indexes.reserve(getSelectedCount());
+
+    for (int w = 0; w < words.size(); ++w)
+    {
+        // Take the lowest set bit of the word until no bits are left.
+        for (quint64 word = words[w]; word != 0; word &= word - 1) {
+            indexes.push_back(w * 64 + qCountTrailingZeroBits(word));
+        }
+    }
+
+    return indexes;
+}
+
+
+// Keeps selected only the days selected in both bitmaps.
+CSelectionBitmap& CSelectionBitmap::operator&=(const CSelectionBitmap& other)
+{
+    for (int w = 0; w < words.size(); ++w) {
+        words[w] &= other.words[w];
+    }
+
+    return *this;
+}
+
+
+// Selects also the days selected in the other bitmap.
+CSelectionBitmap& CSelectionBitmap::operator|=(const CSelectionBitmap& other)
+{
+    for (int w = 0; w < words.size(); ++w) {
+        words[w] |= other.words[w];
+    }
+
+    return *this;
+}
+
+
+// Inverts the selection.
+void CSelectionBitmap::invert()
+{
+    for (quint64& word : words) {
+        word = ~word;
+    }
+
+    // Clear the bits past the last day.
+    if (size % 64 != 0) {
+        words.back() &= (quint64(1) << (size % 64)) - 1;
+    }
+}
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// Token of a filter expression.
+struct queryToken
+{
+    /// The kind of the token: a word (field, keyword or name), a number, a symbol (operator or punctuation) or the end.
+    enum tokenKind { Word, Number, Symbol, End } m_kind = End;
+    /// The text of the token.
+    QString m_text;
+    /// The position of the token in the expression (for error messages).
+    int m_position = 0;
+};
+
+
+// Splits a filter expression into tokens.
+static std::vector<queryToken> tokenizeExpression(const QString& expression)
+{
+    std::vector<queryToken> tokens;
+    int i = 0;
+
+    while (i < expression.size())
+    {
+        QChar ch = expression.at(i);
+
+        if (ch.isSpace()) {
+            i++;
+            continue;
+        }
+
+        queryToken token;
+        token.m_position = i + 1;
+        int start = i;
+
+        if (ch.isLetter() || ch == QChar('_'))
+        {
+            token.m_kind = queryToken::Word;
+            while (i < expression.size() && (expression.at(i).isLetterOrNumber() || expression.at(i) == QChar('_'))) {
+                i++;
+            }
+        }
+        else if (ch.isDigit() || (ch == QChar('-') && i + 1 < expression.size() && expression.at(i + 1).isDigit()))
+        {
+            token.m_kind = queryToken::Number;
+            i++;
+            while (i < expression.size() && expression.at(i).isDigit()) {
+                i++;
+            }
+
+            // A decimal fraction.
+            if (i + 1 < expression.size() && expression.at(i) == QChar('.') && expression.at(i + 1).isDigit()) {
+                i++;
+                while (i < expression.size() && expression.at(i).isDigit()) {
+                    i++;
+                }
+            }
+        }
+        else
+        {
+            token.m_kind = queryToken::Symbol;
+
+            // Two-character operators are matched before one-character ones.
+            static const QStringList twoCharSymbols = { "<=", ">=", "!=", "<>", "==", "&&", "||" };
+            static const QString oneCharSymbols = "<>=!(),";
+
+            if (twoCharSymbols.contains(expression.mid(i, 2))) {
+                i += 2;
+            } else if (oneCharSymbols.contains(ch)) {
+                i++;
+            } else {
+                throw QString("Unexpected character \"%1\" at position %2.").arg(ch).arg(token.m_position);
+            }
+        }
+
+        token.m_text = expression.mid(start, i - start);
+        tokens.push_back(token);
+    }
+
+    queryToken endToken;
+    endToken.m_position = expression.size() + 1;
+    tokens.push_back(endToken);
+
+    return tokens;
+}
+
+
+// Recursive descent parser of filter expressions:
+//   expression := term { ("or" | "||") term }
+//   term       := factor { ("and" | "&&") factor }
+//   factor     := ("not" | "!") factor | "(" expression ")" | field operator value | field "in" "(" value { "," value } ")"
+class queryParser
+{
+public:
+
+    using queryNode = CWeatherQuery::queryNode;
+    using nodePointer = std::shared_ptr<const queryNode>;
+
+
+    // Splits the expression into tokens.
+    explicit queryParser(const QString& expression) : tokens(tokenizeExpression(expression)), current(0)
+    {}
+
+
+    // Parses the whole expression.
+    nodePointer parse()
+    {
+        if (peek().m_kind == queryToken::End) {
+            throw QString("The filter expression is empty.");
+        }
+
+        nodePointer root = parseExpression();
+
+        if (peek().m_kind != queryToken::End) {
+            throw QString("Unexpected \"%1\" at position %2.").arg(peek().m_text).arg(peek().m_position);
+        }
+
+        return root;
+    }
+
+
+private:
+
+    // Tokens of the expression (the last one is End) and the index of the token being parsed.
+    std::vector<queryToken> tokens;
+    int current;
+
+
+    // Used to get the token being parsed.
+    const queryToken& peek() const
+    {
+        return tokens[current];
+    }
+
+
+    // Moves to the next token if the current one is the keyword or symbol 'text' (or its alternative spelling).
+    bool accept(const QString& text, const QString& alternative = QString())
+    {
+        const queryToken& token = peek();
+        bool isMatch = (token.m_kind == queryToken::Word || token.m_kind == queryToken::Symbol)
+                       && (token.m_text.toLower() == text || (!alternative.isEmpty() && token.m_text == alternative));
+
+        if (isMatch) {
+            current++;
+        }
+
+        return isMatch;
+    }
+
+
+    // Moves to the next token, which must be the symbol 'text'.
+    void expect(const QString& text)
+    {
+        if (!accept(text)) {
+            throw QString("Expected \"%1\" at position %2.").arg(text).arg(peek().m_position);
+        }
+    }
+
+
+    // Creates a node combining two nodes.
+    static nodePointer combine(queryNode::nodeKind kind, nodePointer left, nodePointer right)
+    {
+        auto node = std::make_shared<queryNode>();
+        node->m_kind = kind;
+        node->m_left = std::move(left);
+        node->m_right = std::move(right);
+        return node;
+    }
+
+
+    // expression := term { ("or" | "||") term }
+    nodePointer parseExpression()
+    {
+        nodePointer node = parseTerm();
+
+        while (accept("or", "||")) {
+            node = combine(queryNode::Or, node, parseTerm());
+        }
+
+        return node;
+    }
+
+
+    // term := factor { ("and" | "&&") factor }
+    nodePointer parseTerm()
+    {
+        nodePointer node = parseFactor();
+
+        while (accept("and", "&&")) {
+            node = combine(queryNode::And, node, parseFactor());
+        }
+
+        return node;
+    }
+
+
+    // factor := ("not" | "!") factor | "(" expression ")" | comparison
+    nodePointer parseFactor()
+    {
+        if (accept("not", "!")) {
+            return combine(queryNode::Not, parseFactor(), nullptr);
+        }
+
+        if (accept("(")) {
+            nodePointer node = parseExpression();
+            expect(")");
+            return node;
+        }
+
+        return parseComparison();
+    }
+
+
+    // comparison := field operator value | field "in" "(" value { "," value } ")"
+    nodePointer parseComparison()
+    {
+        CWeatherQuery::queryField field = parseField();
+
+        // Membership in a list of values is compiled into equalities combined with "or".
+        if (accept("in")) {
+            expect("(");
+
+            nodePointer node = createComparison(field, CWeatherQuery::Equal, parseValue(field));
+            while (accept(",")) {
+                node = combine(queryNode::Or, node, createComparison(field, CWeatherQuery::Equal, parseValue(field)));
+            }
+
+            expect(")");
+            return node;
+        }
+
+        const queryToken& operatorToken = peek();
+        CWeatherQuery::compareOperator compareOperator = parseOperator();
+
+        if ((field == CWeatherQuery::WindField || field == CWeatherQuery::SeasonField)
+            && compareOperator != CWeatherQuery::Equal && compareOperator != CWeatherQuery::NotEqual)
+        {
+            throw QString("Only =, != and in can be used with \"%1\" (position %2).")
+                .arg(field == CWeatherQuery::WindField ? "wind" : "season").arg(operatorToken.m_position);
+        }
+
+        return createComparison(field, compareOperator, parseValue(field));
+    }
+
+
+    // Creates a comparison node.
+    static nodePointer createComparison(CWeatherQuery::queryField field, CWeatherQuery::compareOperator compareOperator,
+                                        double value)
+    {
+        auto node = std::make_shared<queryNode>();
+        node->m_kind = queryNode::Compare;
+        node->m_field = field;
+        node->m_operator = compareOperator;
+        node->m_value = value;
+        return node;
+    }
+
+
+    // Parses the name of a column.
+    CWeatherQuery::queryField parseField()
+    {
+        const queryToken& token = peek();
+        QString name = token.m_text.toLower();
+
+        static const std::vector<std::pair<QString, CWeatherQuery::queryField>> fieldNames = {
+            {"year", CWeatherQuery::YearField}, {"month", CWeatherQuery::MonthField}, {"day", CWeatherQuery::DayField},
+            {"t", CWeatherQuery::TemperatureField}, {"temperature", CWeatherQuery::TemperatureField},
+            {"pressure", CWeatherQuery::PressureField}, {"humidity", CWeatherQuery::HumidityField},
+            {"wind", CWeatherQuery::WindField}, {"season", CWeatherQuery::SeasonField}
+        };
+
+        if (token.m_kind == queryToken::Word) {
+            for (const auto& fieldName : fieldNames) {
+                if (fieldName.first == name) {
+                    current++;
+                    return fieldName.second;
+                }
+            }
+
+            // The fields of the derived columns follow in the order of DerivedColumn.
+            DerivedColumn derivedColumn;
+            if (CDerivedColumns::findColumn(name, derivedColumn)) {
+                current++;
+                return static_cast<CWeatherQuery::queryField>(CWeatherQuery::DewPointField + derivedColumn - DewPointColumn);
+            }
+        }
+
+        if (token.m_kind == queryToken::End) {
+            throw QString("Expected a field (t, pressure, humidity, wind, year, month, day, season, dewpoint, heatindex, tendency "
+                          "or anomaly) at the end of the expression.");
+        }
+
+        throw QString("Unknown field \"%1\" at position %2. Fields: t, pressure, humidity, wind, year, month, day, season, "
+                      "dewpoint, heatindex, tendency, anomaly.").arg(token.m_text).arg(token.m_position);
+    }
+
+
+    // Parses a comparison operator.
+    CWeatherQuery::compareOperator parseOperator()
+    {
+        if (accept("=", "==")) {
+            return CWeatherQuery::Equal;
+        } else if (accept("!=", "<>")) {
+            return CWeatherQuery::NotEqual;
+        } else if (accept("<=")) {
+            return CWeatherQuery::LessOrEqual;
+        } else if (accept(">=")) {
+            return CWeatherQuery::GreaterOrEqual;
+        } else if (accept("<")) {
+            return CWeatherQuery::Less;
+        } else if (accept(">")) {
+            return CWeatherQuery::Greater;
+        }
+
+        throw QString("Expected a comparison operator (=, !=, <, <=, >, >= or in) at position %1.").arg(peek().m_position);
+    }
+
+
+    // Parses a value of a column (a number, or a name of a wind direction, season or month).
+    double parseValue(CWeatherQuery::queryField field)
+    {
+        const queryToken& token = peek();
+
+        if (token.m_kind == queryToken::Number)
+        {
+            // The columns that are not derived hold whole numbers, so their constants must fit an int.
+            bool isNumber;
+            double value = token.m_text.toDouble(&isNumber);
+
+            if (!isNumber || (field < CWeatherQuery::DewPointField && !(value >= INT_MIN && value <= INT_MAX))) {
+                throw QString("The number \"%1\" at position %2 is too large.").arg(token.m_text).arg(token.m_position);
+            }
+
+            current++;
+            return value;
+        }
+
+        if (token.m_kind == queryToken::Word)
+        {
+            QString name = token.m_text.toLower();
+            int value = 0;
+
+            if (field == CWeatherQuery::WindField) {
+                value = static_cast<int>(convertTextToWindDir(token.m_text.toUpper()));
+            } else if (field == CWeatherQuery::SeasonField) {
+                static const QStringList seasonNames = { "winter", "spring", "summer", "autumn" };
+                value = seasonNames.indexOf(name) + 1;
+            } else if (field == CWeatherQuery::MonthField) {
+                static const QStringList monthNames = { "january", "february", "march", "april", "may", "june", "july",
+                                                        "august", "september", "october", "november", "december" };
+                for (int i = 0; i < monthNames.size() && value == 0; ++i) {
+                    if (name.size() >= 3 && monthNames[i].startsWith(name)) {
+                        value = i + 1;
+                    }
+                }
+            }
+
+            if (value != 0) {
+                current++;
+                return value;
+            }
+        }
+
+        throw QString("Expected a value at position %1.").arg(token.m_position);
+    }
+};
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// Copies the values of a field of the viewed days into a contiguous array.
+static std::vector<int> getFieldColumn(const WeatherView& weather, CWeatherQuery::queryField field)
+{
+    switch (field) {
+    case CWeatherQuery::TemperatureField:
+        return weather.getColumn(TemperatureColumn);
+    case CWeatherQuery::PressureField:
+        return weather.getColumn(PressureColumn);
+    case CWeatherQuery::HumidityField:
+        return weather.getColumn(HumidityColumn);
+    default:
+        break;
+    }
+
+    std::vector<int> values(weather.getWeatherSize());
+
+    for (int i = 0; i < values.size(); ++i)
+    {
+        const CWather::weatherData& wData = weather.at(i);
+
+        switch (field) {
+        case CWeatherQuery::YearField:
+            values[i] = wData.m_year;
+            break;
+        case CWeatherQuery::MonthField:
+            values[i] = static_cast<int>(wData.m_month);
+            break;
+        case CWeatherQuery::DayField:
+            values[i] = static_cast<int>(wData.m_day);
+            break;
+        case CWeatherQuery::WindField:
+            values[i] = static_cast<int>(wData.m_windDirection);
+            break;
+        default:
+            values[i] = wData.m_month == Month::Unknown ? 0 : static_cast<int>(getSeason(wData.m_month));
+            break;
+        }
+    }
+
+    return values;
+}
+
+
+// Compares every value of a column with a constant and writes the results into a bitmap.
+template <typename Value, typename Compare>
+static void scanColumn(const std::vector<Value>& values, Value constant, Compare compare, CSelectionBitmap& selection)
+{
+    const Value* data = values.data();
+    int fullWordCount = static_cast<int>(values.size()) / 64;
+
+    // Build whole words without branches, so the inner loop is vectorized.
+    for (int w = 0; w < fullWordCount; ++w)
+    {
+        const Value* block = data + w * 64;
+        quint64 bits = 0;
+
+        for (int b = 0; b < 64; ++b) {
+            bits |= static_cast<quint64>(compare(block[b], constant)) << b;
+        }
+
+        selection.words[w] = bits;
+    }
+
+    // The last, incomplete word.
+    for (int i = fullWordCount * 64; i < values.size(); ++i) {
+        if (compare(data[i], constant)) {
+            selection.words[i >> 6] |= quint64(1) << (i & 63);
+        }
+    }
+}
+
+
+// Compares every value of a column with a constant and writes the results into a bitmap.
+template <typename Value>
+static void scanComparison(const std::vector<Value>& values, CWeatherQuery::compareOperator compareOperator, Value constant,
+                           CSelectionBitmap& selection)
+{
+    switch (compareOperator) {
+    case CWeatherQuery::Equal:
+        scanColumn(values, constant, std::equal_to<Value>(), selection);
+        break;
+    case CWeatherQuery::NotEqual:
+        // Written with < and >, so days without a value (NaN) match no comparison.
+        scanColumn(values, constant, [](Value a, Value b) { return a < b || a > b; }, selection);
+        break;
+    case CWeatherQuery::Less:
+        scanColumn(values, constant, std::less<Value>(), selection);
+        break;
+    case CWeatherQuery::LessOrEqual:
+        scanColumn(values, constant, std::less_equal<Value>(), selection);
+        break;
+    case CWeatherQuery::Greater:
+        scanColumn(values, constant, std::greater<Value>(), selection);
+        break;
+    case CWeatherQuery::GreaterOrEqual:
+        scanColumn(values, constant, std::greater_equal<Value>(), selection);
+        break;
+    }
+}
+
+
+// Evaluates a node of a compiled expression (columns are copied from the view on first use; derived columns are kept as
+// real numbers).
+static CSelectionBitmap evaluateNode(const CWeatherQuery::queryNode& node, const WeatherView& weather,
+                                     std::vector<std::vector<int>>& columns, std::vector<std::vector<double>>& derivedColumns)
+{
+    using queryNode = CWeatherQuery::queryNode;
+
+    switch (node.m_kind) {
+    case queryNode::And: {
+        CSelectionBitmap selection = evaluateNode(*node.m_left, weather, columns, derivedColumns);
+        selection &= evaluateNode(*node.m_right, weather, columns, derivedColumns);
+        return selection;
+    }
+    case queryNode::Or: {
+        CSelectionBitmap selection = evaluateNode(*node.m_left, weather, columns, derivedColumns);
+        selection |= evaluateNode(*node.m_right, weather, columns, derivedColumns);
+        return selection;
+    }
+    case queryNode::Not: {
+        CSelectionBitmap selection = evaluateNode(*node.m_left, weather, columns, derivedColumns);
+        selection.invert();
+        return selection;
+    }
+    default:
+        break;
+    }
+
+    CSelectionBitmap selection(weather.getWeatherSize());
+
+    if (node.m_field >= CWeatherQuery::DewPointField)
+    {
+        DerivedColumn derivedColumn = static_cast<DerivedColumn>(DewPointColumn + node.m_field - CWeatherQuery::DewPointField);
+
+        std::vector<double>& column = derivedColumns[derivedColumn - DewPointColumn];
+        if (column.empty()) {
+            column = weather.getDerivedColumn(derivedColumn);
+        }
+
+        scanComparison(column, node.m_operator, node.m_value, selection);
+        return selection;
+    }
+
+    // A constant with a fraction is compared with the whole numbers of the column as the nearest whole number on the side
+    // that selects the same days (no whole number equals it).
+    CWeatherQuery::compareOperator compareOperator = node.m_operator;
+    double constant = node.m_value;
+
+    if (constant != std::floor(constant))
+    {
+        switch (compareOperator) {
+        case CWeatherQuery::Equal:
+            return selection;
+        case CWeatherQuery::NotEqual:
+            selection.invert();
+            return selection;
+        case CWeatherQuery::Less:
+        case CWeatherQuery::LessOrEqual:
+            compareOperator = CWeatherQuery::LessOrEqual;
+            constant = std::floor(constant);
+            break;
+        default:
+            compareOperator = CWeatherQuery::GreaterOrEqual;
+            constant = std::ceil(constant);
+            break;
+        }
+    }
+
+    std::vector<int>& column = columns[node.m_field];
+    if (column.empty()) {
+        column = getFieldColumn(weather, node.m_field);
+    }
+
+    scanComparison(column, compareOperator, static_cast<int>(constant), selection);
+
+    return selection;
+}
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// Parses and compiles the expression.
+CWeatherQuery::CWeatherQuery(const QString& expression) : expression(expression)
+{
+    root = queryParser(expression).parse();
+}
+
+
+// Used to get the text of the expression.
+QString CWeatherQuery::getExpression() const
+{
+    return expression;
+}
+
+
+// Finds the days that match the expression (as a bitmap).
+CSelectionBitmap CWeatherQuery::evaluate(const WeatherView& weather) const
+{
+    std::vector<std::vector<int>> columns(FIELD_CNT);
+    std::vector<std::vector<double>> derivedColumns(CDerivedColumns::COLUMN_CNT);
+    return evaluateNode(*root, weather, columns, derivedColumns);
+}
+
+
+// Finds the days that match the expression (as a view).
+WeatherView CWeatherQuery::select(const WeatherView& weather) const
+{
+    return weather.getSelection(evaluate(weather).getSelectedIndexes());
+}
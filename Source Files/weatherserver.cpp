@@ -0,0 +1,675 @@
+#include "../Header Files/weatherserver.h"
+#include "../Header Files/forecastengine.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QThreadPool>
+#include <algorithm>
+
+
+// The longest request line (a longer one closes the connection).
+static const qint64 MAX_REQUEST_SIZE = 1 << 16;
+
+
+// Parses the index of a station.
+static int parseStation(const QByteArray& word, int stationCount)
+{
+    bool isOk;
+    int index = word.toInt(&isOk);
+
+    if (!isOk || index < 0 || index >= stationCount) {
+        throw QString("There is no station %1.").arg(QString::fromUtf8(word));
+    }
+
+    return index;
+}
+
+
+// Parses a date (yyyy-MM-dd).
+static QDate parseDate(const QByteArray& word)
+{
+    QDate date = QDate::fromString(QString::fromLatin1(word), "yyyy-MM-dd");
+
+    if (!date.isValid()) {
+        throw QString("Invalid date %1 (expected yyyy-MM-dd).").arg(QString::fromUtf8(word));
+    }
+
+    return date;
+}
+
+
+// Writes a date (yyyy-MM-dd, or "-" for no date).
+static QByteArray formatDate(QDate date)
+{
+    return date.isValid() ? date.toString("yyyy-MM-dd").toLatin1() : QByteArray("-");
+}
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// Constructor with parameters.
+CWeatherServer::CWeatherServer(const std::vector<CWeatherDataset::station>& stations, QObject* parent)
+    : QObject(parent), stations(stations), stationDates(stations.size()), isBatchRunning(false)
+{
+    // Days in date order are found by binary search; the others are scanned.
+    for (int i = 0; i < this->stations.size(); ++i)
+    {
+        WeatherView view = this->stations[i].m_weather.getView();
+        std::vector<qint64>& dates = stationDates[i];
+        dates.reserve(view.getWeatherSize());
+
+        for (int j = 0; j < view.getWeatherSize(); ++j) {
+            dates.push_back(view.getDate(j).toJulianDay());
+        }
+
+        if (!std::is_sorted(dates.begin(), dates.end())) {
+            std::vector<qint64>().swap(dates);
+        }
+    }
+
+    connect(&server, &QLocalServer::newConnection, this, &CWeatherServer::acceptConnections);
+    connect(&batchWatcher, &QFutureWatcher<QByteArray>::finished, this, &CWeatherServer::finishBatch);
+}
+
+
+// Starts accepting connections.
+void CWeatherServer::listen(const QString& serverName)
+{
+    QLocalServer::removeServer(serverName);
+
+    if (!server.listen(serverName)) {
+        throw QString("The server could not be started: %1").arg(server.errorString());
+    }
+}
+
+
+// Accepts the waiting connections.
+void CWeatherServer::acceptConnections()
+{
+    while (server.hasPendingConnections())
+    {
+        QLocalSocket* socket = server.nextPendingConnection();
+        connect(socket, &QLocalSocket::readyRead, this, &CWeatherServer::readRequests);
+        connect(socket, &QLocalSocket::disconnected, socket, &QLocalSocket::deleteLater);
+    }
+}
+
+
+// Collects the complete request lines of a connection.
+void CWeatherServer::readRequests()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+    if (socket == nullptr) {
+        return;
+    }
+
+    while (socket->canReadLine())
+    {
+        QByteArray line = socket->readLine().trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+
+        pendingRequest request;
+        request.m_socket = socket;
+
+        int spaceIndex = line.indexOf(' ');
+        request.m_id = spaceIndex < 0 ? line : line.left(spaceIndex);
+        request.m_query = spaceIndex < 0 ? QByteArray() : line.mid(spaceIndex + 1).simplified();
+
+        pendingRequests.push_back(request);
+    }
+
+    if (socket->bytesAvailable() > MAX_REQUEST_SIZE) {
+        socket->abort();
+    }
+
+    if (!isBatchRunning) {
+        startBatch();
+    }
+}
+
+
+// Starts answering the pending requests.
+void CWeatherServer::startBatch()
+{
+    if (pendingRequests.empty()) {
+        return;
+    }
+
+    batchRequests.swap(pendingRequests);
+    pendingRequests.clear();
+    batchQueries.clear();
+
+    // Equal queries are answered once.
+    QHash<QByteArray, int> queryIndexes;
+
+    for (pendingRequest& request : batchRequests)
+    {
+        auto found = queryIndexes.constFind(request.m_query);
+
+        if (found == queryIndexes.constEnd()) {
+            request.m_queryIndex = batchQueries.size();
+            queryIndexes.insert(request.m_query, request.m_queryIndex);
+            batchQueries.append(request.m_query);
+        }
+        else {
+            request.m_queryIndex = found.value();
+        }
+    }
+
+    isBatchRunning = true;
+    batchWatcher.setFuture(QtConcurrent::mapped(batchQueries, [this](const QByteArray& query) {
+        return answer(query);
+    }));
+}
+
+
+// Sends the answers of the finished batch and starts the next one.
+void CWeatherServer::finishBatch()
+{
+    QList<QByteArray> answers = batchWatcher.future().results();
+    isBatchRunning = false;
+
+    for (const pendingRequest& request : batchRequests) {
+        if (!request.m_socket.isNull()) {
+            request.m_socket->write(request.m_id + " " + answers[request.m_queryIndex] + "\n");
+        }
+    }
+
+    batchRequests.clear();
+    startBatch();
+}
+
+
+// Used to get the days of a station within a period.
+WeatherView CWeatherServer::getPeriod(int stationIndex, QDate startDate, QDate endDate) const
+{
+    const CWather& weather = stations[stationIndex].m_weather;
+    const std::vector<qint64>& dates = stationDates[stationIndex];
+
+    if (dates.empty()) {
+        return weather.getViewByPeriod(startDate, endDate);
+    }
+
+    auto first = std::lower_bound(dates.begin(), dates.end(), startDate.toJulianDay());
+    auto last = std::upper_bound(first, dates.end(), endDate.toJulianDay());
+
+    return weather.getView().getSubView(first - dates.begin(), last - first);
+}
+
+
+// Answers a query.
+QByteArray CWeatherServer::answer(const QByteArray& query) const
+{
+    QList<QByteArray> words = query.split(' ');
+    const QByteArray& command = words.front();
+    int stationCount = stations.size();
+
+    try {
+        if (command == "info" && words.size() == 1)
+        {
+            QByteArray result = "ok " + QByteArray::number(stationCount);
+
+            for (const CWeatherDataset::station& stationData : stations) {
+                WeatherView view = stationData.m_weather.getView();
+                int dayCount = view.getWeatherSize();
+                result += " " + QByteArray::number(dayCount) + " " + formatDate(dayCount == 0 ? QDate() : view.getDate(0))
+                          + " " + formatDate(dayCount == 0 ? QDate() : view.getDate(dayCount - 1));
+            }
+
+            return result;
+        }
+
+        if (command == "forecast" && words.size() == 4)
+        {
+            const CWather& weather = stations[parseStation(words[1], stationCount)].m_weather;
+
+            bool isOk, isSeedOk;
+            int dayCount = words[2].toInt(&isOk);
+            quint64 seed = words[3].toULongLong(&isSeedOk);
+
+            if (!isOk || !isSeedOk || dayCount < 1 || dayCount > 3660) {
+                throw QString("Expected the number of days (1 - 3660) and the seed.");
+            }
+            if (weather.getWeatherSize() == 0) {
+                throw QString("The station has no days.");
+            }
+
+            WeatherView view = weather.getView();
+            CRandomStream random(seed);
+            std::vector<CWather::weatherData> forecast = weather.getForecastEngine()->forecast(view.getDate(view.getWeatherSize() - 1).addDays(1),
+                                                                                                dayCount, random);
+
+            QByteArray result = "ok " + QByteArray::number(static_cast<int>(forecast.size()));
+            for (const CWather::weatherData& wData : forecast) {
+                result += " " + formatDate(QDate(wData.m_year, wData.m_month, wData.m_day)) + "," + QByteArray::number(wData.m_temperature)
+                          + "," + QByteArray::number(wData.m_pressure) + "," + QByteArray::number(wData.m_humidity) + ","
+                          + convertWindDirToText(wData.m_windDirection).toLatin1();
+            }
+
+            return result;
+        }
+
+        // The other queries are about the days of a station within a period.
+        bool isStableQuery = command == "stable" && (words.size() == 4 || words.size() == 6);
+        if (!isStableQuery && words.size() != 4) {
+            throw QString("Unknown query.");
+        }
+
+        WeatherView period = getPeriod(parseStation(words[1], stationCount), parseDate(words[2]), parseDate(words[3]));
+        int dayCount = period.getWeatherSize();
+
+        if (command == "avg" || command == "extremes")
+        {
+            if (dayCount == 0) {
+                throw QString("There are no days in the period.");
+            }
+
+            if (command == "avg") {
+                return "ok " + QByteArray::number(dayCount) + " " + QByteArray::number(period.getAvgTemperature(), 'f', 2) + " "
+                       + QByteArray::number(period.getAvgPressure(), 'f', 2);
+            }
+
+            int minT = period.getTemperature(0), maxT = minT;
+            unsigned minPsre = period.getPressure(0), maxPsre = minPsre;
+            int minHumidity = period.getHumidity(0), maxHumidity = minHumidity;
+
+            for (int i = 1; i < dayCount; ++i) {
+                minT = std::min(minT, period.getTemperature(i));
+                maxT = std::max(maxT, period.getTemperature(i));
+                minPsre = std::min(minPsre, period.getPressure(i));
+                maxPsre = std::max(maxPsre, period.getPressure(i));
+                minHumidity = std::min(minHumidity, period.getHumidity(i));
+                maxHumidity = std::max(maxHumidity, period.getHumidity(i));
+            }
+
+            return "ok " + QByteArray::number(dayCount) + " " + QByteArray::number(minT) + " " + QByteArray::number(maxT) + " "
+                   + QByteArray::number(minPsre) + " " + QByteArray::number(maxPsre) + " " + QByteArray::number(minHumidity)
+                   + " " + QByteArray::number(maxHumidity);
+        }
+
+        if (command == "wind")
+        {
+            std::vector<std::vector<unsigned>> periods = period.findDaysWindNotChange();
+
+            int longestIndex = -1;
+            for (int i = 0; i < periods.size(); ++i) {
+                if (longestIndex == -1 || periods[i].size() > periods[longestIndex].size()) {
+                    longestIndex = i;
+                }
+            }
+
+            return "ok " + QByteArray::number(static_cast<int>(periods.size())) + " "
+                   + QByteArray::number(longestIndex == -1 ? 0 : static_cast<int>(periods[longestIndex].size())) + " "
+                   + formatDate(longestIndex == -1 ? QDate() : period.getDate(periods[longestIndex].front()));
+        }
+
+        if (isStableQuery)
+        {
+            double tRangePct = CWather::STABLE_T_RANGE_PCT, psreRangePct = CWather::STABLE_PSRE_RANGE_PCT;
+
+            if (words.size() == 6) {
+                bool isTOk, isPsreOk;
+                tRangePct = words[4].toDouble(&isTOk);
+                psreRangePct = words[5].toDouble(&isPsreOk);
+
+                if (!isTOk || !isPsreOk || tRangePct < 0 || psreRangePct < 0) {
+                    throw QString("Expected the percentages of t and pressure.");
+                }
+            }
+
+            std::vector<WeatherView> periods = period.findPeriodTemperatureAndPressureChangeWithinRange(tRangePct, psreRangePct);
+
+            int longestIndex = -1;
+            for (int i = 0; i < periods.size(); ++i) {
+                if (longestIndex == -1 || periods[i].getWeatherSize() > periods[longestIndex].getWeatherSize()) {
+                    longestIndex = i;
+                }
+            }
+
+            return "ok " + QByteArray::number(static_cast<int>(periods.size())) + " "
+                   + QByteArray::number(longestIndex == -1 ? 0 : periods[longestIndex].getWeatherSize()) + " "
+                   + formatDate(longestIndex == -1 ? QDate() : periods[longestIndex].getDate(0));
+        }
+
+        throw QString("Unknown query.");
+    } catch (const QString& exception) {
+        return "error " + exception.toUtf8();
+    }
+}
+
+
+// Runs the server from the command line.
+int CWeatherServer::runCommandLine(const QStringList& arguments)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Keeps weather files in memory and answers queries over a local socket.");
+    parser.addHelpOption();
+
+    QCommandLineOption serveOption("serve", "Run the query server (without opening the window).");
+    QCommandLineOption nameOption("name", "The name of the local socket (\"weather\" by default).", "name", "weather");
+    parser.addOption(serveOption);
+    parser.addOption(nameOption);
+    parser.addPositionalArgument("files", "The served files (the stations of all files are served).", "<files...>");
+
+    if (!parser.parse(arguments)) {
+        err << parser.errorText() << "\n";
+        return 1;
+    }
+
+    if (parser.isSet("help")) {
+        out << parser.helpText();
+        return 0;
+    }
+
+    QStringList files = parser.positionalArguments();
+    if (files.isEmpty()) {
+        err << parser.helpText();
+        return 1;
+    }
+
+    // The stations of all files, in the order of the files.
+    std::vector<CWeatherDataset::station> stations;
+    qint64 dayCount = 0;
+
+    for (const QString& fileName : files)
+    {
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            err << fileName << ": File could not be opened.\n";
+            return 1;
+        }
+
+        CWeatherDataset dataset;
+        QTextStream in(&file);
+
+        try {
+            in >> dataset;
+        } catch (const QString& exception) {
+            err << fileName << ": " << exception << "\n";
+            return 1;
+        }
+
+        for (int i = 0; i < dataset.getStationCount(); ++i)
+        {
+            CWeatherDataset::station stationData = dataset.getStation(i);
+            if (stationData.m_id.isEmpty()) {
+                stationData.m_id = QFileInfo(fileName).completeBaseName();
+            }
+
+            dayCount += stationData.m_weather.getWeatherSize();
+            stations.push_back(stationData);
+        }
+    }
+
+    CWeatherServer server(stations);
+
+    try {
+        server.listen(parser.value(nameOption));
+    } catch (const QString& exception) {
+        err << exception << "\n";
+        return 1;
+    }
+
+    out << "Serving " << stations.size() << " stations (" << dayCount << " days) on " << server.server.fullServerName() << "\n";
+    for (int i = 0; i < stations.size(); ++i) {
+        out << "  " << i << ": " << stations[i].m_id << "\n";
+    }
+    out.flush();
+
+    return QCoreApplication::exec();
+}
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// A period of a station that random queries are asked about.
+struct stationRange
+{
+    int m_index;
+    qint64 m_firstDay, m_lastDay;
+};
+
+
+// Makes a random query about a random period of a random station.
+static QByteArray makeRandomQuery(CRandomStream& random, const std::vector<stationRange>& ranges)
+{
+    const stationRange& range = ranges[random.next() % ranges.size()];
+    QByteArray station = QByteArray::number(range.m_index);
+
+    // Forecasts are rarer (and longer to answer) than the queries about periods.
+    double kind = random.nextDouble();
+    if (kind < 0.05) {
+        return "forecast " + station + " 30 " + QByteArray::number(random.next() % 1000);
+    }
+
+    // A period of 1 month to 1 year within the days of the station.
+    qint64 length = 30 + random.next() % 336;
+    qint64 firstDay = range.m_firstDay + random.next() % std::max<qint64>(range.m_lastDay - range.m_firstDay - length + 2, 1);
+    QByteArray period = " " + formatDate(QDate::fromJulianDay(firstDay)) + " " + formatDate(QDate::fromJulianDay(firstDay + length - 1));
+
+    if (kind < 0.35) {
+        return "avg " + station + period;
+    }
+    if (kind < 0.6) {
+        return "extremes " + station + period;
+    }
+    if (kind < 0.8) {
+        return "wind " + station + period;
+    }
+    return "stable " + station + period;
+}
+
+
+// Runs a load test.
+CWeatherLoadGenerator::loadSummary CWeatherLoadGenerator::run(const QString& serverName, int connectionCount, int requestCount,
+                                                              int pipelineDepth, quint64 seed)
+{
+    // Ask the server about its stations.
+    std::vector<stationRange> ranges;
+    {
+        QLocalSocket socket;
+        socket.connectToServer(serverName);
+        if (!socket.waitForConnected(5000)) {
+            throw QString("The server \"%1\" could not be reached: %2").arg(serverName, socket.errorString());
+        }
+
+        socket.write("0 info\n");
+        while (!socket.canReadLine()) {
+            if (!socket.waitForReadyRead(10000)) {
+                throw QString("The server did not answer: %1").arg(socket.errorString());
+            }
+        }
+
+        QList<QByteArray> words = socket.readLine().trimmed().split(' ');
+        if (words.size() < 3 || words[1] != "ok" || words.size() != 3 + 3 * words[2].toInt()) {
+            throw QString("Unexpected answer of the server.");
+        }
+
+        for (int i = 0; i < words[2].toInt(); ++i) {
+            if (words[3 + 3 * i].toInt() > 0) {
+                ranges.push_back({i, parseDate(words[4 + 3 * i]).toJulianDay(), parseDate(words[5 + 3 * i]).toJulianDay()});
+            }
+        }
+
+        if (ranges.empty()) {
+            throw QString("The server has no days.");
+        }
+    }
+
+    // Every connection runs in its own thread and measures the latencies of its requests.
+    struct connectionResult
+    {
+        std::vector<double> m_latencies;
+        qint64 m_errorCount = 0;
+        QString m_error;
+    };
+
+    auto runConnection = [&](int connectionIndex) {
+        connectionResult result;
+        result.m_latencies.reserve(requestCount);
+
+        QLocalSocket socket;
+        socket.connectToServer(serverName);
+        if (!socket.waitForConnected(5000)) {
+            result.m_error = socket.errorString();
+            return result;
+        }
+
+        CRandomStream random(seed, connectionIndex);
+        std::vector<qint64> sendTimes(requestCount);
+        QElapsedTimer clock;
+        clock.start();
+
+        int sentCount = 0;
+        while (result.m_latencies.size() < requestCount)
+        {
+            // Keep the pipeline full.
+            while (sentCount < requestCount && sentCount - static_cast<int>(result.m_latencies.size()) < pipelineDepth) {
+                sendTimes[sentCount] = clock.nsecsElapsed();
+                socket.write(QByteArray::number(sentCount) + " " + makeRandomQuery(random, ranges) + "\n");
+                sentCount++;
+            }
+            socket.flush();
+
+            while (!socket.canReadLine()) {
+                if (!socket.waitForReadyRead(30000)) {
+                    result.m_error = "The server did not answer: " + socket.errorString();
+                    return result;
+                }
+            }
+
+            while (socket.canReadLine())
+            {
+                QByteArray line = socket.readLine();
+                int id = line.left(line.indexOf(' ')).toInt();
+
+                result.m_latencies.push_back((clock.nsecsElapsed() - sendTimes[id]) / 1000.0);
+                if (line.indexOf(" error ") != -1) {
+                    result.m_errorCount++;
+                }
+            }
+        }
+
+        return result;
+    };
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(connectionCount);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    std::vector<QFuture<connectionResult>> connections;
+    for (int i = 0; i < connectionCount; ++i) {
+        connections.push_back(QtConcurrent::run(&pool, runConnection, i));
+    }
+
+    // Wait for all the connections (they use the local variables) and merge their latencies.
+    std::vector<connectionResult> results;
+    for (QFuture<connectionResult>& connection : connections) {
+        results.push_back(connection.result());
+    }
+
+    loadSummary summary;
+    summary.m_seconds = timer.nsecsElapsed() / 1e9;
+
+    std::vector<double> latencies;
+
+    for (const connectionResult& result : results)
+    {
+        if (!result.m_error.isEmpty()) {
+            throw result.m_error;
+        }
+
+        latencies.insert(latencies.end(), result.m_latencies.begin(), result.m_latencies.end());
+        summary.m_errorCount += result.m_errorCount;
+    }
+
+    summary.m_requestCount = latencies.size();
+
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+
+        auto percentile = [&latencies](double fraction) {
+            return latencies[std::min<size_t>(static_cast<size_t>(fraction * latencies.size()), latencies.size() - 1)];
+        };
+
+        summary.m_p50 = percentile(0.5);
+        summary.m_p90 = percentile(0.9);
+        summary.m_p99 = percentile(0.99);
+        summary.m_max = latencies.back();
+    }
+
+    return summary;
+}
+
+
+// Runs a load test from the command line.
+int CWeatherLoadGenerator::runCommandLine(const QStringList& arguments)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures the throughput and the latency of the query server.");
+    parser.addHelpOption();
+
+    QCommandLineOption loadTestOption("load-test", "Run the load test (without opening the window).");
+    QCommandLineOption nameOption("name", "The name of the local socket of the server (\"weather\" by default).", "name", "weather");
+    QCommandLineOption connectionsOption("connections", "The number of connections (8 by default).", "n", "8");
+    QCommandLineOption requestsOption("requests", "The number of requests of every connection (1000 by default).", "n", "1000");
+    QCommandLineOption pipelineOption("pipeline", "The number of requests in flight on a connection (8 by default).", "n", "8");
+    QCommandLineOption seedOption("seed", "The seed of the random queries (1 by default).", "n", "1");
+    parser.addOption(loadTestOption);
+    parser.addOption(nameOption);
+    parser.addOption(connectionsOption);
+    parser.addOption(requestsOption);
+    parser.addOption(pipelineOption);
+    parser.addOption(seedOption);
+
+    if (!parser.parse(arguments)) {
+        err << parser.errorText() << "\n";
+        return 1;
+    }
+
+    if (parser.isSet("help")) {
+        out << parser.helpText();
+        return 0;
+    }
+
+    bool isConnectionsOk, isRequestsOk, isPipelineOk, isSeedOk;
+    int connectionCount = parser.value(connectionsOption).toInt(&isConnectionsOk);
+    int requestCount = parser.value(requestsOption).toInt(&isRequestsOk);
+    int pipelineDepth = parser.value(pipelineOption).toInt(&isPipelineOk);
+    quint64 seed = parser.value(seedOption).toULongLong(&isSeedOk);
+
+    if (!isConnectionsOk || !isRequestsOk || !isPipelineOk || !isSeedOk || connectionCount < 1 || requestCount < 1 || pipelineDepth < 1) {
+        err << parser.helpText();
+        return 1;
+    }
+
+    try {
+        loadSummary summary = run(parser.value(nameOption), connectionCount, requestCount, pipelineDepth, seed);
+
+        out << "Requests: " << summary.m_requestCount << " (errors: " << summary.m_errorCount << ")\n"
+            << "Time: " << QString::number(summary.m_seconds, 'f', 3) << " s\n"
+            << "Throughput: " << QString::number(summary.m_requestCount / summary.m_seconds, 'f', 0) << " requests/s\n"
+            << "Latency p50 / p90 / p99 / max: " << QString::number(summary.m_p50, 'f', 0) << " / "
+            << QString::number(summary.m_p90, 'f', 0) << " / " << QString::number(summary.m_p99, 'f', 0) << " / "
+            << QString::number(summary.m_max, 'f', 0) << " us\n";
+    } catch (const QString& exception) {
+        err << exception << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,636 @@
+#include "../Header Files/weatherstream.h"
+#include "../Header Files/weatherview.h"
+#include <QtEndian>
+#include <climits>
+#include <cstring>
+#include <cstdio>
+
+
+// The first bytes of a binary weather file.
+static const char BINARY_SIGNATURE[] = "WTHRBIN1";
+static const int BINARY_SIGNATURE_SIZE = 8;
+
+
+// Converts the text of a wind direction to the corresponding enum (same as convertTextToWindDir, without a QString).
+static WindDirection parseWindDirection(const char* text, int length)
+{
+    if (length == 1) {
+        switch (text[0]) {
+        case 'N': return North;
+        case 'S': return South;
+        case 'E': return East;
+        case 'W': return West;
+        }
+    }
+    else if (length == 2 && (text[0] == 'N' || text[0] == 'S')) {
+        if (text[1] == 'E') {
+            return text[0] == 'N' ? Northeast : Southeast;
+        }
+        if (text[1] == 'W') {
+            return text[0] == 'N' ? Northwest : Southwest;
+        }
+    }
+
+    return Undefined;
+}
+
+
+// Parses an integer at the position (after blanks); moves the position after it. A number that does not fit an int is not
+// an integer (as for QString::toInt).
+static bool parseInteger(const char*& position, const char* end, int& value)
+{
+    while (position != end && (*position == ' ' || *position == '\t')) {
+        position++;
+    }
+
+    bool isNegative = position != end && *position == '-';
+    if (position != end && (*position == '-' || *position == '+')) {
+        position++;
+    }
+
+    if (position == end || *position < '0' || *position > '9') {
+        return false;
+    }
+
+    long long limit = isNegative ? -static_cast<long long>(INT_MIN) : INT_MAX;
+    long long result = 0;
+    while (position != end && *position >= '0' && *position <= '9') {
+        result = result * 10 + (*position - '0');
+        position++;
+
+        if (result > limit) {
+            return false;
+        }
+    }
+
+    value = static_cast<int>(isNegative ? -result : result);
+    return true;
+}
+
+
+// Kinds of lines of text files.
+enum textLineKind
+{
+    EmptyLine,
+    StationLine,
+    DayLine,
+    DamagedLine
+};
+
+
+// Parses one line of a text file (the day of a day line, the identifier of a station line if it is needed).
+static textLineKind parseTextLine(const char* line, const char* lineEnd, CWather::weatherData& wData, QString* stationId = nullptr)
+{
+    // Skip blanks and the carriage return of Windows line ends.
+    while (lineEnd != line && (lineEnd[-1] == '\r' || lineEnd[-1] == ' ' || lineEnd[-1] == '\t')) {
+        lineEnd--;
+    }
+    while (line != lineEnd && (*line == ' ' || *line == '\t')) {
+        line++;
+    }
+
+    if (line == lineEnd) {
+        return EmptyLine;
+    }
+
+    if (lineEnd - line >= 7 && memcmp(line, "station", 7) == 0 && (lineEnd - line == 7 || line[7] == ' ' || line[7] == '\t')) {
+        if (stationId != nullptr) {
+            *stationId = QString::fromUtf8(line + 7, lineEnd - line - 7).trimmed();
+        }
+        return StationLine;
+    }
+
+    // Six numbers and the wind direction.
+    int values[6];
+    for (int& value : values) {
+        if (!parseInteger(line, lineEnd, value)) {
+            return DamagedLine;
+        }
+    }
+
+    while (line != lineEnd && (*line == ' ' || *line == '\t')) {
+        line++;
+    }
+
+    const char* windText = line;
+    while (line != lineEnd && *line != ' ' && *line != '\t') {
+        line++;
+    }
+
+    if (windText == line || line != lineEnd) {
+        return DamagedLine;
+    }
+
+    wData = CWather::weatherData(values[0], static_cast<Month>(values[1]), values[2], values[3], values[4], values[5],
+                                 parseWindDirection(windText, line - windText));
+    return DayLine;
+}
+
+
+// Opens the file and detects its format.
+CWeatherFileReader::CWeatherFileReader(const QString& fileName, int blockSize)
+    : file(fileName), position(0), blockSize(blockSize), binary(false), isFileEnd(false), lineNumber(0), stationNumber(0)
+{
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw QString("File could not be opened.");
+    }
+
+    readNextBlock();
+
+    if (buffer.size() >= BINARY_SIGNATURE_SIZE && memcmp(buffer.constData(), BINARY_SIGNATURE, BINARY_SIGNATURE_SIZE) == 0) {
+        binary = true;
+        position = BINARY_SIGNATURE_SIZE;
+    }
+}
+
+
+// Keeps the unread bytes of the buffer and appends the next block of the file to them.
+bool CWeatherFileReader::readNextBlock()
+{
+    if (isFileEnd) {
+        return false;
+    }
+
+    buffer.remove(0, position);
+    position = 0;
+
+    int unreadSize = buffer.size();
+    buffer.resize(unreadSize + blockSize);
+    qint64 readSize = file.read(buffer.data() + unreadSize, blockSize);
+
+    if (readSize < 0) {
+        throw QString("The file could not be read.");
+    }
+
+    buffer.resize(unreadSize + readSize);
+    isFileEnd = readSize == 0;
+
+    return readSize != 0;
+}
+
+
+// Reads the next day of the file.
+bool CWeatherFileReader::readDay(CWather::weatherData& wData)
+{
+    if (binary)
+    {
+        while (buffer.size() - position < BINARY_RECORD_SIZE && readNextBlock()) {
+        }
+
+        if (buffer.size() - position < BINARY_RECORD_SIZE) {
+            if (buffer.size() != position) {
+                throw QString("The file ends in the middle of a day.");
+            }
+            return false;
+        }
+
+        // Decode the record.
+        const uchar* record = reinterpret_cast<const uchar*>(buffer.constData()) + position;
+        wData.m_year = qFromLittleEndian<qint32>(record);
+        wData.m_month = static_cast<Month>(record[4]);
+        wData.m_day = record[5];
+        wData.m_temperature = qFromLittleEndian<qint16>(record + 6);
+        wData.m_pressure = qFromLittleEndian<quint16>(record + 8);
+        wData.m_humidity = record[10];
+        wData.m_windDirection = static_cast<WindDirection>(record[11]);
+
+        position += BINARY_RECORD_SIZE;
+        return true;
+    }
+
+    // Text files are read line by line; a line split between blocks is completed by the next block.
+    while (true)
+    {
+        const char* data = buffer.constData();
+        const char* lineStart = data + position;
+        const char* bufferEnd = data + buffer.size();
+        const char* lineEnd = static_cast<const char*>(memchr(lineStart, '\n', bufferEnd - lineStart));
+
+        if (lineEnd == nullptr)
+        {
+            if (readNextBlock()) {
+                continue;
+            }
+
+            // The last line has no line end (the buffer may have moved while trying to read more).
+            data = buffer.constData();
+            lineStart = data + position;
+            bufferEnd = data + buffer.size();
+
+            if (lineStart == bufferEnd) {
+                return false;
+            }
+            lineEnd = bufferEnd;
+        }
+
+        lineNumber++;
+        position = lineEnd == bufferEnd ? buffer.size() : lineEnd - data + 1;
+
+        if (parseLine(lineStart, lineEnd, wData)) {
+            return true;
+        }
+    }
+}
+
+
+// Parses one line of a text file.
+bool CWeatherFileReader::parseLine(const char* line, const char* lineEnd, CWather::weatherData& wData)
+{
+    switch (parseTextLine(line, lineEnd, wData)) {
+    case DayLine:
+        return true;
+    case StationLine:
+        stationNumber++;
+        return false;
+    case EmptyLine:
+        return false;
+    default:
+        throw QString("Line %1: expected 7 values (year month day t pressure humidity wind direction).").arg(lineNumber);
+    }
+}
+
+
+// Used to get the number of station lines read so far.
+int CWeatherFileReader::getStationNumber() const
+{
+    return stationNumber;
+}
+
+
+// Determine if the file is in the binary format.
+bool CWeatherFileReader::isBinary() const
+{
+    return binary;
+}
+
+
+// Writes weather days to a file in the binary format.
+void CWeatherFileReader::writeBinary(const QString& fileName, const WeatherView& weather)
+{
+    CWeatherFileWriter writer(fileName, true);
+
+    for (int i = 0; i < weather.getWeatherSize(); ++i) {
+        writer.writeDay(weather.at(i));
+    }
+
+    writer.close();
+}
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// Opens the file for writing.
+CWeatherFileWriter::CWeatherFileWriter(const QString& fileName, bool binary, int blockSize)
+    : file(fileName), blockSize(blockSize), binary(binary), dayCount(0), isLineWritten(false)
+{
+    if (!file.open(binary ? QIODevice::WriteOnly : QIODevice::WriteOnly | QIODevice::Text)) {
+        throw QString("File could not be opened.");
+    }
+
+    buffer.reserve(blockSize + 64);
+
+    if (binary) {
+        buffer.append(BINARY_SIGNATURE, BINARY_SIGNATURE_SIZE);
+    }
+}
+
+
+// Adds a day to the file.
+void CWeatherFileWriter::writeDay(const CWather::weatherData& wData)
+{
+    if (binary)
+    {
+        if (wData.m_temperature < -32768 || wData.m_temperature > 32767 || wData.m_pressure > 65535
+            || wData.m_humidity < 0 || wData.m_humidity > 255 || wData.m_day > 255) {
+            throw QString("The day %1.%2.%3 cannot be written in the binary format (a value is out of range).")
+                .arg(wData.m_day).arg(static_cast<int>(wData.m_month)).arg(wData.m_year);
+        }
+
+        // Encode the record at the end of the buffer.
+        int recordStart = buffer.size();
+        buffer.resize(recordStart + CWeatherFileReader::BINARY_RECORD_SIZE);
+        uchar* record = reinterpret_cast<uchar*>(buffer.data()) + recordStart;
+
+        qToLittleEndian<qint32>(wData.m_year, record);
+        record[4] = static_cast<uchar>(wData.m_month);
+        record[5] = static_cast<uchar>(wData.m_day);
+        qToLittleEndian<qint16>(static_cast<qint16>(wData.m_temperature), record + 6);
+        qToLittleEndian<quint16>(static_cast<quint16>(wData.m_pressure), record + 8);
+        record[10] = static_cast<uchar>(wData.m_humidity);
+        record[11] = static_cast<uchar>(wData.m_windDirection);
+    }
+    else
+    {
+        // The same line as the << operator of CWather writes (days are separated by line ends).
+        static const char* const windTexts[] = {"Undefined", "N", "S", "E", "W", "NE", "NW", "SE", "SW"};
+        int wind = static_cast<int>(wData.m_windDirection);
+
+        char line[128];
+        int length = snprintf(line, sizeof(line), "%s%d %d %u %d %u %d %s", isLineWritten ? "\n" : "", wData.m_year,
+                              static_cast<int>(wData.m_month), wData.m_day, wData.m_temperature, wData.m_pressure,
+                              wData.m_humidity, windTexts[wind >= 1 && wind <= 8 ? wind : 0]);
+        buffer.append(line, length);
+        isLineWritten = true;
+    }
+
+    dayCount++;
+
+    if (buffer.size() >= blockSize) {
+        writeBuffer();
+    }
+}
+
+
+// Adds a station line to the file.
+void CWeatherFileWriter::writeStation(const QString& stationId)
+{
+    if (binary) {
+        throw QString("Stations cannot be written in the binary format.");
+    }
+
+    if (isLineWritten) {
+        buffer.append('\n');
+    }
+
+    buffer.append("station ");
+    buffer.append(stationId.toUtf8());
+    isLineWritten = true;
+
+    if (buffer.size() >= blockSize) {
+        writeBuffer();
+    }
+}
+
+
+// Writes the buffer to the file and clears it.
+void CWeatherFileWriter::writeBuffer()
+{
+    if (!buffer.isEmpty() && file.write(buffer) != buffer.size()) {
+        throw QString("The data has not been recorded!");
+    }
+
+    buffer.clear();
+}
+
+
+// Writes the days that have not been written yet and replaces the target file with the written one.
+void CWeatherFileWriter::close()
+{
+    if (!file.isOpen()) {
+        return;
+    }
+
+    try {
+        writeBuffer();
+    } catch (const QString&) {
+        file.cancelWriting();
+        file.commit();
+        throw;
+    }
+
+    // The data is flushed to the disk before the temporary file is renamed over the target.
+    if (!file.commit()) {
+        throw QString("The data has not been recorded!");
+    }
+}
+
+
+// Used to get the number of written days.
+qint64 CWeatherFileWriter::getDayCount() const
+{
+    return dayCount;
+}
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// Constructor with parameters.
+CWeatherFileFollower::CWeatherFileFollower(const QString& fileName, qint64 position, const QString& stationId)
+    : fileName(fileName), position(position), stationId(stationId)
+{}
+
+
+// Reads the days appended to the file since the last read.
+std::vector<CWeatherFileFollower::appendedDays> CWeatherFileFollower::readAppendedDays()
+{
+    std::vector<appendedDays> result;
+
+    // The file is opened for every read, so a file replaced by a new one is noticed.
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        throw QString("File could not be opened.");
+    }
+
+    qint64 fileSize = file.size();
+    if (fileSize < position) {
+        throw QString("The file has become shorter (it has been replaced); open it again.");
+    }
+    if (fileSize == position || !file.seek(position)) {
+        return result;
+    }
+
+    QByteArray appended = file.read(fileSize - position);
+    const char* data = appended.constData();
+    const char* dataEnd = data + appended.size();
+
+    // Only complete lines are read; the rest is read when its line end is written.
+    qsizetype lastLineEnd = appended.lastIndexOf('\n');
+    if (lastLineEnd < 0) {
+        return result;
+    }
+
+    QString lastStationId = stationId;
+    CWather::weatherData wData;
+
+    for (const char* line = data; line <= data + lastLineEnd; )
+    {
+        const char* lineEnd = static_cast<const char*>(memchr(line, '\n', dataEnd - line));
+
+        switch (parseTextLine(line, lineEnd, wData, &lastStationId)) {
+        case StationLine:
+            // A new station is reported even before its first day.
+            result.push_back({lastStationId, {}});
+            break;
+        case DayLine:
+            if (result.empty()) {
+                result.push_back({lastStationId, {}});
+            }
+            result.back().m_days.push_back(wData);
+            break;
+        case DamagedLine:
+            throw QString("An appended line is damaged: expected 7 values (year month day t pressure humidity wind direction).");
+        default:
+            break;
+        }
+
+        line = lineEnd + 1;
+    }
+
+    position += lastLineEnd + 1;
+    stationId = lastStationId;
+
+    return result;
+}
+
+
+// Used to get the size of the part of the file that has been read.
+qint64 CWeatherFileFollower::getPosition() const
+{
+    return position;
+}
+
+
+// Used to get the station of the last read station line.
+QString CWeatherFileFollower::getStationId() const
+{
+    return stationId;
+}
+
+
+// -------------------------------------------------------------------------------------------------------------------------
+
+
+// Constructor with parameters.
+CWeatherStreamAnalysis::CWeatherStreamAnalysis(QDate startDate, QDate endDate, double tRangePct, double psreRangePct)
+    : startDate(startDate), endDate(endDate), dayCount(0), tSum(0), psreSum(0), maxHumidity(0),
+      periodAnalysis(CFusedAnalysis::WindRunsAnalysis | CFusedAnalysis::StablePeriodsAnalysis, tRangePct, psreRangePct)
+{}
+
+
+// Adds the next day (days outside the date window are skipped).
+void CWeatherStreamAnalysis::addDay(const CWather::weatherData& wData)
+{
+    QDate date(wData.m_year, wData.m_month, wData.m_day);
+    if (!(date >= startDate && date <= endDate)) {
+        return;
+    }
+
+    // Averages.
+    dayCount++;
+    tSum += wData.m_temperature;
+    psreSum += wData.m_pressure;
+
+    // Highest humidity days.
+    if (wData.m_humidity > maxHumidity) {
+        maxHumidity = wData.m_humidity;
+        highestHumidityDays.clear();
+    }
+    if (wData.m_humidity == maxHumidity) {
+        highestHumidityDays.push_back(date);
+    }
+
+    // Periods when the wind direction did not change and when the pressure and temperature changed within the limits (the
+    // same rules as in WeatherView).
+    periodAnalysis.addDay(wData);
+    collectEndedPeriods();
+}
+
+
+// Ends the periods in progress.
+void CWeatherStreamAnalysis::startNewSeries()
+{
+    periodAnalysis.endSeries();
+    collectEndedPeriods();
+}
+
+
+// Analyses a file without loading it.
+CWeatherStreamAnalysis CWeatherStreamAnalysis::analyseFile(const QString& fileName, QDate startDate, QDate endDate)
+{
+    CWeatherFileReader reader(fileName);
+    CWeatherStreamAnalysis analysis(startDate, endDate);
+
+    CWather::weatherData wData;
+    int stationNumber = 0;
+
+    while (reader.readDay(wData))
+    {
+        // Periods do not continue from one station to the next.
+        if (reader.getStationNumber() != stationNumber) {
+            stationNumber = reader.getStationNumber();
+            analysis.startNewSeries();
+        }
+
+        analysis.addDay(wData);
+    }
+
+    analysis.startNewSeries();
+
+    return analysis;
+}
+
+
+// Used to get the number of analysed days.
+int CWeatherStreamAnalysis::getDayCount() const
+{
+    return dayCount;
+}
+
+
+// Used to get the average temperature.
+double CWeatherStreamAnalysis::getAvgTemperature() const
+{
+    return dayCount == 0 ? 0 : roundToHundredths(tSum / dayCount);
+}
+
+
+// Used to get the average pressure.
+double CWeatherStreamAnalysis::getAvgPressure() const
+{
+    return dayCount == 0 ? 0 : roundToHundredths(psreSum / dayCount);
+}
+
+
+// Used to get the highest humidity.
+int CWeatherStreamAnalysis::getMaxHumidity() const
+{
+    return maxHumidity;
+}
+
+
+// Used to get the dates of the days with the highest humidity.
+const std::vector<QDate>& CWeatherStreamAnalysis::getHighestHumidityDays() const
+{
+    return highestHumidityDays;
+}
+
+
+// Used to get the periods when the wind direction did not change.
+const std::vector<CWeatherStreamAnalysis::dayPeriod>& CWeatherStreamAnalysis::getWindPeriods() const
+{
+    return windPeriods;
+}
+
+
+// Used to get the periods when the pressure and temperature changed within the limits.
+const std::vector<CWeatherStreamAnalysis::dayPeriod>& CWeatherStreamAnalysis::getStablePeriods() const
+{
+    return stablePeriods;
+}
+
+
+// Adds the periods the period analysis has ended since the last call.
+void CWeatherStreamAnalysis::collectEndedPeriods()
+{
+    // Converts a range of days to a period with dates.
+    auto toDayPeriod = [](const CFusedAnalysis::dayRange& range) {
+        dayPeriod period;
+        period.m_firstDate = QDate(range.m_first.m_year, range.m_first.m_month, range.m_first.m_day);
+        period.m_lastDate = QDate(range.m_last.m_year, range.m_last.m_month, range.m_last.m_day);
+        period.m_dayCount = range.m_dayCount;
+        return period;
+    };
+
+    const std::vector<CFusedAnalysis::dayRange>& windRanges = periodAnalysis.getWindRunRanges();
+    for (int i = windPeriods.size(); i < windRanges.size(); ++i) {
+        windPeriods.push_back(toDayPeriod(windRanges[i]));
+        windPeriods.back().m_windDirection = windRanges[i].m_first.m_windDirection;
+    }
+
+    const std::vector<CFusedAnalysis::dayRange>& stableRanges = periodAnalysis.getStablePeriodRanges();
+    for (int i = stablePeriods.size(); i < stableRanges.size(); ++i) {
+        stablePeriods.push_back(toDayPeriod(stableRanges[i]));
+    }
+}
@@ -0,0 +1,465 @@
+#include "../Header Files/weatherview.h"
+#include "../Header Files/weathergaps.h"
+#include "../Header Files/derivedcolumns.h"
+#include "../Header Files/fusedanalysis.h"
+#include <cmath>
+
+
+// Default constructor (empty view).
+WeatherView::WeatherView() : rows(nullptr), offset(0), size(0)
+{}
+
+
+// Creates a view over all days of the weather object.
+WeatherView::WeatherView(const CWather& weather)
+    : storage(weather.d), rows(storage.constData()->weatherArr.data()), offset(0),
+    size(static_cast<int>(storage.constData()->weatherArr.size()))
+{}
+
+
+// Creates a view over the selected rows of the weather object.
+WeatherView::WeatherView(const CWather& weather, std::vector<int> rowIndexes)
+    : storage(weather.d), rows(storage.constData()->weatherArr.data()), offset(0), size(static_cast<int>(rowIndexes.size())),
+    rowIndexes(std::make_shared<const std::vector<int>>(std::move(rowIndexes)))
+{}
+
+
+// Used to get the number of days in the view.
+int WeatherView::getWeatherSize() const
+{
+    return size;
+}
+
+
+// Used to get the weather data for a certain day of the view.
+const CWather::weatherData& WeatherView::at(int index) const
+{
+    return rows[getRowIndex(index)];
+}
+
+
+// Used to get the temperature for a certain day of the view.
+int WeatherView::getTemperature(int index) const
+{
+    return at(index).m_temperature;
+}
+
+
+// Used to get the pressure for a certain day of the view.
+unsigned WeatherView::getPressure(int index) const
+{
+    return at(index).m_pressure;
+}
+
+
+// Used to get the humidity for a certain day of the view.
+int WeatherView::getHumidity(int index) const
+{
+    return at(index).m_humidity;
+}
+
+
+// Used to get the wind direction for a certain day of the view.
+WindDirection WeatherView::getWindDirection(int index) const
+{
+    return at(index).m_windDirection;
+}
+
+
+// Used to get the date of a certain day of the view.
+QDate WeatherView::getDate(int index) const
+{
+    const CWather::weatherData& wData = at(index);
+    return QDate(wData.m_year, wData.m_month, wData.m_day);
+}
+
+
+// Used to get the value of a weather column for a certain day of the view.
+int WeatherView::getColumnValue(WeatherColumn column, int index) const
+{
+    const CWather::weatherData& wData = at(index);
+
+    switch (column) {
+    case TemperatureColumn:
+        return wData.m_temperature;
+    case PressureColumn:
+        return static_cast<int>(wData.m_pressure);
+    case HumidityColumn:
+        return wData.m_humidity;
+    default:
+        return 0;
+    }
+}
+
+
+// Copies one weather column of the viewed days into a contiguous array.
+std::vector<int> WeatherView::getColumn(WeatherColumn column) const
+{
+    std::vector<int> values(size);
+
+    for (int i = 0; i < size; ++i) {
+        values[i] = getColumnValue(column, i);
+    }
+
+    return values;
+}
+
+
+// Used to get the value of a derived column for a certain day of the view.
+double WeatherView::getDerivedValue(DerivedColumn column, int index) const
+{
+    const CWather::WeatherStorage& weatherStorage = *storage.constData();
+    return CWather::getDerivedColumns(weatherStorage)->getValue(weatherStorage.weatherArr, column, getRowIndex(index));
+}
+
+
+// Copies one derived column of the viewed days into a contiguous array.
+std::vector<double> WeatherView::getDerivedColumn(DerivedColumn column) const
+{
+    std::vector<double> values(size);
+
+    if (size == 0) {
+        return values;
+    }
+
+    const CWather::WeatherStorage& weatherStorage = *storage.constData();
+    std::shared_ptr<const CDerivedColumns> derivedColumns = CWather::getDerivedColumns(weatherStorage);
+
+    // A contiguous range is copied block by block, a selection day by day.
+    if (!rowIndexes) {
+        derivedColumns->getValues(weatherStorage.weatherArr, column, offset, size, values.data());
+    } else {
+        for (int i = 0; i < size; ++i) {
+            values[i] = derivedColumns->getValue(weatherStorage.weatherArr, column, getRowIndex(i));
+        }
+    }
+
+    return values;
+}
+
+
+// Used to get a part of the view (constant time, no data is copied).
+WeatherView WeatherView::getSubView(int startIndex, int count) const
+{
+    WeatherView subView(*this);
+    subView.offset = offset + startIndex;
+    subView.size = count;
+    return subView;
+}
+
+
+// Used to get a selection of the viewed days (no weather data is copied, only the row indexes).
+WeatherView WeatherView::getSelection(const std::vector<int>& indexes) const
+{
+    std::vector<int> selectedRows(indexes.size());
+
+    for (int i = 0; i < indexes.size(); ++i) {
+        selectedRows[i] = getRowIndex(indexes[i]);
+    }
+
+    WeatherView selection(*this);
+    selection.offset = 0;
+    selection.size = static_cast<int>(selectedRows.size());
+    selection.rowIndexes = std::make_shared<const std::vector<int>>(std::move(selectedRows));
+    return selection;
+}
+
+
+// Used to get the row of the weather object a certain day of the view comes from.
+int WeatherView::getRowIndex(int index) const
+{
+    return rowIndexes ? (*rowIndexes)[offset + index] : offset + index;
+}
+
+
+// Copies the viewed days into a new weather object.
+CWather WeatherView::toWeather() const
+{
+    CWather weather;
+    std::vector<CWather::weatherData>& weatherArr = weather.d->weatherArr;
+    weatherArr.reserve(size);
+
+    for (int i = 0; i < size; ++i) {
+        weatherArr.push_back(at(i));
+    }
+
+    return weather;
+}
+
+
+// Fills the weather table.
+void WeatherView::completeTable(QTableWidget* weatherTable) const
+{
+    // The table is filled with all the viewed days.
+    weatherTable->setRowCount(0);
+    appendToTable(weatherTable, 0);
+}
+
+
+// Adds the viewed days from an index on to the end of the weather table.
+void WeatherView::appendToTable(QTableWidget* weatherTable, int firstIndex) const
+{
+    int firstRow = weatherTable->rowCount();
+
+    // Add a row for every day.
+    weatherTable->setRowCount(firstRow + size - firstIndex);
+
+    // Populate the new rows with weather data.
+    for (int i = firstIndex; i < size; ++i) {
+        const CWather::weatherData& wData = at(i);
+        int row = firstRow + i - firstIndex;
+        weatherTable->setItem(row, 0, new QTableWidgetItem(QString::number(wData.m_year)));
+        weatherTable->setItem(row, 1, new QTableWidgetItem(QString::number(static_cast<int>(wData.m_month))));
+        weatherTable->setItem(row, 2, new QTableWidgetItem(QString::number(wData.m_day)));
+        weatherTable->setItem(row, 3, new QTableWidgetItem(QString::number(wData.m_temperature)));
+        weatherTable->setItem(row, 4, new QTableWidgetItem(QString::number(wData.m_pressure)));
+        weatherTable->setItem(row, 5, new QTableWidgetItem(QString::number(wData.m_humidity)));
+        weatherTable->setItem(row, 6, new QTableWidgetItem(convertWindDirToText(wData.m_windDirection)));
+    }
+}
+
+
+// Draws a weather graph with weather data on the y-axis and dates on the x-axis.
+void WeatherView::buildWeatherGraph(std::function<double (int)> getWeatherData, const QString &graphTitle,
+                                    const std::vector<graphOverlay>& overlays) const
+{
+    std::vector<QDate> dates(size);
+
+    // The weather data is the first line of the graph and the overlays are drawn over it.
+    std::vector<graphOverlay> lines(1);
+    lines.front().m_name = graphTitle;
+    lines.front().m_values.resize(size);
+
+    for(int i = 0; i < size; ++i){
+        dates[i] = getDate(i);
+        lines.front().m_values[i] = getWeatherData(i);
+    }
+
+    lines.insert(lines.end(), overlays.begin(), overlays.end());
+
+    buildWeatherGraph(dates, lines, graphTitle);
+}
+
+
+// Draws lines of weather data (e.g. of several stations) in one graph with dates on the x-axis.
+void WeatherView::buildWeatherGraph(const std::vector<QDate>& dates, const std::vector<graphOverlay>& lines,
+                                    const QString& graphTitle)
+{
+    // Check if there is enough data to build the graph.
+    if(dates.size() < 3){
+        QMessageBox::information(nullptr, "Not enough data.", "Data is required to build the graph."
+                                " Please add 3 or more rows to the table and save it.", QMessageBox::Ok);
+        return;
+    }
+
+    // Create a new chart.
+    QChart* chart = new QChart();
+    chart->setTitle(graphTitle);
+    chart->setAnimationOptions(QChart::AllAnimations);
+
+    // The legend is needed only to tell several lines apart.
+    if(lines.size() < 2){
+        chart->legend()->hide();
+    }
+
+    // Create axis x for the dates.
+    QCategoryAxis *axisX = new QCategoryAxis();
+    axisX->setLabelsPosition(QCategoryAxis::AxisLabelsPositionOnValue);
+
+    // Append dates to the axis.
+    for(int i = 0; i < dates.size(); ++i){
+        QString date = QString::asprintf("%02d.%02d", dates[i].month(), dates[i].year());
+        axisX->append(date, i);
+    }
+
+    // Create axis y that fits the values of all the lines.
+    QValueAxis *axisY = new QValueAxis();
+    double minValue = 0, maxValue = 0;
+    bool isFirstValue = true;
+
+    chart->addAxis(axisX, Qt::AlignBottom);
+    chart->addAxis(axisY, Qt::AlignLeft);
+
+    // Create a line series for each line and add its points (a line with gaps is drawn through the days it has values for).
+    for(const graphOverlay& line : lines){
+        QLineSeries* series = new QLineSeries();
+        series->setName(line.m_name);
+
+        for(int i = 0; i < line.m_values.size(); ++i){
+            // Days without a value (NaN) are left out of the line.
+            if(std::isnan(line.m_values[i])){
+                continue;
+            }
+
+            int dayIndex = line.m_indexes.empty() ? line.m_firstIndex + i : line.m_indexes[i];
+            series->append(dayIndex, line.m_values[i]);
+
+            minValue = isFirstValue ? line.m_values[i] : std::min(minValue, line.m_values[i]);
+            maxValue = isFirstValue ? line.m_values[i] : std::max(maxValue, line.m_values[i]);
+            isFirstValue = false;
+        }
+
+        chart->addSeries(series);
+        series->attachAxis(axisX);
+        series->attachAxis(axisY);
+    }
+
+    axisY->setRange(minValue, maxValue);
+    axisY->applyNiceNumbers();
+
+    // Create a chart view and set rendering options.
+    QChartView *chartView = new QChartView(chart);
+    chartView->setRenderHint(QPainter::Antialiasing);
+
+    // Create a dialog to display the chart.
+    QDialog *dialog = new QDialog;
+    dialog->setMinimumSize(800, 500);
+
+    // Create a layout for the dialog and add the chart view to it.
+    QVBoxLayout *layout = new QVBoxLayout;
+    dialog->setLayout(layout);
+    layout->addWidget(chartView);
+
+    // Show the dialog.
+    dialog->exec();
+}
+
+
+// Finds the indixes of days in the view during which the wind direction did not change.
+std::vector<std::vector<unsigned>> WeatherView::findDaysWindNotChange(DayContinuity continuity) const
+{
+    // Periods within each continuous segment (indexes are shifted back to this view).
+    if (continuity == SplitAtGaps) {
+        std::vector<std::vector<unsigned>> windNotChangeArr;
+        CWeatherGaps gaps(*this);
+
+        for (const CWeatherGaps::daySegment& segment : gaps.getSegments()) {
+            for (std::vector<unsigned>& indexArr : getSubView(segment.m_firstIndex, segment.m_dayCount).findDaysWindNotChange()) {
+                for (unsigned& index : indexArr) {
+                    index += segment.m_firstIndex;
+                }
+                windNotChangeArr.push_back(std::move(indexArr));
+            }
+        }
+
+        return windNotChangeArr;
+    }
+
+    // Periods in the filled data (filled days are dropped from the result; a period needs 2 days of this view).
+    if (continuity == FillGaps) {
+        CWeatherGaps::filledWeather filled = CWeatherGaps::fillGaps(*this, CWeatherGaps::LinearFill);
+        std::vector<std::vector<unsigned>> windNotChangeArr;
+
+        for (const std::vector<unsigned>& filledIndexArr : filled.m_weather.findDaysWindNotChange()) {
+            std::vector<unsigned> indexArr;
+            for (unsigned index : filledIndexArr) {
+                if (filled.m_sourceIndexes[index] != -1) {
+                    indexArr.push_back(filled.m_sourceIndexes[index]);
+                }
+            }
+
+            if (indexArr.size() >= 2) {
+                windNotChangeArr.push_back(std::move(indexArr));
+            }
+        }
+
+        return windNotChangeArr;
+    }
+
+    // Runs of consecutive days (the rule is kept by the fused analysis).
+    CFusedAnalysis analysis(CFusedAnalysis::WindRunsAnalysis);
+    analysis.run(*this);
+
+    return analysis.getWindRuns();
+}
+
+
+// Calculate the average temperature of the viewed days.
+double WeatherView::getAvgTemperature() const
+{
+    // Variable to store the sum of temperature values.
+    double sum = 0;
+
+    // Calculate the sum of temperature values in the view.
+    for (int i = 0; i < size; ++i) {
+        sum += at(i).m_temperature;
+    }
+
+    // Calculate and return the average temperature rounded to two decimal places.
+    return roundToHundredths(sum / size);
+}
+
+
+// Calculate the average pressure of the viewed days.
+double WeatherView::getAvgPressure() const
+{
+    // Variable to store the sum of pressure values.
+    double sum = 0;
+
+    // Calculate the sum of pressure values in the view.
+    for (int i = 0; i < size; ++i) {
+        sum += at(i).m_pressure;
+    }
+
+    // Calculate and return the average pressure rounded to two decimal places.
+    return roundToHundredths(sum / size);
+}
+
+
+// Finds the days when the humidity is highest.
+std::vector<QDate> WeatherView::getHighestHumidityDays() const
+{
+    // Vector to store dates with the highest humidity.
+    std::vector<QDate> highestHumDaysArr;
+
+    // Variable to store the maximum humidity value.
+    int maxHumidity = 0;
+
+    // Find the maximum humidity value in the view.
+    for (int i = 0; i < size; ++i) {
+        if (at(i).m_humidity > maxHumidity) {
+            maxHumidity = at(i).m_humidity;
+        }
+    }
+
+    // Find dates with the highest humidity and add them to the vector.
+    for (int i = 0; i < size; ++i) {
+        if (at(i).m_humidity == maxHumidity) {
+            highestHumDaysArr.push_back(getDate(i));
+        }
+    }
+
+    return highestHumDaysArr;
+}
+
+
+// Finds periods when the temperature and pressure changed within certain percentages.
+std::vector<WeatherView> WeatherView::findPeriodTemperatureAndPressureChangeWithinRange(double tRangePct, double psreRangePct,
+                                                                                        DayContinuity continuity) const
+{
+    // Periods within each continuous segment.
+    if (continuity == SplitAtGaps) {
+        std::vector<WeatherView> periodsArr;
+        CWeatherGaps gaps(*this);
+
+        for (const CWeatherGaps::daySegment& segment : gaps.getSegments()) {
+            std::vector<WeatherView> segmentPeriods = getSubView(segment.m_firstIndex, segment.m_dayCount)
+                                                          .findPeriodTemperatureAndPressureChangeWithinRange(tRangePct, psreRangePct);
+            periodsArr.insert(periodsArr.end(), segmentPeriods.begin(), segmentPeriods.end());
+        }
+
+        return periodsArr;
+    }
+
+    // Periods in the filled data (the views keep the filled data alive).
+    if (continuity == FillGaps) {
+        return CWeatherGaps::fillGaps(*this, CWeatherGaps::LinearFill).m_weather
+            .findPeriodTemperatureAndPressureChangeWithinRange(tRangePct, psreRangePct);
+    }
+
+    // Periods of consecutive days (the rule is kept by the fused analysis).
+    CFusedAnalysis analysis(CFusedAnalysis::StablePeriodsAnalysis, tRangePct, psreRangePct);
+    analysis.run(*this);
+
+    return analysis.getStablePeriods();
+}
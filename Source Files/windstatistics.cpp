@@ -0,0 +1,227 @@
+#include "../Header Files/windstatistics.h"
+
+
+// Builds all the statistics in one pass over the days.
+CWindStatistics::CWindStatistics(const WeatherView& weather)
+{
+    // The direction of the current run, its length and the date of its last day.
+    int runDirection = 0, runLength = 0;
+    qint64 previousDate = 0;
+
+    // Ends the current run and adds it to the histogram of its direction.
+    auto closeRun = [this, &runDirection, &runLength]() {
+        if (runLength != 0) {
+            std::vector<int>& histogram = persistence[runDirection - 1];
+            if (histogram.size() <= runLength) {
+                histogram.resize(runLength + 1, 0);
+            }
+            histogram[runLength]++;
+        }
+        runLength = 0;
+    };
+
+    for (int i = 0; i < weather.getWeatherSize(); ++i)
+    {
+        const CWather::weatherData& wData = weather.at(i);
+        int direction = static_cast<int>(wData.m_windDirection);
+        QDate date(wData.m_year, wData.m_month, wData.m_day);
+
+        if (!date.isValid() || direction < 1 || direction > WIND_DIRECTION_CNT) {
+            closeRun();
+            continue;
+        }
+
+        monthRoses[date.month() - 1][direction - 1]++;
+
+        // The day continues the run (and makes a transition) only if it is the next calendar day.
+        qint64 ordinal = date.toJulianDay();
+        bool isNextDay = runLength != 0 && ordinal == previousDate + 1;
+
+        if (isNextDay) {
+            transitions[runDirection - 1][direction - 1]++;
+        }
+
+        if (!isNextDay || direction != runDirection) {
+            closeRun();
+            runDirection = direction;
+        }
+
+        runLength++;
+        previousDate = ordinal;
+    }
+
+    closeRun();
+}
+
+
+// Used to get the direction frequencies of a month.
+const CWindStatistics::windRose& CWindStatistics::getMonthRose(Month month) const
+{
+    return monthRoses[static_cast<int>(month) - 1];
+}
+
+
+// Used to get the direction frequencies of a season.
+CWindStatistics::windRose CWindStatistics::getSeasonRose(Season season) const
+{
+    windRose rose {};
+
+    for (int month = 1; month <= 12; ++month) {
+        if (getSeason(month) == season) {
+            for (int d = 0; d < WIND_DIRECTION_CNT; ++d) {
+                rose[d] += monthRoses[month - 1][d];
+            }
+        }
+    }
+
+    return rose;
+}
+
+
+// Used to get the direction frequencies of all the days.
+CWindStatistics::windRose CWindStatistics::getTotalRose() const
+{
+    windRose rose {};
+
+    for (const windRose& monthRose : monthRoses) {
+        for (int d = 0; d < WIND_DIRECTION_CNT; ++d) {
+            rose[d] += monthRose[d];
+        }
+    }
+
+    return rose;
+}
+
+
+// Used to get how long a direction lasted.
+const std::vector<int>& CWindStatistics::getPersistenceHistogram(WindDirection direction) const
+{
+    return persistence[static_cast<int>(direction) - 1];
+}
+
+
+// Used to get the average number of days a direction lasted.
+double CWindStatistics::getMeanPersistence(WindDirection direction) const
+{
+    const std::vector<int>& histogram = getPersistenceHistogram(direction);
+    long long runCount = 0, dayCount = 0;
+
+    for (int length = 1; length < histogram.size(); ++length) {
+        runCount += histogram[length];
+        dayCount += static_cast<long long>(histogram[length]) * length;
+    }
+
+    return runCount == 0 ? 0 : static_cast<double>(dayCount) / runCount;
+}
+
+
+// Used to get the number of times a direction was followed by a direction on the next day.
+int CWindStatistics::getTransitionCount(WindDirection from, WindDirection to) const
+{
+    return transitions[static_cast<int>(from) - 1][static_cast<int>(to) - 1];
+}
+
+
+// Used to get the probability that a direction is followed by a direction on the next day.
+double CWindStatistics::getTransitionProbability(WindDirection from, WindDirection to) const
+{
+    const windRose& row = transitions[static_cast<int>(from) - 1];
+    long long total = 0;
+
+    for (int count : row) {
+        total += count;
+    }
+
+    return total == 0 ? 0 : static_cast<double>(row[static_cast<int>(to) - 1]) / total;
+}
+
+
+// Draws the direction frequencies of every season and of the whole year on a polar chart.
+void CWindStatistics::buildWindRoseGraph(const QString& graphTitle) const
+{
+    // Directions in compass order, clockwise from the north (45 degrees apart).
+    const WindDirection compass[WIND_DIRECTION_CNT] = {North, Northeast, East, Southeast, South, Southwest, West, Northwest};
+
+    std::vector<std::pair<QString, windRose>> roses;
+    roses.emplace_back("Winter", getSeasonRose(Winter));
+    roses.emplace_back("Spring", getSeasonRose(Spring));
+    roses.emplace_back("Summer", getSeasonRose(Summer));
+    roses.emplace_back("Autumn", getSeasonRose(Autumn));
+    roses.emplace_back("Whole year", getTotalRose());
+
+    // Check if there is enough data to build the graph.
+    long long dayCount = 0;
+    for (int count : roses.back().second) {
+        dayCount += count;
+    }
+
+    if (dayCount == 0) {
+        QMessageBox::information(nullptr, "Not enough data.", "Data is required to build the graph."
+                                " Please add rows with wind directions to the table and save it.", QMessageBox::Ok);
+        return;
+    }
+
+    QPolarChart* chart = new QPolarChart();
+    chart->setTitle(graphTitle);
+
+    // The angular axis shows the directions, the radial axis shows the share of days.
+    QCategoryAxis* angularAxis = new QCategoryAxis();
+    angularAxis->setLabelsPosition(QCategoryAxis::AxisLabelsPositionOnValue);
+    for (int d = 1; d <= WIND_DIRECTION_CNT; ++d) {
+        angularAxis->append(convertWindDirToText(compass[d % WIND_DIRECTION_CNT]), d * 45);
+    }
+    angularAxis->setRange(0, 360);
+
+    QValueAxis* radialAxis = new QValueAxis();
+    radialAxis->setLabelFormat("%d%%");
+
+    chart->addAxis(angularAxis, QPolarChart::PolarOrientationAngular);
+    chart->addAxis(radialAxis, QPolarChart::PolarOrientationRadial);
+
+    double maxShare = 0;
+
+    // Each rose is a closed line through the shares of the directions.
+    for (const std::pair<QString, windRose>& rose : roses)
+    {
+        long long roseDayCount = 0;
+        for (int count : rose.second) {
+            roseDayCount += count;
+        }
+
+        if (roseDayCount == 0) {
+            continue;
+        }
+
+        QLineSeries* series = new QLineSeries();
+        series->setName(rose.first);
+
+        for (int d = 0; d <= WIND_DIRECTION_CNT; ++d) {
+            double share = 100.0 * rose.second[static_cast<int>(compass[d % WIND_DIRECTION_CNT]) - 1] / roseDayCount;
+            series->append(d * 45, share);
+            maxShare = std::max(maxShare, share);
+        }
+
+        chart->addSeries(series);
+        series->attachAxis(angularAxis);
+        series->attachAxis(radialAxis);
+    }
+
+    radialAxis->setRange(0, maxShare);
+    radialAxis->applyNiceNumbers();
+
+    // Create a chart view and set rendering options.
+    QChartView *chartView = new QChartView(chart);
+    chartView->setRenderHint(QPainter::Antialiasing);
+
+    // Create a dialog to display the chart.
+    QDialog *dialog = new QDialog;
+    dialog->setMinimumSize(600, 600);
+
+    // Create a layout for the dialog and add the chart view to it.
+    QVBoxLayout *layout = new QVBoxLayout;
+    dialog->setLayout(layout);
+    layout->addWidget(chartView);
+
+    // Show the dialog.
+    dialog->exec();
+}